@@ -32,7 +32,6 @@
 #include "Spans.h"
 
 float cycles_per_second;
-int curr_tabs;
 
 //==============================================================================
 // Basic data classes.
@@ -1073,6 +1072,10 @@ span_row::span_row()
 {
 	opaque_span_list = NULL;
 	transparent_span_list = NULL;
+	gaps = 0;
+	gap_list = NULL;
+	uncovered_pixels = 0;
+	full = false;
 }
 
 // Default destructor does nothing.
@@ -1081,6 +1084,24 @@ span_row::~span_row()
 {
 }
 
+// Method to clear the span row.  If gaps are being tracked, the whole row
+// becomes a single gap.
+
+void
+span_row::clear(int row_width)
+{
+	opaque_span_list = NULL;
+	transparent_span_list = NULL;
+	uncovered_pixels = row_width;
+	full = false;
+	if (gap_list) {
+		gaps = 1;
+		gap_list[0].start_sx = 0;
+		gap_list[0].end_sx = row_width;
+		gap_list[0].prev_span_ptr = NULL;
+	}
+}
+
 //------------------------------------------------------------------------------
 // Span buffer class.
 //------------------------------------------------------------------------------
@@ -1091,25 +1112,41 @@ span_buffer::span_buffer()
 {
 	rows = 0;
 	buffer_ptr = NULL;
+	max_gaps = 0;
+	gap_buffer_ptr = NULL;
 }
 
-// Default destructor deletes the span buffer.
+// Default destructor deletes the span buffer and the gap lists.
 
 span_buffer::~span_buffer()
 {
 	if (buffer_ptr)
 		DELARRAY(buffer_ptr, span_row, rows);
+	if (gap_buffer_ptr)
+		DELARRAY(gap_buffer_ptr, span_gap, rows * max_gaps);
 }
 
-// Method to create the span buffer with the given number of rows.
+// Method to create the span buffer with the given number of rows.  If the
+// maximum number of gaps per row is not zero, a gap list is also created for
+// each row.
 
 bool
-span_buffer::create_buffer(int set_rows)
+span_buffer::create_buffer(int set_rows, int set_max_gaps)
 {
+	int row;
+
 	rows = set_rows;
 	NEWARRAY(buffer_ptr, span_row, rows);
 	if (buffer_ptr == NULL)
 		return(false);
+	max_gaps = set_max_gaps;
+	if (max_gaps > 0) {
+		NEWARRAY(gap_buffer_ptr, span_gap, rows * max_gaps);
+		if (gap_buffer_ptr == NULL)
+			return(false);
+		for (row = 0; row < rows; row++)
+			buffer_ptr[row].gap_list = &gap_buffer_ptr[row * max_gaps];
+	}
 	return(true);
 }
 
@@ -1565,6 +1602,7 @@ light::light()
 	set_cone_angle(45.0f);
 	flood = false;
 	next_light_ptr = NULL;
+	prev_light_ptr = NULL;
 }
 
 // Default destructor does nothing.
@@ -1745,8 +1783,10 @@ sound::sound()
 	rolloff = 1.0f;
 	reflections = true;
 	in_range = false;
+	occluded = false;
 	played_once = false;
 	next_sound_ptr = NULL;
+	prev_sound_ptr = NULL;
 }
 
 // Default destructor deletes the sound buffer, if it exists.
@@ -1891,15 +1931,20 @@ entrance::choose_location(void)
 // Trigger class.
 //------------------------------------------------------------------------------
 
-// Default constructor initialises the trigger flag, action list and next
-// trigger pointer.
+// Default constructor initialises the trigger flag, frame last tested, ordinal,
+// timer heap position, action list and list pointers.
 
 trigger::trigger()
 {
 	trigger_flag = CLICK_ON;
+	frame_tested = 0;
+	ordinal = 0;
+	timer_heap_index = -1;
 	action_list = NULL;
 	square_ptr = NULL;
 	next_trigger_ptr = NULL;
+	prev_trigger_ptr = NULL;
+	next_owned_trigger_ptr = NULL;
 }
 
 // Default destructor deletes action list, if there is one.
@@ -2183,6 +2228,7 @@ popup::popup()
 	text_alignment = CENTRE;
 	imagemap_ptr = NULL;
 	next_popup_ptr = NULL;
+	prev_popup_ptr = NULL;
 	next_square_popup_ptr = NULL;
 }
 
@@ -2255,6 +2301,8 @@ polygon::polygon()
 	vertices = 0;
 	vertex_def_list = NULL;
 	side = false;
+	side_key = 0;
+	next_side_polygon_no = -1;
 	front_polygon_ref = 0;
 	rear_polygon_ref = 0;
 }
@@ -2393,6 +2441,55 @@ polygon::compute_normal_vector(vertex *vertex_list)
 				break;
 			}
 	}
+
+	// If this is a side polygon, compute it's hash key.
+
+	if (side)
+		compute_side_key(vertex_list);
+}
+
+// Method to compute the hash key of a side polygon.  The key is made from the
+// quantised coordinates of each vertex in the plane of the side, so that a
+// side polygon and the matching polygon on the opposite side of an adjacent
+// block get the same key.  The vertex hashes are summed so that the key does
+// not depend on the order of the vertices, which is reversed on the adjacent
+// polygon.  A vertex that rounds differently on each block only means the
+// polygons are not matched and remain active.
+
+void
+polygon::compute_side_key(vertex *vertex_list)
+{
+	vertex *vertex_ptr;
+	float u, v;
+	unsigned int hash;
+	int vertex_no;
+
+	side_key = vertices;
+	for (vertex_no = 0; vertex_no < vertices; vertex_no++) {
+		vertex_ptr = VERTEX_PTR(vertex_no);
+		switch (direction) {
+		case NORTH:
+		case SOUTH:
+			u = vertex_ptr->x;
+			v = vertex_ptr->y;
+			break;
+		case EAST:
+		case WEST:
+			u = vertex_ptr->y;
+			v = vertex_ptr->z;
+			break;
+		default:
+			u = vertex_ptr->x;
+			v = vertex_ptr->z;
+		}
+		hash = (unsigned int)(int)floor(u * SIDE_KEY_STEPS / UNITS_PER_BLOCK + 
+			0.5f) * 0x9e3779b1 + (unsigned int)(int)floor(v * SIDE_KEY_STEPS /
+			UNITS_PER_BLOCK + 0.5f);
+		hash ^= hash >> 15;
+		hash *= 0x85ebca6b;
+		hash ^= hash >> 13;
+		side_key += hash;
+	}
 }
 
 // Method to compute the plane offset, which is D in the polygon's plane 
@@ -2488,6 +2585,7 @@ polygon::operator=(const polygon &old_polygon)
 	plane_offset = old_polygon.plane_offset;
 	direction = old_polygon.direction;
 	side = old_polygon.side;
+	side_key = old_polygon.side_key;
 	front_polygon_ref = old_polygon.front_polygon_ref;
 	rear_polygon_ref = old_polygon.rear_polygon_ref;
 
@@ -2542,6 +2640,7 @@ block_def::block_def()
 	vertex_list = NULL;
 	polygons = 0;
 	polygon_list = NULL;
+	side_polygons_indexed = false;
 	light_ptr = NULL;
 	sound_ptr = NULL;
 	popup_ptr = NULL;
@@ -2559,6 +2658,9 @@ block_def::block_def()
 	sprite_size.height = 0;
 	solid = true;
 	movable = false;
+	col_mesh_ptr = NULL;
+	col_mesh_size = 0;
+	col_mesh_scale = 0.0f;
 	next_block_def_ptr = NULL;
 }	
 
@@ -2597,6 +2699,8 @@ block_def::~block_def()
 		DEL(free_block_list, block);
 		free_block_list = next_block_ptr;
 	}
+	if (col_mesh_ptr)
+		DELARRAY((colmeshbyte *)col_mesh_ptr, colmeshbyte, col_mesh_size);
 }
 
 // Methods to create vertex, part and polygon lists.
@@ -2627,6 +2731,7 @@ void
 block_def::create_polygon_list(int set_polygons)
 {
 	polygons = set_polygons;
+	side_polygons_indexed = false;
 	if (polygons > 0) {
 		NEWARRAY(polygon_list, polygon, polygons);
 		if (polygon_list == NULL)
@@ -2803,6 +2908,30 @@ block_def::orient_block_def(orientation block_orientation)
 		polygon_ptr->compute_normal_vector(vertex_list);
 		polygon_ptr->compute_plane_offset(vertex_list);
 	}
+	side_polygons_indexed = false;
+	col_mesh_scale = 0.0f;
+}
+
+// Method to build the hash table of side polygons, keyed on each polygon's
+// side key.
+
+void
+block_def::index_side_polygons(void)
+{
+	polygon *polygon_ptr;
+	int index, bucket;
+
+	for (bucket = 0; bucket < SIDE_POLYGON_BUCKETS; bucket++)
+		side_polygon_bucket[bucket] = -1;
+	for (index = polygons - 1; index >= 0; index--) {
+		polygon_ptr = &polygon_list[index];
+		if (polygon_ptr->side) {
+			bucket = polygon_ptr->side_key & (SIDE_POLYGON_BUCKETS - 1);
+			polygon_ptr->next_side_polygon_no = side_polygon_bucket[bucket];
+			side_polygon_bucket[bucket] = index;
+		}
+	}
+	side_polygons_indexed = true;
 }
 
 // Method to return a pointer to the next free block, or NULL if we are out of
@@ -2827,33 +2956,31 @@ block_def::new_block(void)
 		if (block_ptr == NULL)
 			return(NULL);
 
-		// Create the vertex list and polygon active list for this block.
+		// Create the polygon active list for this block.
 
-		if (!block_ptr->create_vertex_list(vertices) ||
-			!block_ptr->create_polygon_active_list(polygons)) {
+		if (!block_ptr->create_polygon_active_list(polygons)) {
 			DEL(block_ptr, block);
 			return(NULL);
 		}
 
-		// Create the collision mesh structure for this block.
+		// A structural block shares the vertex list and collision mesh of
+		// this block definition, so only the vertex count is needed.  A
+		// sprite has it's own vertex list and collision mesh, since these
+		// depend on the sprite's size and angle.
 
-		if (type == STRUCTURAL_BLOCK) {
-			if (!COL_createBlockColMesh(block_ptr, this)) {
-				DEL(block_ptr, block);
-				return(NULL);
-			}
-		} else {
-			if (!COL_createSpriteColMesh(block_ptr)) {
-				DEL(block_ptr, block);
-				return(NULL);
-			}
+		if (type == STRUCTURAL_BLOCK)
+			block_ptr->vertices = vertices;
+		else if (!block_ptr->create_vertex_list(vertices) ||
+			!COL_createSpriteColMesh(block_ptr)) {
+			DEL(block_ptr, block);
+			return(NULL);
 		}
 	}
 
 	// Initialise the polygon active list.
 
-	for (index = 0; index < polygons; index++)
-		block_ptr->polygon_active_list[index] = true;
+	for (index = 0; index < POLYGON_ACTIVE_WORDS(polygons); index++)
+		block_ptr->polygon_active_list[index] = 0xffffffff;
 
 	// Return the pointer to the block.
 
@@ -3157,20 +3284,26 @@ block::block()
 	polygon_active_list = NULL;
 	pixmap_index = 0;
 	col_mesh_ptr = NULL;
+	col_mesh_size = 0;
 	solid = true;
+	owned_trigger_list = NULL;
+	owned_light_ptr = NULL;
+	owned_sound_ptr = NULL;
+	owned_popup_ptr = NULL;
 	next_block_ptr = NULL;
 }
 
 // Default destructor deletes the vertex and polygon active lists, and the
-// collision mesh, if they exist.
+// collision mesh, if they exist and are not shared with the block definition.
 	
 block::~block()
 {
 	if (vertex_list)
 		DELARRAY(vertex_list, vertex, vertices);
 	if (polygon_active_list)
-		DELARRAY(polygon_active_list, bool, polygons);
-	if (col_mesh_ptr)
+		DELARRAY(polygon_active_list, unsigned int, 
+			POLYGON_ACTIVE_WORDS(polygons));
+	if (col_mesh_ptr && col_mesh_size > 0)
 		DELARRAY((colmeshbyte *)col_mesh_ptr, colmeshbyte, col_mesh_size);
 }
 
@@ -3188,14 +3321,15 @@ block::create_vertex_list(int set_vertices)
 	return(true);
 }
 
-// Method to create the polygon active list.
+// Method to create the polygon active list, which has one bit per polygon.
 
 bool
 block::create_polygon_active_list(int set_polygons)
 {
 	polygons = set_polygons;
 	if (polygons > 0) {
-		NEWARRAY(polygon_active_list, bool, polygons);
+		NEWARRAY(polygon_active_list, unsigned int, 
+			POLYGON_ACTIVE_WORDS(polygons));
 		if (polygon_active_list == NULL)
 			return(false);
 	}
@@ -3203,32 +3337,28 @@ block::create_polygon_active_list(int set_polygons)
 }
 
 //------------------------------------------------------------------------------
-// Square class.
+// Square info class.
 //------------------------------------------------------------------------------
 
 // Default constructor initialises all fields.
 
-square::square()
+square_info::square_info()
 {
-	block_symbol = NULL_BLOCK_SYMBOL;
-	block_ptr = NULL;
 	exit_ptr = NULL;
 	popup_trigger_flags = 0;
 	popup_list = NULL;
 	last_popup_ptr = NULL;
-	block_trigger_flags = 0;
 	square_trigger_flags = 0;
-	block_trigger_list = NULL;
 	square_trigger_list = NULL;
 	last_square_trigger_ptr = NULL;
 	sounds = 0;
+	entrances = 0;
 }
 
 // Default destructor deletes the exit and square trigger list, if they exist.
 
-square::~square()
+square_info::~square_info()
 {
-	block_def *block_def_ptr;
 	trigger *next_trigger_ptr;
 
 	// Delete the exit.
@@ -3240,6 +3370,40 @@ square::~square()
 			DEL(exit_ptr, hyperlink);
 	}
 
+	// Delete the square trigger list.
+
+	while (square_trigger_list) {
+		next_trigger_ptr = square_trigger_list->next_trigger_ptr;
+		DEL(square_trigger_list, trigger);
+		square_trigger_list = next_trigger_ptr;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Square class.
+//------------------------------------------------------------------------------
+
+// The empty square info object shared by all squares that have no info of 
+// their own.
+
+static square_info empty_square_info;
+
+// Default constructor initialises the block symbol and pointer, and points
+// the square at the empty square info.
+
+square::square()
+{
+	block_symbol = NULL_BLOCK_SYMBOL;
+	block_ptr = NULL;
+	info_ptr = &empty_square_info;
+}
+
+// Default destructor deletes the block and square info, if they exist.
+
+square::~square()
+{
+	block_def *block_def_ptr;
+
 	// Delete the block.
 
 	if (block_ptr) {
@@ -3247,13 +3411,24 @@ square::~square()
 		block_def_ptr->del_block(block_ptr);
 	}
 
-	// Delete the square trigger list.
+	// Delete the square info, unless it's the shared empty square info.
 
-	while (square_trigger_list) {
-		next_trigger_ptr = square_trigger_list->next_trigger_ptr;
-		DEL(square_trigger_list, trigger);
-		square_trigger_list = next_trigger_ptr;
+	if (info_ptr != &empty_square_info)
+		DEL(info_ptr, square_info);
+}
+
+// Method to return a pointer to square info that may be modified, creating it
+// if the square is still sharing the empty square info.
+
+square_info *
+square::get_info_ptr(void)
+{
+	if (info_ptr == &empty_square_info) {
+		NEW(info_ptr, square_info);
+		if (info_ptr == NULL)
+			memory_error("square info");
 	}
+	return(info_ptr);
 }
 
 //------------------------------------------------------------------------------
@@ -245,66 +245,79 @@ enum shape { RECT_SHAPE, CIRCLE_SHAPE };
 //==============================================================================
 
 extern float cycles_per_second;
-extern int curr_tabs;
 
-#ifdef PROFILE
+// Frame statistic class, which keeps the samples taken over the last
+// FRAME_STAT_WINDOW frames, so that percentiles can be computed from them.
+
+#define FRAME_STAT_WINDOW			256
+
+struct frame_stat {
+	const char *name;					// Name of statistic.
+	float sample_list[FRAME_STAT_WINDOW];	// Ring buffer of samples.
+	int samples;						// Total number of samples added.
+	frame_stat *next_frame_stat_ptr;	// Next statistic in list of all stats.
+
+	frame_stat(const char *set_name = NULL);
+	~frame_stat();
+	void reset(void);
+	void add_sample(float sample);
+	int window_samples(void);
+	float get_sample(int sample_no);
+	float mean(void);
+	float percentile(int percent);
+};
+
+// Profile sum class, which accumulates the time spent in a piece of code over
+// a frame, and keeps a histogram of the per-frame totals.  Bucket n of the
+// histogram counts frames where the total was between 2^n and 2^(n+1)
+// microseconds.
+
+#define PROFILE_HISTOGRAM_BUCKETS	16
+
+struct profile_sum {
+	const char *name;					// Name reported for this sum.
+	__int64 ticks;						// Ticks summed in current frame.
+	__int64 total_ticks;				// Ticks summed over all frames.
+	int frames;							// Number of frames summed.
+	int histogram[PROFILE_HISTOGRAM_BUCKETS];
+	frame_stat frame_ms;				// Milliseconds summed per frame.
+	profile_sum *next_profile_sum_ptr;	// Next sum in the list of all sums.
+
+	profile_sum();
+	~profile_sum();
+	void reset(void);
+	void end_frame(const char *message);
+};
+
+// START_TIMING and END_TIMING record a zone in the profile ring buffer, and
+// are cheap enough to leave enabled in release builds; the zones are exported
+// as a trace if profile export is enabled in the config file.  The sum macros
+// time code that runs many times per frame, such as each polygon, so they are
+// only compiled into PROFILE builds.
 
 #define START_TIMING \
-	curr_tabs++; \
-	int64 start_cycle, elapsed_cycles; \
-	__asm { \
-		__asm _emit 0x0f \
-		__asm _emit 0x31 \
-		__asm mov start_cycle.partial.low, eax \
-		__asm mov start_cycle.partial.high, edx \
-	}
+	__int64 zone_start_ticks = get_time_ticks()
 
 #define END_TIMING(message) \
-	__asm { \
-		__asm _emit 0x0f \
-		__asm _emit 0x31 \
-		__asm sub eax, start_cycle.partial.low \
-		__asm sbb edx, start_cycle.partial.high \
-		__asm mov elapsed_cycles.partial.low, eax \
-		__asm mov elapsed_cycles.partial.high, edx \
-	} \
-	diagnose(curr_tabs, "Time spent in %s was %I64d cycles (%g seconds)", \
-		message, elapsed_cycles.complete, \
-		(float)elapsed_cycles.complete / cycles_per_second); \
-	curr_tabs--
-
-#define DEFINE_SUM(sum_cycles) static int64 sum_cycles
-
-#define	CLEAR_SUM(sum_cycles) sum_cycles.complete = 0
+	record_profile_zone(message, zone_start_ticks, get_time_ticks())
+
+#ifdef PROFILE
+
+#define DEFINE_SUM(sum_cycles) static profile_sum sum_cycles
+
+#define	CLEAR_SUM(sum_cycles) sum_cycles.ticks = 0
 
 #define START_SUMMING \
-	int64 start_cycle; \
-	__asm { \
-		__asm _emit 0x0f \
-		__asm _emit 0x31 \
-		__asm mov start_cycle.partial.low, eax \
-		__asm mov start_cycle.partial.high, edx \
-	}
+	__int64 sum_start_ticks = get_time_ticks()
 
 #define END_SUMMING(sum_cycles) \
-	__asm { \
-		__asm _emit 0x0f \
-		__asm _emit 0x31 \
-		__asm sub eax, start_cycle.partial.low \
-		__asm sbb edx, start_cycle.partial.high \
-		__asm add sum_cycles.partial.low, eax \
-		__asm adc sum_cycles.partial.high, edx \
-	}
+	sum_cycles.ticks += get_time_ticks() - sum_start_ticks
 
 #define REPORT_SUM(message, sum_cycles) \
-	diagnose(curr_tabs, "Sum of time spent in %s was %I64d cycles (%g seconds)", \
-		message, sum_cycles.complete, \
-		(float)sum_cycles.complete / cycles_per_second);
+	sum_cycles.end_frame(message)
 
 #else // !PROFILE
 
-#define START_TIMING
-#define END_TIMING(message)
 #define DEFINE_SUM(sum_cycles)
 #define	CLEAR_SUM(sum_cycles)
 #define START_SUMMING
@@ -624,6 +637,9 @@ struct spolygon {
 	int max_spoints;				// Maximum number of screen points.
 	spoint *spoint_list;			// List of screen points.
 	float alpha;					// Translucency factor.
+	pixel colour_pixel;				// Colour pixel (software only).
+	int brightness_index;			// Brightness index (software only).
+	int start_sy, end_sy;			// Rows covered when binned.
 	spolygon *next_spolygon_ptr;	// Next screen polygon in list.
 	spolygon *next_spolygon_ptr2;	// Next screen polygon in secondary list.
 
@@ -666,6 +682,7 @@ struct span {
 	span_data start_span;				// Start values for span.
 	span_data delta_span;				// Delta values for span.
 	bool is_popup;						// TRUE if this span belongs to a popup.
+	bool is_background;					// TRUE if span is behind the scene.
 	pixmap *pixmap_ptr;					// Pixmap to render on span (or NULL).
 	pixel colour_pixel;					// Colour to render on span.
 	int brightness_index;				// Brightness index for span.
@@ -681,12 +698,26 @@ struct span {
 // Span buffer row element.
 //------------------------------------------------------------------------------
 
+// Span gap class, which is an interval of a span row that is not yet covered
+// by an opaque span.
+
+struct span_gap {
+	int start_sx;					// Start screen x coordinate of gap.
+	int end_sx;						// End screen x coordinate + 1 of gap.
+	span *prev_span_ptr;			// Opaque span to left of gap (or NULL).
+};
+
 struct span_row {
 	span *opaque_span_list;			// Opaque spans (sorted left to right).
 	span *transparent_span_list;	// Transparent spans (sorted back to front).
+	int gaps;						// Number of gaps in row.
+	span_gap *gap_list;				// Gaps (sorted left to right), or NULL.
+	int uncovered_pixels;			// Pixels not yet covered by opaque spans.
+	bool full;						// TRUE if row is covered by opaque spans.
 
 	span_row();
 	~span_row();
+	void clear(int row_width);
 };
 
 //------------------------------------------------------------------------------
@@ -696,10 +727,12 @@ struct span_row {
 struct span_buffer {
 	int rows;					// Number of span buffer rows.
 	span_row *buffer_ptr;		// Pointer to span buffer rows.
+	int max_gaps;				// Maximum number of gaps per row.
+	span_gap *gap_buffer_ptr;	// Pointer to gap lists for all rows.
 
 	span_buffer();
 	~span_buffer();
-	bool create_buffer(int set_rows);
+	bool create_buffer(int set_rows, int set_max_gaps);
 	span_row *operator[](int row);
 };
 
@@ -849,6 +882,7 @@ struct light {
 	float cone_angle_M;				// 1 / (1 - cosine of cone angle).
 	bool flood;						// TRUE if flood light (no light dropoff).
 	light *next_light_ptr;			// Pointer to next light in list.
+	light *prev_light_ptr;			// Pointer to previous light in list.
 
 	light();
 	~light();
@@ -901,8 +935,10 @@ struct sound {
 	float rolloff;					// Sound rolloff factor.
 	bool reflections;				// TRUE if reflections currently enabled.
 	bool in_range;					// TRUE if sound is in range.
+	bool occluded;					// TRUE if sound is hidden by a block.
 	bool played_once;				// TRUE if sound has been played once.
 	sound *next_sound_ptr;			// Next sound in list.
+	sound *prev_sound_ptr;			// Previous sound in list.
 
 	sound();
 	~sound();
@@ -967,18 +1003,36 @@ struct trigger {
 	vertex position;			// Position of trigger (for "step in/out").
 	float radius_squared;		// Radius squared of trigger (for "step in/out").
 	bool previously_inside;		// TRUE if player was previously inside radius.
+	int frame_tested;			// Frame trigger was last tested (for "step in/out").
+	int ordinal;				// Order trigger was added to global list.
 	delayrange delay_range;		// Range of timer delays allowed (for "timer").
 	int start_time_ms;			// Start time of delay (for "timer").
 	int delay_ms;				// Delay time (for "timer").
+	int timer_heap_index;		// Position in timer heap, or -1 (for "timer").
 	mapcoords target;			// Target location (for "location").
 	action *action_list;		// List of actions.
 	string label;				// Text for label (only used for "click on").
 	trigger *next_trigger_ptr;	// Next trigger in list.
+	trigger *prev_trigger_ptr;	// Previous trigger in global list.
+	trigger *next_owned_trigger_ptr;	// Next trigger owned by same block.
 
 	trigger();
 	~trigger();
 };
 
+//------------------------------------------------------------------------------
+// Trigger reference class, used to index the global trigger list.
+//------------------------------------------------------------------------------
+
+// Number of buckets in the trigger index (must be a power of two).
+
+#define TRIGGER_BUCKETS		1024
+
+struct trigger_ref {
+	trigger *trigger_ptr;				// Referenced trigger.
+	trigger_ref *next_trigger_ref_ptr;	// Next trigger reference in list.
+};
+
 //------------------------------------------------------------------------------
 // Hyperlink class.
 //------------------------------------------------------------------------------
@@ -1063,6 +1117,7 @@ struct popup {
 	int sx, sy;						// Current screen position.
 	int start_time_ms;				// Time popup was made visible.
 	popup *next_popup_ptr;			// Next popup in list.
+	popup *prev_popup_ptr;			// Previous popup in global list.
 	popup *next_square_popup_ptr;	// Next popup in square list.
 	popup *next_visible_popup_ptr;	// Next popup in visible list.
 
@@ -1124,6 +1179,13 @@ struct vertex_def {
 // Polygon class.
 //------------------------------------------------------------------------------
 
+// Number of buckets in a block definition's side polygon hash table (must be
+// a power of two), and the number of steps per block that side polygon
+// vertices are quantised to when computing their hash key.
+
+#define SIDE_POLYGON_BUCKETS	16
+#define SIDE_KEY_STEPS			1024
+
 struct polygon {
 	int part_no;					// Part number.
 	part *part_ptr;					// Pointer to part.
@@ -1134,6 +1196,8 @@ struct polygon {
 	float plane_offset;				// Offset in plane equation.
 	compass direction;				// Cardinal direction polygon is facing.
 	bool side;						// TRUE if this is a side polygon.
+	unsigned int side_key;			// Hash key of side polygon's vertices.
+	int next_side_polygon_no;		// Next side polygon in hash bucket.
 	int front_polygon_ref;			// Front polygon reference in BSP tree.
 	int rear_polygon_ref;			// Rear polygon reference in BSP tree.
 	polygon *next_polygon_ptr;		// Pointer to next polygon in list.
@@ -1143,6 +1207,7 @@ struct polygon {
 	bool create_vertex_def_list(int set_vertices);
 	void compute_centroid(vertex *vertex_list);
 	void compute_normal_vector(vertex *vertex_list);
+	void compute_side_key(vertex *vertex_list);
 	void compute_plane_offset(vertex *vertex_list);
 	void project_texture(vertex *vertex_list, compass projection);
 	polygon& operator=(const polygon &old_polygon);
@@ -1180,6 +1245,8 @@ struct block_def {
 	vertex *vertex_list;			// List of all vertices in block.
 	int polygons;					// Size of polygon list. 
 	polygon *polygon_list;			// List of all polygons in block.
+	bool side_polygons_indexed;		// TRUE if side polygon hash table built.
+	int side_polygon_bucket[SIDE_POLYGON_BUCKETS];	// Side polygon hash table.
 	light *light_ptr;				// Pointer to light (if any).
 	sound *sound_ptr;				// Pointer to sound (if any).
 	popup *popup_ptr;				// Pointer to popup (if any).
@@ -1197,6 +1264,9 @@ struct block_def {
 	size sprite_size;				// Sprite size (if applicable).
 	bool solid;						// TRUE if block is solid.
 	bool movable;					// TRUE is block is movable.
+	COL_MESH *col_mesh_ptr;			// Shared collision mesh (if any).
+	int col_mesh_size;				// Size of collision mesh in bytes.
+	float col_mesh_scale;			// Block scale collision mesh built for.
 	block_def *next_block_def_ptr;	// Pointer to next block def. in list.
 
 	block_def();
@@ -1206,6 +1276,7 @@ struct block_def {
 	void create_polygon_list(int set_polygons);
 	void dup_block_def(block_def *block_def_ptr);
 	void orient_block_def(orientation block_orientation);
+	void index_side_polygons(void);
 	block *new_block(void);
 	block *del_block(block *block_ptr);
 };
@@ -1293,21 +1364,36 @@ struct blockset_list {
 // Block class.
 //------------------------------------------------------------------------------
 
+// Macros to test, set and clear the flag for a polygon in a block's active
+// polygon bitset, and to compute the number of words in the bitset.
+
+#define POLYGON_ACTIVE_WORDS(polygons)	(((polygons) + 31) >> 5)
+#define POLYGON_ACTIVE(block_ptr, n) \
+	(((block_ptr)->polygon_active_list[(n) >> 5] & (1u << ((n) & 31))) != 0)
+#define SET_POLYGON_ACTIVE(block_ptr, n) \
+	(block_ptr)->polygon_active_list[(n) >> 5] |= 1u << ((n) & 31)
+#define CLEAR_POLYGON_ACTIVE(block_ptr, n) \
+	(block_ptr)->polygon_active_list[(n) >> 5] &= ~(1u << ((n) & 31))
+
 struct block {
 	block_def *block_def_ptr;		// Pointer to block definition.
 	vertex translation;				// Translation of block in world space.
-	int vertices;					// Size of vertex list.
-	vertex *vertex_list;			// List of all vertices in block.
+	int vertices;					// Number of vertices in block.
+	vertex *vertex_list;			// List of vertices (sprites only).
 	int polygons;					// Size of polygon list. 
 	polygon *polygon_list;			// List of all polygons in block.
-	bool *polygon_active_list;		// Flags showing which polygons are active.
+	unsigned int *polygon_active_list;	// Bitset of active polygons.
 	float sprite_angle;				// Angle of sprite (if applicable).
 	int start_time_ms;				// Time block was placed on map.
 	int last_time_ms;				// Time of last sprite rotational change.
 	int pixmap_index;				// Sprite pixmap index (if applicable).
 	bool solid;						// TRUE if block is solid.
 	COL_MESH *col_mesh_ptr;			// Pointer to the collision mesh.
-	int col_mesh_size;				// Size of collision mesh in bytes.
+	int col_mesh_size;				// Size of collision mesh (0 if shared).
+	trigger *owned_trigger_list;	// Global triggers owned by block.
+	light *owned_light_ptr;			// Global light owned by block (if any).
+	sound *owned_sound_ptr;			// Global sound owned by block (if any).
+	popup *owned_popup_ptr;			// Global popup owned by block (if any).
 	block *next_block_ptr;			// Pointer to next block in list.
 
 	block();
@@ -1320,22 +1406,41 @@ struct block {
 // Square class.
 //------------------------------------------------------------------------------
 
-struct square {
-	word block_symbol;					// Block symbol.
-	block *block_ptr;					// Pointer to block (if any).
+// The square info class holds the data that only a few squares on a map have.
+// Squares that have none of this data share a single empty square info 
+// object, which must never be modified.
+
+struct square_info {
 	hyperlink *exit_ptr;				// Pointer to exit (if any).
 	int popup_trigger_flags;			// Popup trigger flags.
 	popup *popup_list;					// List of popups (if any).
 	popup *last_popup_ptr;				// Last popup in the list.
-	int block_trigger_flags;			// Block trigger flags.
 	int square_trigger_flags;			// Square trigger flags.
-	trigger *block_trigger_list;		// List of block triggers (if any).
 	trigger *square_trigger_list;		// List of square triggers (if any).
 	trigger *last_square_trigger_ptr;	// Last square trigger in list.
 	int sounds;							// Sounds on this square.
+	int entrances;						// Entrance locations on this square.
+
+	square_info();
+	~square_info();
+};
+
+// Macros to return the trigger flags and trigger list of the block on a
+// square, which are those of the block's definition.
+
+#define BLOCK_TRIGGER_FLAGS(square_ptr) ((square_ptr)->block_ptr ? \
+	(square_ptr)->block_ptr->block_def_ptr->trigger_flags : 0)
+#define BLOCK_TRIGGER_LIST(square_ptr) ((square_ptr)->block_ptr ? \
+	(square_ptr)->block_ptr->block_def_ptr->trigger_list : NULL)
+
+struct square {
+	word block_symbol;					// Block symbol.
+	block *block_ptr;					// Pointer to block (if any).
+	square_info *info_ptr;				// Pointer to square info.
 
 	square();
 	~square();
+	square_info *get_info_ptr(void);
 };
 
 //------------------------------------------------------------------------------
@@ -45,11 +45,7 @@
 
 --------------------------------------------------------------*/
 
-int			COL_polyCollidedWith[MAX_COLLISION_POLYS],
-			COL_numCollisions;
-COL_MESH	*COL_polysetCollidedWith[MAX_COLLISION_POLYS];
-VEC3		*COL_collidedMeshOffs[MAX_COLLISION_POLYS],
-			g_rayGoingDown = {0, -1, 0};
+VEC3		g_rayGoingDown = {0, -1, 0};
 
 
 /*--------------------------------------------------------------
@@ -259,115 +255,6 @@ COL_isIntersectingPOI(VEC3 *rayOrigin_p, VEC3 *rayDir_p,
 }
 
 
-/*--------------------------------------------------------------
-
-	Check if a ray passes through a poly, and if it does,
-	compute the intersection co-ordinates (Point Of Intersection)
-
-	This version does not do the dot product - that is passed
-	into the function instead.
-
---------------------------------------------------------------*/
-
-bool	COL_isIntersectingPOI(VEC3 *rayOrigin_p, VEC3 *rayDir_p,
-							  COL_MESH *colMesh_p, int polyNum, VEC3 *poi_p,
-							  float s)
-{
-	float		t,
-				pz, py;
-	bool		res;
-	VEC3		*v0_p,
-				*e0_p, *e1_p, *e2_p;
-	COL_POLY3	*poly_p;
-	
-
-	//------ This at the polygon in question -------------------
-
-	poly_p = &colMesh_p->p[polyNum];
-
-
-	//------ Point this at vertex 0 ----------------------------
-
-	v0_p = &colMesh_p->v[colMesh_p->p[polyNum].vIdx[0]];
-
-
-	//------ Perpendicular distance of start of the ray --------
-	//------ to the plane --------------------------------------
-
-	t = (v0_p->x-rayOrigin_p->x) * poly_p->normal.x + 
-		(v0_p->y-rayOrigin_p->y) * poly_p->normal.y + 
-		(v0_p->z-rayOrigin_p->z) * poly_p->normal.z;
-
-	
-	//------ Drop out if the ray travels away from the plane ----
-	//------ normal, or the ray does not reach the plane --------
-
-	if (t > 0 || t <= s || s == 0) 
-		return NON_INTERSECTING;
-
-
-	t /= s;
-
-
-	//------ Get the edge pointers -----------------------------
-
-	e0_p = &colMesh_p->e[poly_p->edgeIdx[0]];
-	e1_p = &colMesh_p->e[poly_p->edgeIdx[1]];
-	e2_p = &colMesh_p->e[poly_p->edgeIdx[2]];
-		
-
-	//------ And now, depending on which is the dominant -------
-	//------ axis of the polygon, do a 2D containment test -----
-
-	switch (poly_p->normalMajorAxis)
-	{
-	case COL_MAJOR_X:
-		poi_p->y = (rayDir_p->y*t) + rayOrigin_p->y;
-		poi_p->z = (rayDir_p->z*t) + rayOrigin_p->z;
-
-		s = poi_p->y - v0_p->y;
-		pz = poi_p->z - v0_p->z;
-
-		if (!(CONTAINEDX3(e0_p, e1_p, e2_p, s, pz, res)))
-			return(NON_INTERSECTING);
-
-		poi_p->x = (rayDir_p->x*t) + rayOrigin_p->x;
-		return(INTERSECTING);
-		break;
-
-	case COL_MAJOR_Y:
-		poi_p->x = (rayDir_p->x*t) + rayOrigin_p->x;
-		poi_p->z = (rayDir_p->z*t) + rayOrigin_p->z;
-
-		s = poi_p->x - v0_p->x;
-		pz = poi_p->z - v0_p->z;
-			
-		if (!CONTAINEDY3(e0_p, e1_p, e2_p, s, pz, res))
-			return(NON_INTERSECTING);
-
-		poi_p->y = (rayDir_p->y*t) + rayOrigin_p->y;
-		return(INTERSECTING);
-		break;
-
-	case COL_MAJOR_Z:
-		poi_p->x = (rayDir_p->x*t) + rayOrigin_p->x;
-		poi_p->y = (rayDir_p->y*t) + rayOrigin_p->y;
-
-		s = poi_p->x - v0_p->x;
-		py = poi_p->y - v0_p->y;
-			
-		if (!(CONTAINEDZ3(e0_p, e1_p, e2_p, s, py, res)))
-			return(NON_INTERSECTING);
-
-		poi_p->z = (rayDir_p->z*t) + rayOrigin_p->z;
-		return(INTERSECTING);
-		break;
-	}
-
-	return(NON_INTERSECTING);
-}
-
-
 /*--------------------------------------------------------------
 
 	See if an Axis-Aligned box is intersecting a polygon
@@ -687,154 +574,178 @@ bool	COL_checkAABoxAgainstMesh(COL_MESH *colMesh_p, VEC3 *meshOffs_p,
 
 /*--------------------------------------------------------------
 
-	Check whether a Axis Aligned bounding box has collided 
-	with a shape structure. Return TRUE if it has
+	Group the polys of a collision mesh into packets of four.
+	Lanes past the last poly are given an inside-out bounding
+	box, so that they never overlap anything.
 
 --------------------------------------------------------------*/
 
-bool	COL_checkMeshCollision(COL_MESH *colMesh_p, VEC3 *meshOffs_p,
-								float x, float y, float z,
-								float oldX, float oldY, float oldZ,
-								COL_AABOX *aaBox_p, VEC3 *boxCentre_p)
+void	COL_buildPackets(COL_MESH *colMesh_p)
 {
-	bool	collided;
-	int		i;
-	VEC3	movementVec;
+	int			i, j, k, lane;
+	VEC3		*v_p, *e_p;
+	COL_POLY3	*poly_p;
+	COL_PACKET4	*pk_p;
 
-   	movementVec.x = x - oldX;
-	movementVec.y = y - oldY;
-	movementVec.z = z - oldZ;
-	VEC_normalise(&movementVec);
 
-	collided = false;
-	for (i=0; i<colMesh_p->numPolys; i++)
+	for (k=0; k<colMesh_p->numPackets; k++)
 	{
-		//------ Check the movement vector against the ---------
-		//------ normal of the poly...if it's single-sided and -
-		//------ facing away from us, ignore it ----------------
+		pk_p = &colMesh_p->pk[k];
+
+		pk_p->upMask = 0;
+		pk_p->shadowMask = 0;
 
-		if (colMesh_p->p[i].double_sided ||
-			VEC_dot(&colMesh_p->p[i].normal, &movementVec) < 0)
+		for (lane=0; lane<COL_PACKET_SIZE; lane++)
 		{
-			if (COL_isIntersecting(colMesh_p, meshOffs_p, i, aaBox_p,
-				boxCentre_p))
+			i = k * COL_PACKET_SIZE + lane;
+
+			if (i >= colMesh_p->numPolys)
 			{
-				collided = true;
-				if (COL_numCollisions != MAX_COLLISION_POLYS) {
-					COL_polyCollidedWith[COL_numCollisions] = i;
-					COL_polysetCollidedWith[COL_numCollisions] = colMesh_p;
-					COL_collidedMeshOffs[COL_numCollisions] = meshOffs_p;
-					COL_numCollisions++;
+				pk_p->minX[lane] = 999999.0f;
+				pk_p->minY[lane] = 999999.0f;
+				pk_p->minZ[lane] = 999999.0f;
+				pk_p->maxX[lane] = -999999.0f;
+				pk_p->maxY[lane] = -999999.0f;
+				pk_p->maxZ[lane] = -999999.0f;
+
+				for (j=0; j<3; j++)
+				{
+					pk_p->ax[j][lane] = 0;
+					pk_p->az[j][lane] = 0;
+					pk_p->ex[j][lane] = 0;
+					pk_p->ez[j][lane] = 0;
 				}
+
+				pk_p->nx[lane] = 0;
+				pk_p->nz[lane] = 0;
+				pk_p->invNy[lane] = 0;
+				pk_p->d[lane] = 0;
+				continue;
 			}
-		}
-	}
-	return(collided);
-}
 
+			poly_p = &colMesh_p->p[i];
 
-/*--------------------------------------------------------------
 
-	Check whether a Axis Aligned bounding box has collided 
-	with the polys that have already been collided with.
-	Return TRUE if it has.
+			//------ Bounding box --------------------------------
 
---------------------------------------------------------------*/
+			pk_p->minX[lane] = poly_p->min.x;
+			pk_p->minY[lane] = poly_p->min.y;
+			pk_p->minZ[lane] = poly_p->min.z;
+			pk_p->maxX[lane] = poly_p->max.x;
+			pk_p->maxY[lane] = poly_p->max.y;
+			pk_p->maxZ[lane] = poly_p->max.z;
 
-bool	
-COL_checkCollidedPolys(float x, float y, float z,
-					   float oldX, float oldY, float oldZ,
-					   COL_AABOX *aaBox_p, VEC3 *boxCentre_p)
-{
-	int		i;
-	VEC3	movementVec;
 
+			//------ Edges projected onto the XZ plane -----------
+
+			for (j=0; j<3; j++)
+			{
+				v_p = &colMesh_p->v[poly_p->vIdx[j]];
+				e_p = &colMesh_p->e[poly_p->edgeIdx[j]];
 
-   	movementVec.x = x - oldX;
-	movementVec.y = y - oldY;
-	movementVec.z = z - oldZ;
-	VEC_normalise(&movementVec);
+				pk_p->ax[j][lane] = v_p->x;
+				pk_p->az[j][lane] = v_p->z;
+				pk_p->ex[j][lane] = e_p->x;
+				pk_p->ez[j][lane] = e_p->z;
+			}
 
-	for (i=0; i<COL_numCollisions; i++)
-	{
-		//------ Check the movement vector against the ---------
-		//------ normal of the poly... if it's facing ----------
-		//------ away from us, ignore it -----------------------
 
-		if (COL_isIntersecting(COL_polysetCollidedWith[i], 
-			COL_collidedMeshOffs[i], COL_polyCollidedWith[i], aaBox_p, 
-			boxCentre_p))
-		{
-			return(true);
+			//------ Plane equation, solved for Y ----------------
+
+			v_p = &colMesh_p->v[poly_p->vIdx[0]];
+
+			pk_p->nx[lane] = poly_p->normal.x;
+			pk_p->nz[lane] = poly_p->normal.z;
+			pk_p->d[lane] = VEC_dot(&poly_p->normal, v_p);
+
+			if (poly_p->normal.y > 0)
+			{
+				pk_p->invNy[lane] = 1.0f / poly_p->normal.y;
+				pk_p->upMask |= 1 << lane;
+			}
+			else
+				pk_p->invNy[lane] = 0;
+
+
+			//------ Single-sided polys facing downwards can't ---
+			//------ cast a shadow -------------------------------
+
+			if (poly_p->double_sided || poly_p->normal.y > 0)
+				pk_p->shadowMask |= 1 << lane;
 		}
 	}
-
-	return(false);
 }
 
 
 /*--------------------------------------------------------------
 
-	Return the sum of all normals of the polys that have
-	been collided with.
-
-	The Y component of the normal is zeroed out because
-	we are only interested in a 2D reaction - the up and down
-	movement comes from gravity checks.
+	Check an AA box, given by it's corners, against the
+	bounding boxes of a packet of polys.  Returns a mask with
+	a bit set for every poly that it overlaps.
 
 --------------------------------------------------------------*/
 
-void	COL_getReactionNormal(VEC3 *res_p)
+int		COL_aaboxAgainstPacket(COL_PACKET4 *pk_p, VEC3 *min_p, VEC3 *max_p)
 {
-	int		i;
-	float	oneOverNumCol;
-
+	int		lane, mask;
 
-	VEC_set(res_p, 0, 0, 0);
 
-	if (COL_numCollisions == 0)
-		return;
-
-
-	for (i=0; i<COL_numCollisions; i++)
+	mask = 0;
+	for (lane=0; lane<COL_PACKET_SIZE; lane++)
 	{
-		VEC_add(&COL_polysetCollidedWith[i]->p[COL_polyCollidedWith[i]].normal,
-			res_p, res_p);
+		mask |= ((max_p->x >= pk_p->minX[lane]) &
+				 (min_p->x <= pk_p->maxX[lane]) &
+				 (max_p->y >= pk_p->minY[lane]) &
+				 (min_p->y <= pk_p->maxY[lane]) &
+				 (max_p->z >= pk_p->minZ[lane]) &
+				 (min_p->z <= pk_p->maxZ[lane])) << lane;
 	}
 
-	oneOverNumCol = (float)1/COL_numCollisions;
-	res_p->x *= oneOverNumCol;
-	res_p->y = 0.0;
-	res_p->z *= oneOverNumCol;
-
-	VEC_normalise(res_p);
+	return(mask);
 }
 
 
 /*--------------------------------------------------------------
 
-	Return the normal of one of the collided polys
-
-	The Y component of the normal is zeroed out because
-	we are only interested in a 2D reaction - the up and down
-	movement comes from gravity checks.
+	Check a ray going straight down against a packet of
+	upward facing polys.  Returns a mask with a bit set for
+	every poly that it passes through, and the height at
+	which it passes through each of them.
 
 --------------------------------------------------------------*/
 
-void	COL_getCollidedNormal(int collidedNum, VEC3 *res_p)
+int		COL_rayDownAgainstPacket(COL_PACKET4 *pk_p, VEC3 *start_p,
+								 float *hitY_p)
 {
-	int			i;
-	COL_MESH	*colMesh_p;
+	int		lane, mask;
+	float	f0, f1, f2;
+
+
+	mask = 0;
+	for (lane=0; lane<COL_PACKET_SIZE; lane++)
+	{
+		//------ Which side of each edge the ray is on -----
+
+		f0 = pk_p->ex[0][lane] * (start_p->z - pk_p->az[0][lane]) -
+			 pk_p->ez[0][lane] * (start_p->x - pk_p->ax[0][lane]);
+		f1 = pk_p->ex[1][lane] * (start_p->z - pk_p->az[1][lane]) -
+			 pk_p->ez[1][lane] * (start_p->x - pk_p->ax[1][lane]);
+		f2 = pk_p->ex[2][lane] * (start_p->z - pk_p->az[2][lane]) -
+			 pk_p->ez[2][lane] * (start_p->x - pk_p->ax[2][lane]);
 
-	colMesh_p = COL_polysetCollidedWith[collidedNum];
-	i = COL_polyCollidedWith[collidedNum];
 
-	res_p->x = colMesh_p->p[i].normal.x;
-	res_p->y = 0.0;
-	res_p->z = colMesh_p->p[i].normal.z;
+		//------ Height of the plane beneath the ray -------
 
-	VEC_normalise(res_p);
-}	
+		hitY_p[lane] = (pk_p->d[lane] - pk_p->nx[lane] * start_p->x -
+			pk_p->nz[lane] * start_p->z) * pk_p->invNy[lane];
+
+		mask |= ((((f0 >= 0) & (f1 >= 0) & (f2 >= 0)) |
+				  ((f0 <= 0) & (f1 <= 0) & (f2 <= 0))) &
+				 (hitY_p[lane] <= start_p->y)) << lane;
+	}
+
+	return(mask & pk_p->upMask);
+}
 
 
 /*--------------------------------------------------------------
@@ -874,87 +785,36 @@ COL_rayAgainstPoly(VEC3 *startRay_p, COL_MESH *colMesh_p,
 
 /*--------------------------------------------------------------
 
-	Check a polygon against an AA box, and return the point
-	of intersection.
+	Check the edges of a polygon against an AA box, and return
+	the height of the highest point of intersection that isn't
+	higher than the maximum step height, or -1 if there isn't
+	one.  This catches what the rays from the corners of the
+	box miss.
 
 --------------------------------------------------------------*/
 
-float		COL_aaboxAndRaysAgainstPoly(VEC3 *rays_p, COL_MESH *colMesh_p,
-									 VEC3 *pos_p, int polyNum, VEC3 *poi_p,
-									 COL_AABOX *aaBox_p, VEC3 *centre_p,
-									 float y, float maxStepHeight)
+float		COL_aaboxAgainstPolyEdges(COL_MESH *colMesh_p, VEC3 *pos_p,
+									  int polyNum, VEC3 *poi_p,
+									  COL_AABOX *aaBox_p, VEC3 *centre_p,
+									  float y, float maxStepHeight)
 {
 	int			i, j;
-	float		s, nearestY, stepHeight,
+	float		nearestY, stepHeight,
 				boxMaxX, boxMaxY, boxMaxZ,
 				boxMinX, boxMinZ;
 	COL_POLY3	*poly_p;
-	VEC3		newRay, *startRay_p;
 	COL_RAY		ray;
 
 
-	//------ Get the pointer to the poly -----------------------
-
 	poly_p = &colMesh_p->p[polyNum];
 
-
 	nearestY = -1;
 
-
-	//------ Check if the vector travels away from the poly ----
-	//------ or if they are co-planar. -------------------------
-
-  	g_rayGoingDown.y = -(rays_p[0].y+0.5f);
-	s = VEC_dot(&g_rayGoingDown, &poly_p->normal);
-	if (!poly_p->double_sided && s >= 0)	
-		return(-1);
-
-
-	//------ See if the AA box is anywhere near the poly -------
-
-	if (((boxMaxX = centre_p->x+aaBox_p->maxDim.x) < (poly_p->min.x + pos_p->x)) || 
-		((boxMinX = centre_p->x-aaBox_p->maxDim.x) > (poly_p->max.x + pos_p->x)) || 
-		((boxMaxZ = centre_p->z+aaBox_p->maxDim.z) < (poly_p->min.z + pos_p->z)) || 
-		((boxMinZ = centre_p->z-aaBox_p->maxDim.z) > (poly_p->max.z + pos_p->z)) || 
-		((boxMaxY = centre_p->y+aaBox_p->maxDim.y) < (poly_p->min.y + pos_p->y)))
-		return(-1);
-		
-
-	//------ Now check the rays --------------------------------
-
-  	for (i=0; i<4; i++)
-	{
-		startRay_p = (VEC3 *)&rays_p[i];
-
-
-		if ((startRay_p->x < (poly_p->min.x + pos_p->x)) || 
-			(startRay_p->x > (poly_p->max.x + pos_p->x)) ||
-			(startRay_p->z < (poly_p->min.z + pos_p->z)) || 
-			(startRay_p->z > (poly_p->max.z + pos_p->z)) ||
-			(startRay_p->y < (poly_p->min.y + pos_p->y)))
-		{
-		}
-		else
-		{
-			newRay.x = startRay_p->x - pos_p->x;
-			newRay.y = startRay_p->y - pos_p->y;
-			newRay.z = startRay_p->z - pos_p->z;
-
-			if (COL_isIntersectingPOI(&newRay, &g_rayGoingDown, colMesh_p,
-				polyNum, poi_p, s))
-			{
-				poi_p->y += pos_p->y;
-
-				stepHeight = poi_p->y - y;
-				if (stepHeight < maxStepHeight && poi_p->y > nearestY)
-					nearestY = poi_p->y;
-			}
-		}
-	}
-
-
-	//------ Now see if we're colliding at a point the rays ----
-	//------ didn't detect -------------------------------------
+	boxMaxX = centre_p->x+aaBox_p->maxDim.x;
+	boxMinX = centre_p->x-aaBox_p->maxDim.x;
+	boxMaxY = centre_p->y+aaBox_p->maxDim.y;
+	boxMaxZ = centre_p->z+aaBox_p->maxDim.z;
+	boxMinZ = centre_p->z-aaBox_p->maxDim.z;
 
 	i = 0;
 	while (i<3)
@@ -1014,6 +874,92 @@ float		COL_aaboxAndRaysAgainstPoly(VEC3 *rays_p, COL_MESH *colMesh_p,
 }
 
 
+/*--------------------------------------------------------------
+
+	Check a packet of polygons against an AA box and the rays
+	going down from it's top corners, and return the height
+	of the highest point of intersection that isn't higher
+	than the maximum step height, or -1 if there isn't one.
+
+--------------------------------------------------------------*/
+
+float		COL_aaboxAndRaysAgainstPacket(VEC3 *rays_p, COL_MESH *colMesh_p,
+										  VEC3 *pos_p, int packetNum,
+										  VEC3 *poi_p, COL_AABOX *aaBox_p,
+										  VEC3 *centre_p, float y,
+										  float maxStepHeight)
+{
+	int			i, lane,
+				mask, hitMask;
+	float		nearestY, highestY, stepHeight,
+				hitY[COL_PACKET_SIZE];
+	VEC3		newRay,
+				boxMin, boxMax;
+	COL_PACKET4	*pk_p;
+
+
+	pk_p = &colMesh_p->pk[packetNum];
+
+	nearestY = -1;
+
+
+	//------ See which polys the AA box is anywhere near -------
+	//------ Anything below the box still casts a shadow -------
+
+	boxMin.x = centre_p->x - aaBox_p->maxDim.x - pos_p->x;
+	boxMin.y = -999999.0f;
+	boxMin.z = centre_p->z - aaBox_p->maxDim.z - pos_p->z;
+	boxMax.x = centre_p->x + aaBox_p->maxDim.x - pos_p->x;
+	boxMax.y = centre_p->y + aaBox_p->maxDim.y - pos_p->y;
+	boxMax.z = centre_p->z + aaBox_p->maxDim.z - pos_p->z;
+
+	mask = COL_aaboxAgainstPacket(pk_p, &boxMin, &boxMax) & pk_p->shadowMask;
+	if (!mask)
+		return(-1);
+
+
+	//------ Now check each ray against the whole packet -------
+
+  	for (i=0; i<4; i++)
+	{
+		VEC_sub(&rays_p[i], pos_p, &newRay);
+
+		hitMask = COL_rayDownAgainstPacket(pk_p, &newRay, hitY) & mask;
+
+		for (lane=0; hitMask; lane++, hitMask >>= 1)
+		{
+			if (!(hitMask & 1))
+				continue;
+
+			hitY[lane] += pos_p->y;
+
+			stepHeight = hitY[lane] - y;
+			if (stepHeight < maxStepHeight && hitY[lane] > nearestY)
+				nearestY = hitY[lane];
+		}
+	}
+
+
+	//------ Now see if we're colliding at a point the rays ----
+	//------ didn't detect -------------------------------------
+
+	for (lane=0; mask; lane++, mask >>= 1)
+	{
+		if (!(mask & 1))
+			continue;
+
+		highestY = COL_aaboxAgainstPolyEdges(colMesh_p, pos_p,
+			packetNum * COL_PACKET_SIZE + lane, poi_p, aaBox_p, centre_p, y,
+			maxStepHeight);
+
+		if (highestY > nearestY)
+			nearestY = highestY;
+	}
+
+	return(nearestY);
+}
+
+
 /*--------------------------------------------------------------
 
 	Find the highest shadow point beneath the top of the 
@@ -1091,10 +1037,10 @@ float	COL_getShadowHeight(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
 		if (COL_checkAABoxAgainstMesh(colMesh_p, &pos_p[j], &downBox,
 			&centreDownBox))
 		{
-			for (i=0; i<colMesh_p->numPolys; i++)
+			for (i=0; i<colMesh_p->numPackets; i++)
 			{
-				highestY = COL_aaboxAndRaysAgainstPoly((VEC3 *)&ray, colMesh_p,
-					&pos_p[j], i, &poi, &downBox, &centreDownBox, 
+				highestY = COL_aaboxAndRaysAgainstPacket((VEC3 *)&ray, 
+					colMesh_p, &pos_p[j], i, &poi, &downBox, &centreDownBox, 
 					y, maxStepHeight);
 
 				if (highestY > nearestY)
@@ -1109,255 +1055,604 @@ float	COL_getShadowHeight(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
 
 /*--------------------------------------------------------------
 
-	Check collision against multiple collision meshes,
-	calculate a reaction, and return the new position
+	Project a poly and a moving Axis Aligned box onto a
+	separating axis, and narrow the interval of the movement
+	during which they overlap.  Returns FALSE if the axis
+	separates them for the whole movement.
 
 --------------------------------------------------------------*/
 
-void	COL_checkCollisions(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
-							float *x, float *y, float *z,
-							float oldX, float oldY, float oldZ,
-							float *shadowHeight,
-							float maxStepHeight,
-							COL_AABOX *aaBox_p)
+static bool
+COL_sweepAxis(VEC3 *axis_p, VEC3 *v0_p, VEC3 *v1_p, VEC3 *v2_p,
+			  VEC3 *boxPos_p, VEC3 *move_p, COL_AABOX *aaBox_p,
+			  float *tFirst_p, float *tLast_p)
 {
-	int			i, 
-				colliding, collided,
-				noMoreChecks;
-	VEC3		centreOfBox,
-				reactionVec, movementVec;
-	float		newX, newY, newZ,
-				shadowY,
-				len, mod;
+	float	c, p0, p1, p2,
+			lo, hi, r, s,
+			tEnter, tExit;
 
-	// Use a negative value for the default shadow height, so we can detect
-	// when it wasn't set.
- 
-	*shadowHeight = -1.0;
 
-	//------ Reset the count that 'checkMeshCollision' ---------
-	//------ updates -------------------------------------------
+	//------ Cross products of parallel edges give a -------
+	//------ degenerate axis, which separates nothing ------
 
-	COL_numCollisions = 0;
+	if (FABS(axis_p->x) + FABS(axis_p->y) + FABS(axis_p->z) < 0.000001f)
+		return(true);
 
 
-	//------ Find the shadow height of the new position --------
+	//------ Project the poly relative to the box centre ---
 
-	shadowY = COL_getShadowHeight(colMeshes_pp, pos_p, numMeshes, *x, *y, *z,
-		aaBox_p, maxStepHeight);
+	c = VEC_dot(axis_p, boxPos_p);
+	p0 = VEC_dot(axis_p, v0_p) - c;
+	p1 = VEC_dot(axis_p, v1_p) - c;
+	p2 = VEC_dot(axis_p, v2_p) - c;
 
-	// If the shadow height is above the current player position, step up.
-	// XXX -- Should we do both step up or fall down here, so we can fall
-	// through stuff?
+	lo = MIN(p0, MIN(p1, p2));
+	hi = MAX(p0, MAX(p1, p2));
 
-	if (FGT(shadowY, *y))
-		*y = shadowY;
 
-	//------ Set the centre of the axis-aligned box ------------
+	//------ Projected radius of the box, and the speed ----
+	//------ of the box along the axis ---------------------
+
+	r = aaBox_p->maxDim.x * FABS(axis_p->x) +
+		aaBox_p->maxDim.y * FABS(axis_p->y) +
+		aaBox_p->maxDim.z * FABS(axis_p->z);
+	s = VEC_dot(axis_p, move_p);
+
+
+	//------ If the box doesn't move along this axis, it ---
+	//------ either always overlaps or never does ----------
+
+	if (FABS(s) < 0.000001f)
+		return(hi >= -r && lo <= r);
+
+	if (s > 0)
+	{
+		tEnter = (lo - r) / s;
+		tExit = (hi + r) / s;
+	}
+	else
+	{
+		tEnter = (hi + r) / s;
+		tExit = (lo - r) / s;
+	}
+
+	if (tEnter > *tFirst_p)
+		*tFirst_p = tEnter;
+	if (tExit < *tLast_p)
+		*tLast_p = tExit;
+
+	return(*tFirst_p <= *tLast_p);
+}
+
+
+/*--------------------------------------------------------------
+
+	Sweep an Axis Aligned box along a movement vector against
+	a poly, and return the fraction of the movement at which
+	the box first touches it, or -1 if it never does.
+
+	The box axes, the poly normal and the nine edge cross
+	products are tested as separating axes.
+
+--------------------------------------------------------------*/
+
+static float
+COL_sweepAABoxAgainstPoly(COL_MESH *colMesh_p, int polyNum, VEC3 *boxPos_p,
+						  VEC3 *move_p, COL_AABOX *aaBox_p)
+{
+	int			i;
+	float		tFirst, tLast, d;
+	VEC3		axis,
+				*v0_p, *v1_p, *v2_p, *e_p;
+	COL_POLY3	*poly_p;
+
+
+	poly_p = &colMesh_p->p[polyNum];
+
+	v0_p = &colMesh_p->v[poly_p->vIdx[0]];
+	v1_p = &colMesh_p->v[poly_p->vIdx[1]];
+	v2_p = &colMesh_p->v[poly_p->vIdx[2]];
+
+	tFirst = 0;
+	tLast = 1;
+
 
-	VEC_set(&centreOfBox, *x, *y, *z);
-	VEC_add(&centreOfBox, &aaBox_p->offsToCentre, &centreOfBox);
+	//------ The three box axes ----------------------------
 
-	//------ Loop through every collision mesh to check --------
+	VEC_set(&axis, 1, 0, 0);
+	if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p, aaBox_p,
+		&tFirst, &tLast))
+		return(-1);
+
+	VEC_set(&axis, 0, 1, 0);
+	if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p, aaBox_p,
+		&tFirst, &tLast))
+		return(-1);
 
-	for (i=0; i<numMeshes; i++)
+	VEC_set(&axis, 0, 0, 1);
+	if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p, aaBox_p,
+		&tFirst, &tLast))
+		return(-1);
+
+
+	//------ The poly normal -------------------------------
+
+	if (!COL_sweepAxis(&poly_p->normal, v0_p, v1_p, v2_p, boxPos_p, move_p,
+		aaBox_p, &tFirst, &tLast))
+		return(-1);
+
+
+	//------ The box axes crossed with each poly edge ------
+
+	for (i=0; i<3; i++)
 	{
-		if (COL_checkAABoxAgainstMesh(colMeshes_pp[i], &pos_p[i], aaBox_p,
-			&centreOfBox))
-			COL_checkMeshCollision(colMeshes_pp[i], &pos_p[i], *x, *y, *z,
-				oldX, oldY, oldZ, aaBox_p, &centreOfBox);
+		e_p = &colMesh_p->e[poly_p->edgeIdx[i]];
+
+		VEC_set(&axis, 0, -e_p->z, e_p->y);
+		if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p,
+			aaBox_p, &tFirst, &tLast))
+			return(-1);
+
+		VEC_set(&axis, e_p->z, 0, -e_p->x);
+		if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p,
+			aaBox_p, &tFirst, &tLast))
+			return(-1);
+
+		VEC_set(&axis, -e_p->y, e_p->x, 0);
+		if (!COL_sweepAxis(&axis, v0_p, v1_p, v2_p, boxPos_p, move_p,
+			aaBox_p, &tFirst, &tLast))
+			return(-1);
 	}
 
 
-	//------ If there were some collisions ---------------------
+	//------ If the box starts off touching the poly but ---
+	//------ is moving away from it's plane, let it go -----
 
-	if (COL_numCollisions > 0)
+	if (tFirst == 0)
 	{
-		//------ We have to put the Y co-ordinate back to the --
-		//------ previous position because the new Y position --
-		//------ obviously hasn't worked! ----------------------
+		d = (boxPos_p->x - v0_p->x) * poly_p->normal.x +
+			(boxPos_p->y - v0_p->y) * poly_p->normal.y +
+			(boxPos_p->z - v0_p->z) * poly_p->normal.z;
+
+		if (d * VEC_dot(move_p, &poly_p->normal) > 0)
+			return(-1);
+	}
 
-		*y = oldY;
+	return(tFirst);
+}
 
-		noMoreChecks = 0;
 
-		movementVec.x = *x - oldX;
-		movementVec.y = *y - oldY;
-		movementVec.z = *z - oldZ;
-		len = VEC_length(&movementVec);
-		VEC_normalise(&movementVec);
+/*--------------------------------------------------------------
 
+	Sweep an Axis Aligned box along a movement vector against
+	multiple collision meshes, and find the first poly that
+	it touches.  Returns TRUE if it touches one, along with the
+	fraction of the movement and the normal of the poly.
 
-		//------ If there's only one collision, then slide -----
-		//------ against that normal ---------------------------
-						   
-		if (len > 0)					// Double check for safety reasons!
+--------------------------------------------------------------*/
+
+bool	COL_sweepAABox(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
+					   VEC3 *boxCentre_p, VEC3 *move_p, COL_AABOX *aaBox_p,
+					   float *t_p, VEC3 *normal_p)
+{
+	int			i, j, k,
+				lane, mask;
+	float		t, nearestT;
+	VEC3		boxPos,
+				sweepMin, sweepMax,
+				localMin, localMax;
+	COL_MESH	*colMesh_p;
+	COL_POLY3	*poly_p;
+
+
+	//------ The bounding box of the whole sweep -----------
+
+	sweepMin.x = boxCentre_p->x + MIN(move_p->x, 0) - aaBox_p->maxDim.x;
+	sweepMin.y = boxCentre_p->y + MIN(move_p->y, 0) - aaBox_p->maxDim.y;
+	sweepMin.z = boxCentre_p->z + MIN(move_p->z, 0) - aaBox_p->maxDim.z;
+	sweepMax.x = boxCentre_p->x + MAX(move_p->x, 0) + aaBox_p->maxDim.x;
+	sweepMax.y = boxCentre_p->y + MAX(move_p->y, 0) + aaBox_p->maxDim.y;
+	sweepMax.z = boxCentre_p->z + MAX(move_p->z, 0) + aaBox_p->maxDim.z;
+
+	nearestT = 2;
+
+	for (j=0; j<numMeshes; j++)
+	{
+		colMesh_p = colMeshes_pp[j];
+
+		//------ Bin the mesh if the sweep is nowhere near it --
+
+		if (sweepMin.x > colMesh_p->maxBox.x + pos_p[j].x ||
+			sweepMax.x < colMesh_p->minBox.x + pos_p[j].x ||
+			sweepMin.y > colMesh_p->maxBox.y + pos_p[j].y ||
+			sweepMax.y < colMesh_p->minBox.y + pos_p[j].y ||
+			sweepMin.z > colMesh_p->maxBox.z + pos_p[j].z ||
+			sweepMax.z < colMesh_p->minBox.z + pos_p[j].z)
+			continue;
+
+		VEC_sub(boxCentre_p, &pos_p[j], &boxPos);
+		VEC_sub(&sweepMin, &pos_p[j], &localMin);
+		VEC_sub(&sweepMax, &pos_p[j], &localMax);
+
+		for (k=0; k<colMesh_p->numPackets; k++)
 		{
-			if (COL_numCollisions == 1)
+			//------ Only sweep against the polys in this ------
+			//------ packet that the sweep is near -------------
+
+			mask = COL_aaboxAgainstPacket(&colMesh_p->pk[k], &localMin,
+				&localMax);
+
+			for (lane=0; mask; lane++, mask >>= 1)
 			{
-				COL_getCollidedNormal(0, &reactionVec);
-				if ((fabs(reactionVec.x) > 0.001f) || 
-					(fabs(reactionVec.z) > 0.001f))
+				if (!(mask & 1))
+					continue;
+
+				i = k * COL_PACKET_SIZE + lane;
+				poly_p = &colMesh_p->p[i];
+
+				//------ Single-sided polys facing away from ---
+				//------ the movement can't be hit -------------
+
+				if (!poly_p->double_sided &&
+					VEC_dot(&poly_p->normal, move_p) >= 0)
+					continue;
+
+				t = COL_sweepAABoxAgainstPoly(colMesh_p, i, &boxPos, move_p,
+					aaBox_p);
+
+				if (t >= 0 && t < nearestT)
 				{
-					VEC_normalise(&reactionVec);
-					len *= -VEC_dot(&reactionVec, &movementVec);
+					nearestT = t;
+					*normal_p = poly_p->normal;
+
+					//------ Double-sided polys must face the box --
 
-					newX = *x + reactionVec.x * len;
-					newY = *y + reactionVec.y * len;
-					newZ = *z + reactionVec.z * len;
+					if (VEC_dot(normal_p, move_p) > 0)
+					{
+						normal_p->x = -normal_p->x;
+						normal_p->y = -normal_p->y;
+						normal_p->z = -normal_p->z;
+					}
 				}
 			}
-			else
-			{
-				//------ Try each collided poly normal as a --------
-				//------ reaction, and see if that works -----------
+		}
+	}
 
-				i = 0;
-				colliding = 1;
-				while ((i < COL_numCollisions) && (colliding))
-				{
-					COL_getCollidedNormal(i, &reactionVec);
+	if (nearestT > 1)
+		return(false);
 
-					if ((fabs(reactionVec.x) > 0.001f) || 
-						(fabs(reactionVec.z) > 0.001f))
-					{
-						VEC_normalise(&reactionVec);
-						mod = len * -VEC_dot(&reactionVec, &movementVec);
+	*t_p = nearestT;
+	return(true);
+}
 
-						newX = *x + reactionVec.x * mod;
-						newY = *y + reactionVec.y * mod;
-						newZ = *z + reactionVec.z * mod;
 
-						VEC_set(&centreOfBox, newX, newY, newZ);
-						VEC_add(&centreOfBox, &aaBox_p->offsToCentre, 
-							&centreOfBox);
+/*--------------------------------------------------------------
 
-						colliding = COL_checkCollidedPolys(newX, newY, newZ,
-							oldX, oldY, oldZ, aaBox_p, &centreOfBox);
-					}
-				
-					i++;
-				}
+	Move an Axis Aligned box through multiple collision meshes
+	in one pass, sliding along whatever it hits and stepping
+	up onto anything no higher than the maximum step height.
+	The bottom of the swept box is raised by the maximum step
+	height, so only obstacles too high to step onto stop it.
 
+	The shadow height of the final position is returned, or
+	-1 if the box could not be placed.
 
-				if (colliding)
-				{
-					//------ Nope, so now try moving along the -----
-					//------ combined normals ----------------------
+--------------------------------------------------------------*/
 
-					COL_getReactionNormal(&reactionVec);
-					mod = VEC_length(&reactionVec);
+void	COL_moveAABox(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
+					  float *x, float *y, float *z,
+					  float dx, float dy, float dz,
+					  float *shadowHeight,
+					  float maxStepHeight,
+					  COL_AABOX *aaBox_p)
+{
+	int			sweeps;
+	float		t, len, mod,
+				shadowY;
+	VEC3		centreOfBox,
+				move, normal;
+	COL_AABOX	stepBox;
 
-					if (mod > 0)
-					{
-						VEC_normalise(&reactionVec);
-						len *= -VEC_dot(&reactionVec, &movementVec);
 
-						newX = *x + reactionVec.x * len;
-						newY = *y + reactionVec.y * len;
-						newZ = *z + reactionVec.z * len;
+	//------ Raise the bottom of the box by the step height -
 
-						VEC_set(&centreOfBox, newX, newY, newZ);
-						VEC_add(&centreOfBox, &aaBox_p->offsToCentre, 
-							&centreOfBox);
+	stepBox = *aaBox_p;
+	if (maxStepHeight < aaBox_p->maxDim.y)
+	{
+		stepBox.maxDim.y -= maxStepHeight * 0.5f;
+		stepBox.offsToCentre.y += maxStepHeight * 0.5f;
+	}
 
+	VEC_set(&move, dx, dy, dz);
 
-						//------ See if we're out of collision ---------
+	for (sweeps=0; sweeps<COL_MAX_SWEEPS; sweeps++)
+	{
+		len = VEC_length(&move);
+		if (len < COL_SWEEP_SKIN)
+			break;
 
-						if (COL_checkCollidedPolys(newX, newY, newZ,
-							oldX, oldY, oldZ, aaBox_p, &centreOfBox) )
-						{
+		VEC_set(&centreOfBox, *x, *y, *z);
+		VEC_add(&centreOfBox, &stepBox.offsToCentre, &centreOfBox);
 
-							//------ Oops, we're in trouble --------
-							//------ Shove the position back to ---- 
-							//------ the old one, and leave it at --
-							//------ that! -------------------------
 
-							newX = oldX;
-							newY = oldY;
-							newZ = oldZ;
-				
-							noMoreChecks = 1;
-						}
-					}
-					else
-					{
-					 	newX = oldX;
-				 		newY = oldY;
-					 	newZ = oldZ;
+		//------ Nothing in the way, so take the whole move ----
 
-					 	noMoreChecks = 1;
-					}
-				}
-			}
-		}
-		else
+		if (!COL_sweepAABox(colMeshes_pp, pos_p, numMeshes, &centreOfBox,
+			&move, &stepBox, &t, &normal))
 		{
-   		 	newX = oldX;
-   	 		newY = oldY;
-	   	 	newZ = oldZ;
-
-	   	 	noMoreChecks = 1;
+			*x += move.x;
+			*y += move.y;
+			*z += move.z;
+			break;
 		}
 
 
-		*x = newX;
-		*y = newY;
-		*z = newZ;
+		//------ Move up to the point of contact, keeping a ----
+		//------ small gap between the box and the poly --------
+
+		mod = t - COL_SWEEP_SKIN / len;
+		if (mod < 0)
+			mod = 0;
+
+		*x += move.x * mod;
+		*y += move.y * mod;
+		*z += move.z * mod;
 
+		move.x *= 1 - mod;
+		move.y *= 1 - mod;
+		move.z *= 1 - mod;
 
-		//------ Sanity check ----------------------------------
 
-		if (!noMoreChecks)
+		//------ If there's something to step up onto here, ----
+		//------ do so and carry on in the same direction ------
+
+		shadowY = COL_getShadowHeight(colMeshes_pp, pos_p, numMeshes,
+			*x, *y, *z, aaBox_p, maxStepHeight);
+
+		if (shadowY > *y + COL_SWEEP_SKIN)
 		{
-			i = 0;
-			collided = 0;
-			COL_numCollisions = 0;
+			*y = shadowY;
+			continue;
+		}
 
-			//------ Find the shadow height of the new ---------
-			//------ position ----------------------------------
 
-			shadowY = COL_getShadowHeight(colMeshes_pp, pos_p, numMeshes, 
-				*x, *y, *z, aaBox_p, maxStepHeight);
+		//------ Otherwise slide along the poly, using only ----
+		//------ it's horizontal normal as the reaction --------
 
-			// If the shadow height is above the current player position, step
-			// up.
+		normal.y = 0;
+		if (FABS(normal.x) <= 0.001f && FABS(normal.z) <= 0.001f)
+			break;
 
-			if (FGT(shadowY, *y))
-				*y = shadowY;
+		VEC_normalise(&normal);
+		mod = VEC_dot(&move, &normal);
 
-			VEC_set(&centreOfBox, *x, *y, *z);
-			VEC_add(&centreOfBox, &aaBox_p->offsToCentre, &centreOfBox);
+		move.x -= normal.x * mod;
+		move.z -= normal.z * mod;
+	}
 
-			while ((i < numMeshes) && (!collided))
-			{
-				if (COL_checkAABoxAgainstMesh(colMeshes_pp[i], &pos_p[i],
-					aaBox_p, &centreOfBox))
-					collided = COL_checkMeshCollision(colMeshes_pp[i],
-						&pos_p[i], *x, *y, *z, oldX, oldY, oldZ, aaBox_p,
-						&centreOfBox);
-				i++;
-			}
 
-			if (collided)
-			{
-				*x = oldX;
-				*y = oldY;
-				*z = oldZ;
-			}
-			else
+	//------ Find the shadow height of the final position ---
+
+	shadowY = COL_getShadowHeight(colMeshes_pp, pos_p, numMeshes, *x, *y, *z,
+		aaBox_p, maxStepHeight);
+
+	if (FGT(shadowY, *y))
+		*y = shadowY;
+
+	*shadowHeight = shadowY;
+}
+
+
+/*--------------------------------------------------------------
+
+	Check a ray against a poly, and return the fraction of the
+	ray at which it passes through, or -1 if it doesn't.
+	Single-sided polys are only hit from the front.
+
+--------------------------------------------------------------*/
+
+float	COL_rayAgainstPolyT(COL_MESH *colMesh_p, int polyNum,
+							VEC3 *rayOrigin_p, VEC3 *rayDir_p)
+{
+	float		det, invDet,
+				u, v, t;
+	VEC3		e1, e2,
+				p, q, s,
+				*v0_p;
+	COL_POLY3	*poly_p;
+
+
+	poly_p = &colMesh_p->p[polyNum];
+
+
+	//------ Bin it if the ray is hitting the back of a ----
+	//------ single-sided poly -----------------------------
+
+	if (!poly_p->double_sided && VEC_dot(rayDir_p, &poly_p->normal) >= 0)
+		return(-1);
+
+
+	//------ The two edges leaving vertex 0 ----------------
+
+	v0_p = &colMesh_p->v[poly_p->vIdx[0]];
+	e1 = colMesh_p->e[poly_p->edgeIdx[0]];
+	e2 = colMesh_p->e[poly_p->edgeIdx[2]];
+	e2.x = -e2.x;
+	e2.y = -e2.y;
+	e2.z = -e2.z;
+
+
+	//------ Barycentric co-ordinates of the point where ---
+	//------ the ray crosses the plane ---------------------
+
+	p.x = XPX3(rayDir_p, e2.y, e2.z);
+	p.y = -XPY3(rayDir_p, e2.x, e2.z);
+	p.z = XPZ3(rayDir_p, e2.x, e2.y);
+
+	det = VEC_dot(&e1, &p);
+	if (FABS(det) < 0.000001f)
+		return(-1);
+	invDet = 1.0f / det;
+
+	VEC_sub(rayOrigin_p, v0_p, &s);
+	u = VEC_dot(&s, &p) * invDet;
+	if (u < 0 || u > 1)
+		return(-1);
+
+	q.x = XPX3(&s, e1.y, e1.z);
+	q.y = -XPY3(&s, e1.x, e1.z);
+	q.z = XPZ3(&s, e1.x, e1.y);
+
+	v = VEC_dot(rayDir_p, &q) * invDet;
+	if (v < 0 || u + v > 1)
+		return(-1);
+
+	t = VEC_dot(&e2, &q) * invDet;
+	if (t < 0 || t > 1)
+		return(-1);
+
+	return(t);
+}
+
+
+/*--------------------------------------------------------------
+
+	Check a ray against multiple collision meshes, and find
+	the nearest poly it passes through.  This touches no
+	global state.
+
+--------------------------------------------------------------*/
+
+bool	COL_rayAgainstMeshes(COL_MESH **colMeshes_pp, VEC3 *pos_p,
+							 int numMeshes, VEC3 *rayOrigin_p,
+							 VEC3 *rayDir_p, COL_HIT *hit_p)
+{
+	int			i, j, k,
+				lane, mask;
+	float		t, nearestT;
+	VEC3		rayPos,
+				rayMin, rayMax,
+				localMin, localMax;
+	COL_MESH	*colMesh_p;
+
+
+	//------ The bounding box of the ray -------------------
+
+	rayMin.x = rayOrigin_p->x + MIN(rayDir_p->x, 0);
+	rayMin.y = rayOrigin_p->y + MIN(rayDir_p->y, 0);
+	rayMin.z = rayOrigin_p->z + MIN(rayDir_p->z, 0);
+	rayMax.x = rayOrigin_p->x + MAX(rayDir_p->x, 0);
+	rayMax.y = rayOrigin_p->y + MAX(rayDir_p->y, 0);
+	rayMax.z = rayOrigin_p->z + MAX(rayDir_p->z, 0);
+
+	nearestT = 2;
+
+	for (j=0; j<numMeshes; j++)
+	{
+		colMesh_p = colMeshes_pp[j];
+
+		VEC_sub(&rayMin, &pos_p[j], &localMin);
+		VEC_sub(&rayMax, &pos_p[j], &localMax);
+
+		//------ Bin the mesh if the ray is nowhere near it ----
+
+		if (localMin.x > colMesh_p->maxBox.x ||
+			localMax.x < colMesh_p->minBox.x ||
+			localMin.y > colMesh_p->maxBox.y ||
+			localMax.y < colMesh_p->minBox.y ||
+			localMin.z > colMesh_p->maxBox.z ||
+			localMax.z < colMesh_p->minBox.z)
+			continue;
+
+		VEC_sub(rayOrigin_p, &pos_p[j], &rayPos);
+
+		for (k=0; k<colMesh_p->numPackets; k++)
+		{
+			mask = COL_aaboxAgainstPacket(&colMesh_p->pk[k], &localMin,
+				&localMax);
+
+			for (lane=0; mask; lane++, mask >>= 1)
 			{
-				*shadowHeight = shadowY;
+				if (!(mask & 1))
+					continue;
+
+				i = k * COL_PACKET_SIZE + lane;
+
+				t = COL_rayAgainstPolyT(colMesh_p, i, &rayPos, rayDir_p);
+				if (t >= 0 && t < nearestT)
+				{
+					nearestT = t;
+					hit_p->mesh_p = colMesh_p;
+					hit_p->polyNum = i;
+				}
 			}
 		}
 	}
-	else
+
+	if (nearestT > 1)
+		return(NON_INTERSECTING);
+
+	hit_p->t = nearestT;
+	hit_p->poi.x = rayOrigin_p->x + rayDir_p->x * nearestT;
+	hit_p->poi.y = rayOrigin_p->y + rayDir_p->y * nearestT;
+	hit_p->poi.z = rayOrigin_p->z + rayDir_p->z * nearestT;
+	hit_p->normal = hit_p->mesh_p->p[hit_p->polyNum].normal;
+	return(INTERSECTING);
+}
+
+
+/*--------------------------------------------------------------
+
+	Check whether an Axis Aligned box overlaps any poly in
+	multiple collision meshes.  Like the ray check above, this
+	touches no global state.
+
+--------------------------------------------------------------*/
+
+bool	COL_aaboxAgainstMeshes(COL_MESH **colMeshes_pp, VEC3 *pos_p,
+							   int numMeshes, COL_AABOX *aaBox_p,
+							   VEC3 *boxCentre_p)
+{
+	int			i, j, k,
+				lane, mask;
+	VEC3		boxMin, boxMax;
+	COL_MESH	*colMesh_p;
+
+
+	for (j=0; j<numMeshes; j++)
 	{
-		//------ No collision, so the first calculated ---------
-		//------ shadow position is fine -----------------------
+		colMesh_p = colMeshes_pp[j];
+
+		if (!COL_checkAABoxAgainstMesh(colMesh_p, &pos_p[j], aaBox_p,
+			boxCentre_p))
+			continue;
+
+		boxMin.x = boxCentre_p->x - pos_p[j].x - aaBox_p->maxDim.x;
+		boxMin.y = boxCentre_p->y - pos_p[j].y - aaBox_p->maxDim.y;
+		boxMin.z = boxCentre_p->z - pos_p[j].z - aaBox_p->maxDim.z;
+		boxMax.x = boxCentre_p->x - pos_p[j].x + aaBox_p->maxDim.x;
+		boxMax.y = boxCentre_p->y - pos_p[j].y + aaBox_p->maxDim.y;
+		boxMax.z = boxCentre_p->z - pos_p[j].z + aaBox_p->maxDim.z;
 
-		*shadowHeight = shadowY;
+		for (k=0; k<colMesh_p->numPackets; k++)
+		{
+			mask = COL_aaboxAgainstPacket(&colMesh_p->pk[k], &boxMin, &boxMax);
+
+			for (lane=0; mask; lane++, mask >>= 1)
+			{
+				if (!(mask & 1))
+					continue;
+
+				i = k * COL_PACKET_SIZE + lane;
+
+				if (COL_isIntersecting(colMesh_p, &pos_p[j], i, aaBox_p,
+					boxCentre_p))
+					return(INTERSECTING);
+			}
+		}
 	}
+
+	return(NON_INTERSECTING);
 }
 
 
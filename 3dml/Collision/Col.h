@@ -38,7 +38,7 @@
 
 --------------------------------------------------------------*/
 
-#define	MAX_COLLISION_POLYS			64
+#define	COL_PACKET_SIZE				4
 
 #define NON_INTERSECTING			false
 #define INTERSECTING				true
@@ -69,6 +69,9 @@
 
 #define	COL_SHADOW_TOLERANCE		0.1f
 
+#define	COL_MAX_SWEEPS				16
+#define	COL_SWEEP_SKIN				0.01f
+
 
 /*--------------------------------------------------------------
 
@@ -298,11 +301,40 @@ struct	COL_POLY3
 };
 
 
+	//------ Four polys laid out side by side, so that ---------
+	//------ each test below runs the same maths on every ------
+	//------ lane of the packet --------------------------------
+
+struct	COL_PACKET4
+{
+	float		minX[COL_PACKET_SIZE];		// Poly bounding boxes
+	float		minY[COL_PACKET_SIZE];
+	float		minZ[COL_PACKET_SIZE];
+	float		maxX[COL_PACKET_SIZE];
+	float		maxY[COL_PACKET_SIZE];
+	float		maxZ[COL_PACKET_SIZE];
+
+	float		ax[3][COL_PACKET_SIZE];		// Edge start points and
+	float		az[3][COL_PACKET_SIZE];		// vectors, projected onto
+	float		ex[3][COL_PACKET_SIZE];		// the XZ plane
+	float		ez[3][COL_PACKET_SIZE];
+
+	float		nx[COL_PACKET_SIZE];		// Plane equations
+	float		nz[COL_PACKET_SIZE];
+	float		invNy[COL_PACKET_SIZE];
+	float		d[COL_PACKET_SIZE];
+
+	int			upMask;						// Lanes facing upwards
+	int			shadowMask;					// Lanes that can cast a shadow
+};
+
+
 struct	COL_MESH
 {
 	int			numPolys;
 	int			numEdges;
 	int			numVerts;
+	int			numPackets;
 
 	VEC3		minBox;				// Bounding box
 	VEC3		maxBox;
@@ -310,6 +342,7 @@ struct	COL_MESH
 	VEC3		*v;					// vertices
 	VEC3		*e;					// edges
 	COL_POLY3	*p;					// polys
+	COL_PACKET4	*pk;				// polys in packets of four
 };
 
 
@@ -320,6 +353,16 @@ struct	COL_AABOX
 };
 
 
+struct	COL_HIT
+{
+	float		t;					// Fraction of the ray at the hit
+	VEC3		poi;				// The world position of the hit
+	VEC3		normal;				// Normal of the poly that was hit
+	COL_MESH	*mesh_p;			// The mesh and poly that were hit
+	int			polyNum;
+};
+
+
 struct	COL_RAY
 {
 	VEC3		origin;				  // The world position of the start of the ray
@@ -335,12 +378,29 @@ struct	COL_RAY
 
 --------------------------------------------------------------*/
 
-void		COL_checkCollisions(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
-								float *x, float *y, float *z,
-								float oldX, float oldY, float oldZ,
-								float *shadowHeight,
-								float maxStepHeight,
-								COL_AABOX *aaBox_p);
+void		COL_buildPackets(COL_MESH *colMesh_p);
+
+bool		COL_sweepAABox(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
+						   VEC3 *boxCentre_p, VEC3 *move_p, COL_AABOX *aaBox_p,
+						   float *t_p, VEC3 *normal_p);
+
+void		COL_moveAABox(COL_MESH **colMeshes_pp, VEC3 *pos_p, int numMeshes,
+						  float *x, float *y, float *z,
+						  float dx, float dy, float dz,
+						  float *shadowHeight,
+						  float maxStepHeight,
+						  COL_AABOX *aaBox_p);
+
+float		COL_rayAgainstPolyT(COL_MESH *colMesh_p, int polyNum,
+								VEC3 *rayOrigin_p, VEC3 *rayDir_p);
+
+bool		COL_rayAgainstMeshes(COL_MESH **colMeshes_pp, VEC3 *pos_p,
+								 int numMeshes, VEC3 *rayOrigin_p,
+								 VEC3 *rayDir_p, COL_HIT *hit_p);
+
+bool		COL_aaboxAgainstMeshes(COL_MESH **colMeshes_pp, VEC3 *pos_p,
+								   int numMeshes, COL_AABOX *aaBox_p,
+								   VEC3 *boxCentre_p);
 
 void		COL_init(void);
 void		COL_exit(void);
@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "collision.h"
 #include "..\Classes.h"
@@ -29,20 +30,26 @@
 #include "..\Memory.h"
 
 //-----------------------------------------------------------------------------
-// Create a collision mesh of the given size.
+// Create a collision mesh of the given size, returning a pointer to it and
+// its size in bytes.
 //-----------------------------------------------------------------------------
 
 static bool
-COL_createColMesh(block *block_ptr, int vertices, int edges, int triangles)
+COL_createColMesh(COL_MESH **col_mesh_ptr_ptr, int *col_mesh_size_ptr,
+				  int vertices, int edges, int triangles)
 {
 	byte *temp_ptr;
 	COL_MESH *col_mesh_ptr;
 	int col_mesh_size;
+	int packets;
 
-	// Compute the size of the collision mesh structure.
+	// Compute the size of the collision mesh structure, including the
+	// triangles grouped into packets.
 
-	col_mesh_size = sizeof(COL_MESH) + vertices * sizeof(VEC3) + 
-		edges * sizeof(VEC3) + triangles * sizeof(COL_POLY3);
+	packets = (triangles + COL_PACKET_SIZE - 1) / COL_PACKET_SIZE;
+	col_mesh_size = sizeof(COL_MESH) + packets * sizeof(COL_PACKET4) +
+		vertices * sizeof(VEC3) + edges * sizeof(VEC3) + 
+		triangles * sizeof(COL_POLY3);
 
 	// Allocate the collision mesh structure.
 
@@ -54,6 +61,8 @@ COL_createColMesh(block *block_ptr, int vertices, int edges, int triangles)
 	// Set up the collision mesh pointers.
 
 	temp_ptr += sizeof(COL_MESH);
+	col_mesh_ptr->pk = (COL_PACKET4 *)temp_ptr;
+	temp_ptr += sizeof(COL_PACKET4) * packets;
 	col_mesh_ptr->v = (VEC3 *)temp_ptr;
 	temp_ptr += sizeof(VEC3) * vertices;
 	col_mesh_ptr->e = (VEC3 *)temp_ptr;
@@ -65,20 +74,22 @@ COL_createColMesh(block *block_ptr, int vertices, int edges, int triangles)
 	col_mesh_ptr->numVerts = vertices;
 	col_mesh_ptr->numEdges = edges;
 	col_mesh_ptr->numPolys = triangles;
+	col_mesh_ptr->numPackets = packets;
 
-	// Store the collision mesh pointer and size in the block.
+	// Return the collision mesh pointer and size.
 
-	block_ptr->col_mesh_ptr = col_mesh_ptr;
-	block_ptr->col_mesh_size = col_mesh_size;
+	*col_mesh_ptr_ptr = col_mesh_ptr;
+	*col_mesh_size_ptr = col_mesh_size;
 	return(true);
 }
 
 //-----------------------------------------------------------------------------
-//	Create a collision mesh for a block.
+//	Create the collision mesh for a block definition, which is shared by all
+//	blocks created from it.
 //-----------------------------------------------------------------------------
 
 bool
-COL_createBlockColMesh(block *block_ptr, block_def *block_def_ptr)
+COL_createBlockColMesh(block_def *block_def_ptr)
 {
 	int	index, triangles;
 	polygon *polygon_ptr;
@@ -94,7 +105,8 @@ COL_createBlockColMesh(block *block_ptr, block_def *block_def_ptr)
 		if (part_ptr->solid)
 			triangles += polygon_ptr->vertices - 2;
 	}
-	return(COL_createColMesh(block_ptr, block_def_ptr->vertices, 
+	return(COL_createColMesh(&block_def_ptr->col_mesh_ptr,
+		&block_def_ptr->col_mesh_size, block_def_ptr->vertices, 
 		triangles * 3, triangles));
 }
 
@@ -220,28 +232,23 @@ COL_convertBlockToColMesh(COL_MESH *mesh_ptr, block_def *block_def_ptr)
 				thisEdge++;
 
 				if (j == 0) {
-					poly_ptr->min.x = block_def_ptr->vertex_list[v[0]].x;
-					poly_ptr->min.y = block_def_ptr->vertex_list[v[0]].y;
-					poly_ptr->min.z = block_def_ptr->vertex_list[v[0]].z;
-
-					poly_ptr->max.x = block_def_ptr->vertex_list[v[0]].x;
-					poly_ptr->max.y = block_def_ptr->vertex_list[v[0]].y;
-					poly_ptr->max.z = block_def_ptr->vertex_list[v[0]].z;
+					poly_ptr->min = mesh_ptr->v[v[0]];
+					poly_ptr->max = mesh_ptr->v[v[0]];
 				} else {
-					if (block_def_ptr->vertex_list[v[j]].x < poly_ptr->min.x)
-						poly_ptr->min.x = block_def_ptr->vertex_list[v[j]].x;
-					if (block_def_ptr->vertex_list[v[j]].x > poly_ptr->max.x)
-						poly_ptr->max.x = block_def_ptr->vertex_list[v[j]].x;
-
-					if (block_def_ptr->vertex_list[v[j]].y < poly_ptr->min.y)
-						poly_ptr->min.y = block_def_ptr->vertex_list[v[j]].y;
-					if (block_def_ptr->vertex_list[v[j]].y > poly_ptr->max.y)
-						poly_ptr->max.y = block_def_ptr->vertex_list[v[j]].y;
-
-					if (block_def_ptr->vertex_list[v[j]].z < poly_ptr->min.z)
-						poly_ptr->min.z = block_def_ptr->vertex_list[v[j]].z;
-					if (block_def_ptr->vertex_list[v[j]].z > poly_ptr->max.z)
-						poly_ptr->max.z = block_def_ptr->vertex_list[v[j]].z;
+					if (mesh_ptr->v[v[j]].x < poly_ptr->min.x)
+						poly_ptr->min.x = mesh_ptr->v[v[j]].x;
+					if (mesh_ptr->v[v[j]].x > poly_ptr->max.x)
+						poly_ptr->max.x = mesh_ptr->v[v[j]].x;
+
+					if (mesh_ptr->v[v[j]].y < poly_ptr->min.y)
+						poly_ptr->min.y = mesh_ptr->v[v[j]].y;
+					if (mesh_ptr->v[v[j]].y > poly_ptr->max.y)
+						poly_ptr->max.y = mesh_ptr->v[v[j]].y;
+
+					if (mesh_ptr->v[v[j]].z < poly_ptr->min.z)
+						poly_ptr->min.z = mesh_ptr->v[v[j]].z;
+					if (mesh_ptr->v[v[j]].z > poly_ptr->max.z)
+						poly_ptr->max.z = mesh_ptr->v[v[j]].z;
 				}
 			}
 
@@ -281,13 +288,13 @@ COL_convertBlockToColMesh(COL_MESH *mesh_ptr, block_def *block_def_ptr)
 
 	//------ Set the mesh bounding box -------------------------
 
-	mesh_ptr->minBox.x = meshMin.x * world_ptr->block_scale;
-	mesh_ptr->minBox.y = meshMin.y * world_ptr->block_scale;
-	mesh_ptr->minBox.z = meshMin.z * world_ptr->block_scale;
+	mesh_ptr->minBox = meshMin;
+	mesh_ptr->maxBox = meshMax;
+
 
-	mesh_ptr->maxBox.x = meshMax.x * world_ptr->block_scale;
-	mesh_ptr->maxBox.y = meshMax.y * world_ptr->block_scale;
-	mesh_ptr->maxBox.z = meshMax.z * world_ptr->block_scale;
+	//------ Group the polys into packets ----------------------
+
+	COL_buildPackets(mesh_ptr);
 }
 
 //-----------------------------------------------------------------------------
@@ -297,7 +304,8 @@ COL_convertBlockToColMesh(COL_MESH *mesh_ptr, block_def *block_def_ptr)
 bool
 COL_createSpriteColMesh(block *block_ptr)
 {
-	return(COL_createColMesh(block_ptr, 8, 36, 12)); 
+	return(COL_createColMesh(&block_ptr->col_mesh_ptr, 
+		&block_ptr->col_mesh_size, 8, 36, 12)); 
 }
 
 //-----------------------------------------------------------------------------
@@ -552,4 +560,379 @@ COL_convertSpriteToColMesh(COL_MESH *mesh_ptr, float minX, float minY,
 	mesh_ptr->maxBox.x = meshMax.x;
 	mesh_ptr->maxBox.y = meshMax.y;
 	mesh_ptr->maxBox.z = meshMax.z;
-}
\ No newline at end of file
+
+
+	//------ Group the polys into packets ----------------------
+
+	COL_buildPackets(mesh_ptr);
+}
+
+//-----------------------------------------------------------------------------
+// Initialise a collision query.
+//-----------------------------------------------------------------------------
+
+void
+COL_initQuery(COL_QUERY *query_ptr)
+{
+	query_ptr->numMeshes = 0;
+	query_ptr->truncated = false;
+}
+
+//-----------------------------------------------------------------------------
+// Add a block's collision mesh to a query, if it has one.
+//-----------------------------------------------------------------------------
+
+static void
+COL_addQueryMesh(COL_QUERY *query_ptr, block *block_ptr)
+{
+	if (!block_ptr->solid || block_ptr->col_mesh_ptr == NULL)
+		return;
+	if (query_ptr->numMeshes == COL_MAX_QUERY_MESHES) {
+		query_ptr->truncated = true;
+		return;
+	}
+	query_ptr->meshes[query_ptr->numMeshes] = block_ptr->col_mesh_ptr;
+	query_ptr->meshPos[query_ptr->numMeshes].x = block_ptr->translation.x;
+	query_ptr->meshPos[query_ptr->numMeshes].y = block_ptr->translation.y;
+	query_ptr->meshPos[query_ptr->numMeshes].z = block_ptr->translation.z;
+	query_ptr->numMeshes++;
+}
+
+//-----------------------------------------------------------------------------
+// Return TRUE if the collision mesh of a movable block overlaps the given
+// bounding box.
+//-----------------------------------------------------------------------------
+
+static bool
+COL_movableBlockOverlaps(block *block_ptr, VEC3 *min_ptr, VEC3 *max_ptr)
+{
+	COL_MESH *col_mesh_ptr;
+
+	if (!block_ptr->solid || (col_mesh_ptr = block_ptr->col_mesh_ptr) == NULL)
+		return(false);
+	return(!(col_mesh_ptr->minBox.x + block_ptr->translation.x > max_ptr->x ||
+		col_mesh_ptr->maxBox.x + block_ptr->translation.x < min_ptr->x ||
+		col_mesh_ptr->minBox.y + block_ptr->translation.y > max_ptr->y ||
+		col_mesh_ptr->maxBox.y + block_ptr->translation.y < min_ptr->y ||
+		col_mesh_ptr->minBox.z + block_ptr->translation.z > max_ptr->z ||
+		col_mesh_ptr->maxBox.z + block_ptr->translation.z < min_ptr->z));
+}
+
+//-----------------------------------------------------------------------------
+// Add the movable blocks whose collision mesh overlaps the given bounding box
+// to a query.
+//-----------------------------------------------------------------------------
+
+static void
+COL_addMovableQueryMeshes(COL_QUERY *query_ptr, VEC3 *min_ptr, VEC3 *max_ptr)
+{
+	block *block_ptr;
+
+	block_ptr = movable_block_list;
+	while (block_ptr) {
+		if (COL_movableBlockOverlaps(block_ptr, min_ptr, max_ptr))
+			COL_addQueryMesh(query_ptr, block_ptr);
+		block_ptr = block_ptr->next_block_ptr;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Gather the collision meshes of the movable blocks and the blocks on the map
+// squares that overlap the given bounding box into a query.  The movable
+// blocks are gathered first, so if the query fills up it is static blocks that
+// are left out; the query's truncated flag is set if this happens.
+//-----------------------------------------------------------------------------
+
+void
+COL_gatherQueryMeshes(COL_QUERY *query_ptr, VEC3 *min_ptr, VEC3 *max_ptr)
+{
+	vertex min_bbox, max_bbox;
+	int min_level, min_row, min_column;
+	int max_level, max_row, max_column;
+	int level, row, column;
+	block *block_ptr;
+
+	COL_initQuery(query_ptr);
+	COL_addMovableQueryMeshes(query_ptr, min_ptr, max_ptr);
+
+	// Determine which squares are at the corners of the bounding box,
+	// clamped to the map.  Note that min_row and max_row are swapped because
+	// as the Z coordinate increases the row number decreases.  The level
+	// below the bounding box is included so that the floor is found.
+
+	min_bbox.set(min_ptr->x, min_ptr->y, min_ptr->z);
+	max_bbox.set(max_ptr->x, max_ptr->y, max_ptr->z);
+	min_bbox.get_scaled_map_position(&min_column, &max_row, &min_level);
+	max_bbox.get_scaled_map_position(&max_column, &min_row, &max_level);
+	min_level--;
+	min_column = MAX(min_column, 0);
+	min_row = MAX(min_row, 0);
+	min_level = MAX(min_level, 0);
+	max_column = MIN(max_column, world_ptr->columns - 1);
+	max_row = MIN(max_row, world_ptr->rows - 1);
+	max_level = MIN(max_level, world_ptr->levels - 1);
+
+	// Add the blocks on the squares in that range.
+
+	for (level = min_level; level <= max_level; level++)
+		for (row = min_row; row <= max_row; row++)
+			for (column = min_column; column <= max_column; column++)
+				if ((block_ptr = world_ptr->get_block_ptr(column, row, level))
+					!= NULL)
+					COL_addQueryMesh(query_ptr, block_ptr);
+}
+
+//-----------------------------------------------------------------------------
+// Check a ray against the movable blocks by walking the whole movable block
+// list, for when there were too many to gather into a query.
+//-----------------------------------------------------------------------------
+
+static bool
+COL_rayAgainstMovableBlocks(VEC3 *origin_ptr, VEC3 *dir_ptr, COL_HIT *hit_ptr)
+{
+	block *block_ptr;
+	VEC3 min_bbox, max_bbox, mesh_pos;
+	COL_HIT hit;
+	bool hit_flag;
+
+	min_bbox.x = origin_ptr->x + MIN(dir_ptr->x, 0.0f);
+	min_bbox.y = origin_ptr->y + MIN(dir_ptr->y, 0.0f);
+	min_bbox.z = origin_ptr->z + MIN(dir_ptr->z, 0.0f);
+	max_bbox.x = origin_ptr->x + MAX(dir_ptr->x, 0.0f);
+	max_bbox.y = origin_ptr->y + MAX(dir_ptr->y, 0.0f);
+	max_bbox.z = origin_ptr->z + MAX(dir_ptr->z, 0.0f);
+	hit_flag = false;
+	block_ptr = movable_block_list;
+	while (block_ptr) {
+		if (COL_movableBlockOverlaps(block_ptr, &min_bbox, &max_bbox)) {
+			mesh_pos.x = block_ptr->translation.x;
+			mesh_pos.y = block_ptr->translation.y;
+			mesh_pos.z = block_ptr->translation.z;
+			if (COL_rayAgainstMeshes(&block_ptr->col_mesh_ptr, &mesh_pos, 1,
+				origin_ptr, dir_ptr, &hit) &&
+				(!hit_flag || hit.t < hit_ptr->t)) {
+				*hit_ptr = hit;
+				hit_flag = true;
+			}
+		}
+		block_ptr = block_ptr->next_block_ptr;
+	}
+	return(hit_flag);
+}
+
+//-----------------------------------------------------------------------------
+// Check a ray against the blocks on the map squares it passes through, which
+// are visited in order along the ray.  If any_hit is TRUE, the first hit found
+// is returned; otherwise the nearest hit is returned.  Like the player's own
+// collision checks, this assumes that a block lies within it's own square.
+//-----------------------------------------------------------------------------
+
+static bool
+COL_rayAgainstSquares(VEC3 *origin_ptr, VEC3 *dir_ptr, COL_HIT *hit_ptr,
+					  bool any_hit)
+{
+	float origin[3], dir[3], t_max[3], t_delta[3];
+	int cell[3], step[3], limit[3];
+	int axis;
+	float t_exit;
+	block *block_ptr;
+	VEC3 mesh_pos;
+	COL_HIT hit;
+	bool hit_flag;
+
+	// Set up a walk through the cells of the map along the ray, where a cell
+	// is given by it's column, level and Z index (which runs the opposite way
+	// to the row).  The ray's direction vector is it's whole length, so the
+	// walk ends when the distance along the ray passes 1.
+
+	origin[0] = origin_ptr->x;
+	origin[1] = origin_ptr->y;
+	origin[2] = origin_ptr->z;
+	dir[0] = dir_ptr->x;
+	dir[1] = dir_ptr->y;
+	dir[2] = dir_ptr->z;
+	limit[0] = world_ptr->columns;
+	limit[1] = world_ptr->levels;
+	limit[2] = world_ptr->rows;
+	for (axis = 0; axis < 3; axis++) {
+		cell[axis] = (int)floor(origin[axis] / world_ptr->block_units);
+		if (dir[axis] > 0.0f) {
+			step[axis] = 1;
+			t_max[axis] = ((cell[axis] + 1) * world_ptr->block_units -
+				origin[axis]) / dir[axis];
+			t_delta[axis] = world_ptr->block_units / dir[axis];
+		} else if (dir[axis] < 0.0f) {
+			step[axis] = -1;
+			t_max[axis] = (cell[axis] * world_ptr->block_units -
+				origin[axis]) / dir[axis];
+			t_delta[axis] = -world_ptr->block_units / dir[axis];
+		} else {
+			step[axis] = 0;
+			t_max[axis] = 2.0f;
+			t_delta[axis] = 2.0f;
+		}
+	}
+
+	// Check the block in each cell the ray passes through.  Once a hit has
+	// been found that is no further along the ray than the end of the current
+	// cell, no later cell can have a nearer one.
+
+	hit_flag = false;
+	while (true) {
+		if ((block_ptr = world_ptr->get_block_ptr(cell[0],
+			world_ptr->rows - cell[2] - 1, cell[1])) != NULL &&
+			block_ptr->solid && block_ptr->col_mesh_ptr != NULL) {
+			mesh_pos.x = block_ptr->translation.x;
+			mesh_pos.y = block_ptr->translation.y;
+			mesh_pos.z = block_ptr->translation.z;
+			if (COL_rayAgainstMeshes(&block_ptr->col_mesh_ptr, &mesh_pos, 1,
+				origin_ptr, dir_ptr, &hit) &&
+				(!hit_flag || hit.t < hit_ptr->t)) {
+				*hit_ptr = hit;
+				hit_flag = true;
+				if (any_hit)
+					break;
+			}
+		}
+
+		// Step into the next cell along the ray, stopping if the ray ends
+		// first or it leaves the map for good.
+
+		axis = 0;
+		if (t_max[1] < t_max[axis])
+			axis = 1;
+		if (t_max[2] < t_max[axis])
+			axis = 2;
+		t_exit = t_max[axis];
+		if (t_exit > 1.0f || (hit_flag && hit_ptr->t <= t_exit))
+			break;
+		cell[axis] += step[axis];
+		t_max[axis] += t_delta[axis];
+		if ((step[axis] < 0 && cell[axis] < 0) ||
+			(step[axis] > 0 && cell[axis] >= limit[axis]))
+			break;
+	}
+	return(hit_flag);
+}
+
+//-----------------------------------------------------------------------------
+// Check a ray against the movable blocks gathered into a query, and then
+// against the map squares it passes through.  Returns the nearest hit, or if
+// any_hit is TRUE, whichever hit is found first.
+//-----------------------------------------------------------------------------
+
+static bool
+COL_castRay(COL_QUERY *query_ptr, VEC3 *origin_ptr, VEC3 *dir_ptr,
+			COL_HIT *hit_ptr, bool any_hit)
+{
+	COL_HIT hit;
+	bool hit_flag;
+
+	// If there were too many movable blocks to gather them all, walk the
+	// whole movable block list instead.
+
+	if (query_ptr->truncated)
+		hit_flag = COL_rayAgainstMovableBlocks(origin_ptr, dir_ptr, hit_ptr);
+	else
+		hit_flag = COL_rayAgainstMeshes(query_ptr->meshes, query_ptr->meshPos,
+			query_ptr->numMeshes, origin_ptr, dir_ptr, hit_ptr);
+	if (hit_flag && any_hit)
+		return(true);
+	if (COL_rayAgainstSquares(origin_ptr, dir_ptr, &hit, any_hit) &&
+		(!hit_flag || hit.t < hit_ptr->t)) {
+		*hit_ptr = hit;
+		hit_flag = true;
+	}
+	return(hit_flag);
+}
+
+//-----------------------------------------------------------------------------
+// Cast a batch of rays against the world, each from it's origin along it's
+// direction vector (whose length is the length of the ray).  For each ray,
+// the hit flag is set and the hit filled in if the ray hit something.
+// Returns the number of rays that hit something.
+//-----------------------------------------------------------------------------
+
+int
+COL_castRays(COL_QUERY *query_ptr, int rays, VEC3 *origin_list, 
+			 VEC3 *dir_list, COL_HIT *hit_list, bool *hit_flag_list)
+{
+	int ray_no, hits;
+	VEC3 min_bbox, max_bbox;
+	VEC3 *origin_ptr, *dir_ptr;
+
+	// Gather the movable blocks around all of the rays once, using the
+	// bounding box of the whole batch.
+
+	COL_initQuery(query_ptr);
+	if (rays == 0)
+		return(0);
+	min_bbox = origin_list[0];
+	max_bbox = origin_list[0];
+	for (ray_no = 0; ray_no < rays; ray_no++) {
+		origin_ptr = &origin_list[ray_no];
+		dir_ptr = &dir_list[ray_no];
+		min_bbox.x = MIN(min_bbox.x, origin_ptr->x + MIN(dir_ptr->x, 0.0f));
+		min_bbox.y = MIN(min_bbox.y, origin_ptr->y + MIN(dir_ptr->y, 0.0f));
+		min_bbox.z = MIN(min_bbox.z, origin_ptr->z + MIN(dir_ptr->z, 0.0f));
+		max_bbox.x = MAX(max_bbox.x, origin_ptr->x + MAX(dir_ptr->x, 0.0f));
+		max_bbox.y = MAX(max_bbox.y, origin_ptr->y + MAX(dir_ptr->y, 0.0f));
+		max_bbox.z = MAX(max_bbox.z, origin_ptr->z + MAX(dir_ptr->z, 0.0f));
+	}
+	COL_addMovableQueryMeshes(query_ptr, &min_bbox, &max_bbox);
+
+	// Check each ray against the movable blocks and the squares it passes
+	// through.
+
+	hits = 0;
+	for (ray_no = 0; ray_no < rays; ray_no++) {
+		hit_flag_list[ray_no] = COL_castRay(query_ptr, &origin_list[ray_no],
+			&dir_list[ray_no], &hit_list[ray_no], false);
+		if (hit_flag_list[ray_no])
+			hits++;
+	}
+	return(hits);
+}
+
+//-----------------------------------------------------------------------------
+// Return TRUE if nothing solid lies between two points.
+//-----------------------------------------------------------------------------
+
+bool
+COL_lineOfSight(COL_QUERY *query_ptr, VEC3 *from_ptr, VEC3 *to_ptr)
+{
+	VEC3 dir, min_bbox, max_bbox;
+	COL_HIT hit;
+
+	VEC_sub(to_ptr, from_ptr, &dir);
+	min_bbox.x = MIN(from_ptr->x, to_ptr->x);
+	min_bbox.y = MIN(from_ptr->y, to_ptr->y);
+	min_bbox.z = MIN(from_ptr->z, to_ptr->z);
+	max_bbox.x = MAX(from_ptr->x, to_ptr->x);
+	max_bbox.y = MAX(from_ptr->y, to_ptr->y);
+	max_bbox.z = MAX(from_ptr->z, to_ptr->z);
+	COL_initQuery(query_ptr);
+	COL_addMovableQueryMeshes(query_ptr, &min_bbox, &max_bbox);
+	return(!COL_castRay(query_ptr, from_ptr, &dir, &hit, true));
+}
+
+//-----------------------------------------------------------------------------
+// Return TRUE if an axis-aligned box overlaps anything solid in the world.
+// If there were too many blocks around the box to check them all, it is
+// assumed to overlap something.
+//-----------------------------------------------------------------------------
+
+bool
+COL_boxOverlapsWorld(COL_QUERY *query_ptr, COL_AABOX *box_ptr, 
+					 VEC3 *centre_ptr)
+{
+	VEC3 min_bbox, max_bbox;
+
+	VEC_sub(centre_ptr, &box_ptr->maxDim, &min_bbox);
+	VEC_add(centre_ptr, &box_ptr->maxDim, &max_bbox);
+	COL_gatherQueryMeshes(query_ptr, &min_bbox, &max_bbox);
+	if (query_ptr->truncated)
+		return(true);
+	return(COL_aaboxAgainstMeshes(query_ptr->meshes, query_ptr->meshPos,
+		query_ptr->numMeshes, box_ptr, centre_ptr));
+}
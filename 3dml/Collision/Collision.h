@@ -48,6 +48,8 @@ struct block_def;
 
 --------------------------------------------------------------*/
 
+#define	COL_MAX_QUERY_MESHES		512
+
 
 /*--------------------------------------------------------------
 
@@ -55,6 +57,23 @@ struct block_def;
 
 --------------------------------------------------------------*/
 
+	//------ A collision query against the world.  Each --------
+	//------ caller owns it's own query, so queries keep no ----
+	//------ global state and can be interleaved freely.  But --
+	//------ they read the map, the movable blocks and their ---
+	//------ collision meshes without locking, and the player --
+	//------ thread changes these every frame, so queries ------
+	//------ must only be run on the player thread -------------
+
+struct	COL_QUERY
+{
+	int			numMeshes;
+	bool		truncated;			// Too many meshes to gather them all
+
+	COL_MESH	*meshes[COL_MAX_QUERY_MESHES];
+	VEC3		meshPos[COL_MAX_QUERY_MESHES];
+};
+
 
 /*--------------------------------------------------------------
 
@@ -63,7 +82,7 @@ struct block_def;
 --------------------------------------------------------------*/
 
 bool
-COL_createBlockColMesh(block *block_ptr, block_def *block_def_ptr);
+COL_createBlockColMesh(block_def *block_def_ptr);
 
 void 
 COL_convertBlockToColMesh(COL_MESH *mesh_ptr, block_def *block_def_ptr);
@@ -75,6 +94,23 @@ void
 COL_convertSpriteToColMesh(COL_MESH *mesh_ptr, float minX, float minY, 
 						   float minZ, float maxX, float maxY, float maxZ);
 
+void
+COL_initQuery(COL_QUERY *query_ptr);
+
+void
+COL_gatherQueryMeshes(COL_QUERY *query_ptr, VEC3 *min_ptr, VEC3 *max_ptr);
+
+int
+COL_castRays(COL_QUERY *query_ptr, int rays, VEC3 *origin_list, 
+			 VEC3 *dir_list, COL_HIT *hit_list, bool *hit_flag_list);
+
+bool
+COL_lineOfSight(COL_QUERY *query_ptr, VEC3 *from_ptr, VEC3 *to_ptr);
+
+bool
+COL_boxOverlapsWorld(COL_QUERY *query_ptr, COL_AABOX *box_ptr, 
+					 VEC3 *centre_ptr);
+
 /*--------------------------------------------------------------
 
 	Externs
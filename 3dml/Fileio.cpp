@@ -2827,6 +2827,7 @@ parse_body_tags(void)
 	word block_symbol;
 	tag *tag_ptr;
 	square *square_ptr;
+	square_info *square_info_ptr;
 	trigger *trigger_ptr, *last_trigger_ptr;
 
 	// If the body has been seen before, skip over the rest of this body and
@@ -2934,10 +2935,11 @@ parse_body_tags(void)
 
 			square_ptr = world_ptr->get_square_ptr(exit_location.column,
 				exit_location.row, exit_location.level);
-			if (square_ptr->exit_ptr == NULL) {
-				parse_exit_tag(square_ptr->exit_ptr);
-				if (square_ptr->exit_ptr)
-					square_ptr->exit_ptr->from_block = false;
+			if (square_ptr->info_ptr->exit_ptr == NULL) {
+				square_info_ptr = square_ptr->get_info_ptr();
+				parse_exit_tag(square_info_ptr->exit_ptr);
+				if (square_info_ptr->exit_ptr)
+					square_info_ptr->exit_ptr->from_block = false;
 			}
 			break;
 		case TOKEN_IMAGEMAP:
@@ -2979,11 +2981,7 @@ parse_body_tags(void)
 
 			// Add a copy of the popup to the end of the global popup list.
 
-			if (last_global_popup_ptr)
-				last_global_popup_ptr->next_popup_ptr = popup_ptr;
-			else
-				global_popup_list = popup_ptr;
-			last_global_popup_ptr = popup_ptr;
+			add_popup_to_global_list(popup_ptr);
 
 			// If the location parameter was given, set the popup's scaled
 			// map position, and add the popup to the end of the 
@@ -2996,16 +2994,18 @@ parse_body_tags(void)
 				square_ptr = world_ptr->get_square_ptr(
 					popup_location.column, popup_location.row, 
 					popup_location.level);
-				if (square_ptr->last_popup_ptr)
-					square_ptr->last_popup_ptr->next_square_popup_ptr = 
+				square_info_ptr = square_ptr->get_info_ptr();
+				if (square_info_ptr->last_popup_ptr)
+					square_info_ptr->last_popup_ptr->next_square_popup_ptr = 
 						popup_ptr;
 				else
-					square_ptr->popup_list = popup_ptr;
-				square_ptr->last_popup_ptr = popup_ptr;
+					square_info_ptr->popup_list = popup_ptr;
+				square_info_ptr->last_popup_ptr = popup_ptr;
 
 				// Update the square's popup trigger flags.
 
-				square_ptr->popup_trigger_flags |= popup_ptr->trigger_flags;
+				square_info_ptr->popup_trigger_flags |= 
+					popup_ptr->trigger_flags;
 			} 
 				
 			// Otherwise set the always_visible flag.
@@ -3043,9 +3043,7 @@ parse_body_tags(void)
 				point_light_location.row, point_light_location.level);
 			light_ptr->pos = (light_ptr->pos + translation) * 
 				world_ptr->block_scale;
-			light_ptr->next_light_ptr = global_light_list;
-			global_light_list = light_ptr;
-			global_lights++;
+			add_light_to_global_list(light_ptr);
 			break;
 
 		case TOKEN_SPOT_LIGHT:
@@ -3077,9 +3075,7 @@ parse_body_tags(void)
 				spot_light_location.row, spot_light_location.level);
 			light_ptr->pos = (light_ptr->pos + translation) *
 				world_ptr->block_scale;
-			light_ptr->next_light_ptr = global_light_list;
-			global_light_list = light_ptr;
-			global_lights++;
+			add_light_to_global_list(light_ptr);
 			break;
 
 		case TOKEN_SOUND:
@@ -3111,8 +3107,7 @@ parse_body_tags(void)
 				sound_location.row, sound_location.level);
 			sound_ptr->position = (sound_ptr->position + translation) *
 				world_ptr->block_scale;
-			sound_ptr->next_sound_ptr = global_sound_list;
-			global_sound_list = sound_ptr;
+			add_sound_to_global_list(sound_ptr);
 			break;
 
 		case TOKEN_LEVEL:
@@ -3141,16 +3136,18 @@ parse_body_tags(void)
 
 				// Add the trigger to the end of the square's trigger list.
 
-				last_trigger_ptr = square_ptr->last_square_trigger_ptr;
+				square_info_ptr = square_ptr->get_info_ptr();
+				last_trigger_ptr = square_info_ptr->last_square_trigger_ptr;
 				if (last_trigger_ptr)
 					last_trigger_ptr->next_trigger_ptr = trigger_ptr;
 				else
-					square_ptr->square_trigger_list = trigger_ptr;
-				square_ptr->last_square_trigger_ptr = trigger_ptr;
+					square_info_ptr->square_trigger_list = trigger_ptr;
+				square_info_ptr->last_square_trigger_ptr = trigger_ptr;
 
 				// Update the square's trigger flags.
 
-				square_ptr->square_trigger_flags |= trigger_ptr->trigger_flag;
+				square_info_ptr->square_trigger_flags |= 
+					trigger_ptr->trigger_flag;
 
 				// If this is a "step in", "step out", "proximity", "timer" or
 				// "location" trigger, add a copy of it to the global trigger
@@ -190,6 +190,10 @@ SOURCE=.\Plugin.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\Profile.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\real.cpp
 # End Source File
 # Begin Source File
@@ -358,6 +362,10 @@ SOURCE=.\Plugin.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\Profile.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Real.h
 # End Source File
 # Begin Source File
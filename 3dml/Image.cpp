@@ -127,10 +127,8 @@ static RGBcolour global_colourmap[256];
 #define RESTORE_PREV_IMAGE	3
 
 static int
-    BitOffset = 0,				// Bit Offset of next code.
     XC = 0, YC = 0,				// Output X and Y coords of current pixel.
     Pass = 0,					// Used by output routine if interlaced pic.
-    OutCount = 0,				// Decompressor output 'stack count'.
     Width, Height,				// Image dimensions.
 	BufferWidth, BufferHeight,	// Image buffer dimensions.
     LeftOffset, TopOffset,		// Image offset.
@@ -152,15 +150,23 @@ static int
 static bool Interlaced;			// Interlaced image flag.
 static imagebyte *ImagePtr;		// Pointer to current image array.
 static int ImageSize;			// Size of current image array.			
+static imagebyte *RowPtr;		// Pointer to current row in image array.
+
+// The starting row and row step of each interlace pass.
+
+static int PassStart[4] = { 0, 4, 2, 1 };
+static int PassStep[4] = { 8, 8, 4, 2 };
 
 // The hash table used by the decompressor.
 
 static int Prefix[4096];
 static int Suffix[4096];
 
-// An output array used by the decompressor.
+// An output array used by the decompressor.  Strings are stacked from the end
+// of the array towards the start, so that they end up in display order.
 
-static int OutCode[1025];
+#define MAX_OUT_CODES	4096
+static imagebyte OutCode[MAX_OUT_CODES];
 
 // The legal GIF headers.
 
@@ -187,12 +193,16 @@ static int transparent_index;
 
 static bool texture_loops;
 
-// Block buffer, size, index and number of bits in current block byte.
+// Block buffer, size and index, the bit buffer holding bits read from the
+// block that have yet to be consumed, the number of bits in the bit buffer,
+// and a flag indicating the block terminator has been read.
 
 static byte block[255];
 static byte block_size;
 static byte block_index;
-static int bits;
+static unsigned int bit_buffer;
+static int bit_count;
+static bool end_of_blocks;
 
 //------------------------------------------------------------------------------
 // JPG loader definitions and variables.
@@ -212,6 +222,25 @@ typedef my_source_mgr *my_src_ptr;
 
 #define INPUT_BUF_SIZE  4096
 
+// Tables for converting JPEG samples directly into texture pixels.  The pixel
+// tables hold the texture pixel bits for each red, green and blue component
+// value; the chroma tables hold the YCbCr to RGB terms in 16-bit fixed point;
+// and the range limit table clamps a component to 0-255 when indexed by the
+// component value plus 256.
+
+#define SCALE_BITS	16
+#define ONE_HALF	(1 << (SCALE_BITS - 1))
+#define FIX(x)		((int)((x) * (1 << SCALE_BITS) + 0.5))
+
+static pixel red_pixel_table[256];
+static pixel green_pixel_table[256];
+static pixel blue_pixel_table[256];
+static int Cr_red_table[256];
+static int Cb_blue_table[256];
+static int Cr_green_table[256];
+static int Cb_green_table[256];
+static byte range_limit_table[768];
+
 //==============================================================================
 // Common functions.
 //==============================================================================
@@ -326,118 +355,90 @@ read_block(byte *buffer_ptr, int bytes)
 }
 
 //------------------------------------------------------------------------------
-// Read the next code bit from the table-based image data.
+// Read the next code from the table-based image data.  Whole bytes are shifted
+// into the bit buffer until it holds enough bits for a code, and the code is
+// then taken from the bottom of the buffer in one step.  If the block
+// terminator is reached before an EOF code, the EOF code is returned.
 //------------------------------------------------------------------------------
 
 static int
-read_code_bit(int bit_pos)
+read_code(void)
 {
-	int code_bit;
-
-	// If we have reached the end of the current block, read the next block
-	// and reset the block index and number of bits in current byte.
-
-	if (block_index == block_size) {
-		block_size = read_byte();
-		read_block(block, block_size);
-		block_index = 0;
-		bits = 8;
-	}
-
-	// Extract the next code bit and shift it to the requested bit position.
+	int code;
 
-	code_bit = (int)(block[block_index] & 1) << bit_pos;
+	while (bit_count < CodeSize) {
 
-	// Shift the bits in the current block byte right one position; if the byte
-	// is empty, move onto the next.
+		// If we have reached the end of the current block, read the next
+		// block and reset the block index.
 
-	bits--;
-	if (bits > 0)
-		block[block_index] >>= 1;
-	else {
-		block_index++;
-		bits = 8;
+		if (block_index == block_size) {
+			if (end_of_blocks || (block_size = read_byte()) == 0) {
+				end_of_blocks = true;
+				return(EOFCode);
+			}
+			read_block(block, block_size);
+			block_index = 0;
+		}
+		bit_buffer |= (unsigned int)block[block_index++] << bit_count;
+		bit_count += 8;
 	}
-
-	// Return code bit.
-
-	return(code_bit);
+	code = (int)(bit_buffer & ((1 << CodeSize) - 1));
+	bit_buffer >>= CodeSize;
+	bit_count -= CodeSize;
+	return(code);
 }
 
 //------------------------------------------------------------------------------
-// Read the next code from the table-based image data.
+// Move onto the next row of the image, dealing with the interlace as
+// described in the GIF spec if necessary.  YC is set to the image height once
+// the last row has been written.
 //------------------------------------------------------------------------------
 
-static int
-read_code(void)
+static void
+next_row(void)
 {
-	int code, bit_pos;
-
-	code = 0;
-	for (bit_pos = 0; bit_pos < CodeSize; bit_pos++)
-		code |= read_code_bit(bit_pos);
-	return(code);
+	XC = 0;
+	if (!Interlaced)
+		YC++;
+	else {
+		YC += PassStep[Pass];
+		while (YC >= Height && Pass < 3) {
+			Pass++;
+			YC = PassStart[Pass];
+		}
+	}
+	if (YC >= Height)
+		YC = Height;
+	else
+		RowPtr = ImagePtr + (TopOffset + YC) * BufferWidth + LeftOffset;
 }
 
 //------------------------------------------------------------------------------
-// Add a pixel to the image buffer.
+// Add a string of pixels to the image buffer.  The string is split into runs
+// that fit on the current row, and each run is copied in one go unless some
+// of its pixels may be the transparent colour.
 //------------------------------------------------------------------------------
 
 static void
-AddToPixel(byte Index)
+add_pixels(imagebyte *pixel_ptr, int pixels)
 {
-	// Sanity check the pixel coordinates.
-
-	if (TopOffset + YC >= BufferHeight ||
-		LeftOffset + XC >= BufferWidth)
-		return;
-
-	// Store the pixel value at (XC + LeftOffset, YC + TopOffset), provided it
-	// isn't the transparent colour.
-
-	if ((int)Index != transparent_index)
-		*(ImagePtr + ((TopOffset + YC) * BufferWidth) + (LeftOffset + XC)) = 
-			Index;
-
-	// Update the X-coordinate, and if it overflows, update the
-	// Y-coordinate.  If a non-interlaced picture, just increment YC to the
-	// next scan line. If it's interlaced, deal with the interlace as
-	// described in the GIF spec.  Put the decoded scan line out to the
-	// image buffer if we haven't gone past the bottom of it.
-
-	XC++;
-	if (XC == Width) {
-		XC = 0;
-		if (!Interlaced)
-			YC++;
+	int run, index;
+
+	while (pixels > 0 && YC < Height) {
+		run = MIN(pixels, Width - XC);
+		if (transparent_index < 0)
+			memcpy(RowPtr + XC, pixel_ptr, run);
 		else {
-			switch (Pass) {
-			case 0:
-				YC += 8;
-				if (YC >= Height) {
-					Pass++;
-					YC = 4;
-				}
-				break;
-			case 1:
-				YC += 8;
-				if (YC >= Height) {
-					Pass++;
-					YC = 2;
-				}
-				break;
-			case 2:
-				YC += 4;
-				if (YC >= Height) {
-					Pass++;
-					YC = 1;
-				}
-				break;
-			case 3:
-				YC += 2;
-	    	}
+			for (index = 0; index < run; index++)
+				if ((int)pixel_ptr[index] != transparent_index)
+					RowPtr[XC + index] = pixel_ptr[index];
 		}
-    }
+		XC += run;
+		pixel_ptr += run;
+		pixels -= run;
+		if (XC == Width)
+			next_row();
+	}
 }
 
 //------------------------------------------------------------------------------
@@ -518,7 +519,7 @@ read_GIF_image(void)
 {
 	pixmap *pixmap_ptr;
 	byte *prev_image_ptr;
-	int index;
+	imagebyte *out_ptr;
 
 	// Get a pointer to the current pixmap.
 
@@ -529,9 +530,11 @@ read_GIF_image(void)
 	XC = 0;
 	YC = 0;
 	Pass = 0;
-	OutCount = 0;
 	block_size = 0;
 	block_index = 0;
+	bit_buffer = 0;
+	bit_count = 0;
+	end_of_blocks = false;
 	
 	// Set the transparent index and delay time for this pixmap.  The 
 	// transparent flag is also set to indicate at least one pixmap has 
@@ -628,11 +631,19 @@ read_GIF_image(void)
 	InitCodeSize = CodeSize;
 	MaxCode = 1 << CodeSize;
 
-	// Decompress the file, continuing until you see the GIF EOF code.
-	// One obvious enhancement is to add checking for corrupt files here.
+	// Set the pointer to the first row of the image.  An empty image has no
+	// rows to write.
+
+	if (Width == 0 || Height == 0)
+		YC = Height;
+	else
+		RowPtr = ImagePtr + TopOffset * BufferWidth + LeftOffset;
+
+	// Decompress the file, continuing until you see the GIF EOF code, or
+	// the last row of the image has been written.
 
 	Code = read_code();
-	while (Code != EOFCode) {
+	while (Code != EOFCode && YC < Height) {
 
 		// Clear code sets everything back to its initial value, then
 		// reads the immediately subsequent code as uncompressed data.
@@ -642,15 +653,13 @@ read_GIF_image(void)
 			MaxCode  = 1 << CodeSize;
 			FreeCode = FirstFree;
 			Code = read_code();
+			if (Code == EOFCode)
+				break;
 			CurCode = Code;
 			OldCode = Code;
 			FinChar = CurCode & BitMask;
-			AddToPixel((byte)FinChar);
-
-			// XXX -- This is a sanity check in case an EOF code is not found.
-
-			if (YC == Height)
-				break;
+			OutCode[0] = (imagebyte)FinChar;
+			add_pixels(OutCode, 1);
 		}
 
 		// If not a clear code, then must be data: save same as CurCode
@@ -659,59 +668,55 @@ read_GIF_image(void)
 		 else {
 			InCode = Code;
 			CurCode = Code;
+			out_ptr = OutCode + MAX_OUT_CODES;
 
 			// If greater or equal to FreeCode, not in the hash
 			// table yet; repeat the last character decoded.
 
 			if (CurCode >= FreeCode) {
 				CurCode = OldCode;
-				OutCode[OutCount++] = FinChar;
+				*--out_ptr = (imagebyte)FinChar;
 			}
 
 			// Unless this code is raw data, pursue the chain
 			// pointed to by CurCode through the hash table to its
 			// end; each code in the chain puts its associated
-			// output code on the output queue.
+			// output code on the output stack, which fills from the end.
 	
 	    	while (CurCode > BitMask) {
-				if (OutCount > 1024)
+				if (out_ptr == OutCode)
 					image_error("Corrupt GIF file");
-				OutCode[OutCount++] = Suffix[CurCode];
+				*--out_ptr = (imagebyte)Suffix[CurCode];
 				CurCode = Prefix[CurCode];
 			}
 
 			// The last code in the chain is treated as raw data.
 
+			if (out_ptr == OutCode)
+				image_error("Corrupt GIF file");
 			FinChar = CurCode & BitMask;
-			OutCode[OutCount++] = FinChar;
+			*--out_ptr = (imagebyte)FinChar;
 
-			// Now we put the data out to the Output routine.
-			// It's been stacked LIFO, so deal with it that way...
-			// XXX -- I'm checking for YC reaching it's maximum value as a
-			// sanity check, in case an EOF code is not seen.
+			// Now the whole string is in display order, so put it out to
+			// the image buffer in row-sized runs.
 
-			for (index = OutCount - 1; index >= 0; index--) {
-				AddToPixel((byte)OutCode[index]);
-				if (YC == Height)
-					break;
-			}
-			if (YC == Height)
-				break;
-			OutCount = 0;
+			add_pixels(out_ptr, OutCode + MAX_OUT_CODES - out_ptr);
 
 			// Build the hash table on-the-fly. No table is stored
-			// in the file.
+			// in the file.  Once the table is full, no more entries are
+			// added until the next CLEAR code.
 
-			Prefix[FreeCode] = OldCode;
-			Suffix[FreeCode] = FinChar;
+			if (FreeCode < 4096) {
+				Prefix[FreeCode] = OldCode;
+				Suffix[FreeCode] = FinChar;
+				FreeCode++;
+			}
 			OldCode = InCode;
 
-			// Point to the next slot in the table.  If we exceed
-			// the current MaxCode value, increment the code size
-			// unless it's already 12.  If it is, do nothing: the 
+			// If we exceed the current MaxCode value, increment the code
+			// size unless it's already 12.  If it is, do nothing: the 
 			// next code decompressed better be CLEAR.
 
-			FreeCode++;
 			if (FreeCode >= MaxCode && CodeSize < 12) {
 				CodeSize++;
 				MaxCode *= 2;
@@ -720,12 +725,14 @@ read_GIF_image(void)
 		Code = read_code();
 	}
 
-	// Skip over any remaining data blocks that were not parsed.
+	// Skip over any remaining data blocks that were not parsed, unless the
+	// block terminator has already been read.
 	// XXX -- This is a sanity check; there should only be a zero-length
 	// block here.
 
-	while ((ch = read_byte()) != 0)
-		read_block(block, ch);
+	if (!end_of_blocks)
+		while ((ch = read_byte()) != 0)
+			read_block(block, ch);
 }
 
 //------------------------------------------------------------------------------
@@ -972,19 +979,54 @@ jpeg_src(j_decompress_ptr cinfo)
 }
 
 //------------------------------------------------------------------------------
-// Load a JPEG file.
+// Initialise the tables used to convert JPEG samples into texture pixels.  The
+// texture pixel format packs each component separately, so the pixel for any
+// colour is the bitwise OR of its component pixels.
 //------------------------------------------------------------------------------
 
 static void
-load_JPEG(void)
+init_JPEG_tables(void)
+{
+	RGBcolour colour;
+	int index, value;
+
+	for (index = 0; index < 256; index++) {
+		colour.set_RGB((float)index, 0.0f, 0.0f);
+		red_pixel_table[index] = RGB_to_texture_pixel(colour);
+		colour.set_RGB(0.0f, (float)index, 0.0f);
+		green_pixel_table[index] = RGB_to_texture_pixel(colour);
+		colour.set_RGB(0.0f, 0.0f, (float)index);
+		blue_pixel_table[index] = RGB_to_texture_pixel(colour);
+		value = index - 128;
+		Cr_red_table[index] = (FIX(1.40200) * value + ONE_HALF) >> SCALE_BITS;
+		Cb_blue_table[index] = (FIX(1.77200) * value + ONE_HALF) >> SCALE_BITS;
+		Cr_green_table[index] = -FIX(0.71414) * value;
+		Cb_green_table[index] = -FIX(0.34414) * value + ONE_HALF;
+	}
+	for (index = 0; index < 768; index++) {
+		value = index - 256;
+		range_limit_table[index] = (byte)MAX(MIN(value, 255), 0);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Load a JPEG file, scaling it down to fit within 256x256 pixels if its size
+// is limited.
+//------------------------------------------------------------------------------
+
+static void
+load_JPEG(bool unlimited_size)
 {
 	struct jpeg_decompress_struct cinfo;
 	struct jpeg_error_mgr jerr;
 	JSAMPARRAY scan_line;
-	imagebyte *buffer_ptr, *image_ptr;
-	RGBcolour colour;
+	JSAMPROW sample_ptr;
+	imagebyte *buffer_ptr;
+	word *image_ptr;
+	byte *range_limit_ptr;
 	int buffer_size;
 	int row, col;
+	int y, Cb, Cr;
 
 	// Initialise the number of pixmaps loaded, the transparent flag, and the
 	// loop flag.
@@ -1018,25 +1060,45 @@ load_JPEG(void)
 		// Obtain image info.
 
 		jpeg_read_header(&cinfo, TRUE);
-		image_width = cinfo.image_width;
-		image_height = cinfo.image_height;
 
 		// Select decompression parameters
 		
 		cinfo.quantize_colors = FALSE;
 
-		// Begin decompression.
+		// Use the fast integer inverse DCT; its loss of accuracy is well
+		// below what survives conversion to 5 bits per component.  Colour
+		// images are left in YCbCr, since the conversion to RGB is done
+		// together with the conversion to texture pixels below.
+
+		cinfo.dct_method = JDCT_IFAST;
+		if (cinfo.jpeg_color_space == JCS_YCbCr)
+			cinfo.out_color_space = JCS_YCbCr;
+
+		// If unlimited_size is FALSE and the image has a width or height
+		// greater than 256 pixels, have the decompressor scale it down by the
+		// smallest power of two (up to 1/8) that will make it fit.  Scaling
+		// is done in the inverse DCT, so this is much cheaper than decoding
+		// the image at full size.
+
+		if (!unlimited_size) {
+			cinfo.scale_num = 1;
+			cinfo.scale_denom = 1;
+			while (cinfo.scale_denom < 8 &&
+				(cinfo.image_width > 256 * cinfo.scale_denom ||
+				 cinfo.image_height > 256 * cinfo.scale_denom))
+				cinfo.scale_denom *= 2;
+		}
+
+		// Begin decompression, and obtain the dimensions of the scaled image.
 
 		jpeg_start_decompress(&cinfo);
+		image_width = cinfo.output_width;
+		image_height = cinfo.output_height;
 
 		// Allocate the scan line buffer.
 
-		if (cinfo.jpeg_color_space == JCS_GRAYSCALE)
-			scan_line = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, 
-				JPOOL_IMAGE, image_width, 1);
-		else
-			scan_line = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, 
-				JPOOL_IMAGE, image_width * 3, 1);
+		scan_line = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, 
+			JPOOL_IMAGE, image_width * cinfo.output_components, 1);
 
 		// Allocate the image buffer.
 
@@ -1046,20 +1108,41 @@ load_JPEG(void)
 			image_memory_error("JPEG image");
 
 		// Read the pixel components one scan line at a time, and convert them
-		// to 16-bit pixels in texture pixel format.
+		// to 16-bit pixels in texture pixel format using the lookup tables.
 
-		image_ptr = buffer_ptr;
+		init_JPEG_tables();
+		range_limit_ptr = range_limit_table + 256;
+		image_ptr = (word *)buffer_ptr;
 		for (row = 0; row < image_height; row++) {
 			jpeg_read_scanlines(&cinfo, scan_line, 1);
-			for (col = 0; col < image_width; col++) {
-				if (cinfo.jpeg_color_space == JCS_GRAYSCALE)
-					colour.set_RGB(scan_line[0][col], scan_line[0][col],
-						scan_line[0][col]);
-				else
-					colour.set_RGB(scan_line[0][col * 3], 
-						scan_line[0][col * 3 + 1], scan_line[0][col * 3 + 2]);
-				*(word *)image_ptr = RGB_to_texture_pixel(colour);
-				image_ptr += 2;
+			sample_ptr = scan_line[0];
+			switch (cinfo.out_color_space) {
+			case JCS_GRAYSCALE:
+				for (col = 0; col < image_width; col++) {
+					y = *sample_ptr++;
+					*image_ptr++ = (word)(red_pixel_table[y] | 
+						green_pixel_table[y] | blue_pixel_table[y]);
+				}
+				break;
+			case JCS_YCbCr:
+				for (col = 0; col < image_width; col++) {
+					y = sample_ptr[0];
+					Cb = sample_ptr[1];
+					Cr = sample_ptr[2];
+					sample_ptr += 3;
+					*image_ptr++ = (word)(red_pixel_table[range_limit_ptr[y +
+						Cr_red_table[Cr]]] | green_pixel_table[range_limit_ptr[y + 
+						((Cb_green_table[Cb] + Cr_green_table[Cr]) >> SCALE_BITS)]] |
+						blue_pixel_table[range_limit_ptr[y + Cb_blue_table[Cb]]]);
+				}
+				break;
+			default:
+				for (col = 0; col < image_width; col++) {
+					*image_ptr++ = (word)(red_pixel_table[sample_ptr[0]] |
+						green_pixel_table[sample_ptr[1]] | 
+						blue_pixel_table[sample_ptr[2]]);
+					sample_ptr += cinfo.output_components;
+				}
 			}
 		}
 
@@ -1126,7 +1209,7 @@ load_image(char *URL, char *file_path, texture *texture_ptr,
 	catch (char *) {
 		try {
 			rewind_file();
-			load_JPEG();
+			load_JPEG(unlimited_size);
 			texture_ptr->is_16_bit = true;
 		}
 		catch (char *) {
@@ -1145,7 +1228,8 @@ load_image(char *URL, char *file_path, texture *texture_ptr,
 	try {
 
 		// If unlimited_size is FALSE, and the texture width or height is 
-		// greater than 256 pixels, this is an error.
+		// greater than 256 pixels, this is an error.  JPEG images will
+		// already have been scaled down to fit, if possible.
 
 		if (!unlimited_size && (image_width > 256 || image_height > 256))
 			image_error("Image has a width or height greater than 256 pixels");
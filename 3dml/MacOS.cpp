@@ -18,6 +18,7 @@
 #include <Resources.h>
 #include <TextUtils.h>
 #include <Fonts.h>
+#include <Timer.h>
 #include "Classes.h"
 #include "Image.h"
 #include "Main.h"
@@ -25,6 +26,7 @@
 #include "Parser.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Profile.h"
 #include "Render.h"
 #include "Spans.h"
 #include "Utils.h"
@@ -2896,6 +2898,27 @@ get_time_ms(void)
 	return((int)(((float)clock() / CLOCKS_PER_SEC) * 1000.0f));
 }
 
+//------------------------------------------------------------------------------
+// Return the current value of the high resolution timer, and the number of
+// ticks it counts per second.  The microsecond timer is used rather than
+// clock(), since the latter measures processor time rather than elapsed time.
+//------------------------------------------------------------------------------
+
+__int64
+get_time_ticks(void)
+{
+	UnsignedWide microseconds;
+
+	Microseconds(&microseconds);
+	return(((__int64)microseconds.hi << 32) | (__int64)microseconds.lo);
+}
+
+__int64
+get_ticks_per_second(void)
+{
+	return(1000000);
+}
+
 //------------------------------------------------------------------------------
 // Load wave data into a wave object.
 //------------------------------------------------------------------------------
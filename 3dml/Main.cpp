@@ -37,6 +37,7 @@
 #include "Spans.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Profile.h"
 #include "Utils.h"
 
 // Version string.
@@ -49,6 +50,26 @@
 #define USER_REQUESTED_UPDATE			1	
 #define SPOT_REQUESTED_UPDATE			2
 
+// Maximum number of collision meshes checked against the player per sweep,
+// and the maximum number of pieces a player's trajectory is split into when
+// it overlaps more meshes than that.
+
+#define MAX_COL_MESHES					512
+#define MAX_SWEEP_PIECES				8
+
+// Maximum number of sounds checked for occlusion per frame.
+
+#define MAX_OCCLUSION_RAYS				64
+
+// Number of frames rendered before the frame loop is expected to stop
+// allocating memory.
+
+#define STEADY_STATE_FRAMES				30
+
+// Number of milliseconds to sleep after displaying a reused frame.
+
+#define REUSED_FRAME_DELAY_MS			10
+
 // Predefined URLs.
 
 #define UPDATE_URL			"http://download.flatland.com/update/update.zip"
@@ -132,9 +153,10 @@ vertex frustum_vertex_list[FRUSTUM_VERTICES];
 byte *frame_buffer_ptr;
 int frame_buffer_width;
 
-// Span buffer.
+// Span buffer, and flag indicating whether the overdraw display is on.
 
 span_buffer *span_buffer_ptr;
+bool overdraw_mode;
 
 // Pointer to old and current blockset list, and custom blockset.
 
@@ -201,10 +223,29 @@ popup *original_popup_list;
 popup *global_popup_list;
 popup *last_global_popup_ptr;
 
-// Global ist of triggers.
+// Global ist of triggers, and the ordinal to give the next trigger added to it.
 
 trigger *global_trigger_list;
 trigger *last_global_trigger_ptr;
+int next_trigger_ordinal;
+
+// Index of the global trigger list.  "Step in", "step out" and "proximity"
+// triggers are hashed by every map square their radius overlaps; those whose
+// radius covers too many squares to be worth indexing go into a separate list
+// that is always tested.  The inside list holds the "step in" and "step out"
+// triggers whose radius the player was inside during the last frame.  "Timer"
+// triggers are kept in a min-heap ordered by expiry time.  "Location" triggers
+// whose target matches their own square have a list of their own; all other
+// "location" triggers can never activate.
+
+trigger_ref *trigger_bucket_list[TRIGGER_BUCKETS];
+trigger_ref *large_trigger_list;
+trigger_ref *inside_trigger_list;
+trigger **timer_heap;
+int timer_heap_size;
+int max_timer_heap_size;
+trigger_ref *location_trigger_list;
+int curr_trigger_frame;
 
 // Placeholder texture.
 
@@ -241,6 +282,12 @@ float player_step_height;
 int start_time_ms, curr_time_ms;
 int frames_rendered, total_polygons_rendered;
 
+// Time the last frame started in high resolution timer ticks, and the time
+// between frames in milliseconds.
+
+static __int64 frame_start_ticks;
+static frame_stat frame_time_stat("frame_ms");
+
 // Current mouse position.
 
 int mouse_x;
@@ -333,9 +380,19 @@ static const char *curr_link_URL;
 // Collision data.
 
 static float player_fall_delta;
-static COL_MESH *col_mesh_list[512];
-static VEC3 mesh_pos_list[512];
+static COL_MESH *col_mesh_list[MAX_COL_MESHES];
+static VEC3 mesh_pos_list[MAX_COL_MESHES];
 static int col_meshes;
+static bool col_mesh_list_overflowed;
+
+// Sound occlusion data.
+
+static COL_QUERY occlusion_query;
+static VEC3 occlusion_origin_list[MAX_OCCLUSION_RAYS];
+static VEC3 occlusion_dir_list[MAX_OCCLUSION_RAYS];
+static COL_HIT occlusion_hit_list[MAX_OCCLUSION_RAYS];
+static bool occlusion_hit_flag_list[MAX_OCCLUSION_RAYS];
+static sound *occlusion_sound_list[MAX_OCCLUSION_RAYS];
 
 // Flag indicating if the trajectory is tilted.
 
@@ -452,6 +509,10 @@ log_stats(void)
 		diagnose("Average polygon rate was %f polygons per second",
 			(float)total_polygons_rendered / elapsed_time);
 	}
+
+	// Log the profile sums and export the profile zones.
+
+	report_profile();
 }
 
 //------------------------------------------------------------------------------
@@ -573,6 +634,58 @@ update_all_lights(float elapsed_time)
 	END_TIMING("update_all_lights");
 }
 
+//------------------------------------------------------------------------------
+// Determine which sounds are hidden from the player by solid blocks, by
+// casting a ray from the player's eye towards each sound in range.  Each ray
+// stops half a block short of the sound, so that the block a sound comes from
+// doesn't hide it.
+//------------------------------------------------------------------------------
+
+static void
+update_sound_occlusion(void)
+{
+	sound *sound_ptr;
+	vector ray;
+	float length;
+	int rays, ray_no;
+
+	// Set up a ray for each non-ambient sound in range that isn't a flood
+	// sound, since those play at full volume anyway.
+
+	rays = 0;
+	sound_ptr = global_sound_list;
+	while (sound_ptr) {
+		sound_ptr->occluded = false;
+		if (!sound_ptr->ambient && !sound_ptr->flood &&
+			rays < MAX_OCCLUSION_RAYS) {
+			ray = sound_ptr->position - player_viewpoint.position;
+			length = ray.length();
+			if (FGT(length, world_ptr->half_block_units) &&
+				FLE(length, audio_radius)) {
+				ray = ray * (length - world_ptr->half_block_units);
+				occlusion_origin_list[rays].x = player_viewpoint.position.x;
+				occlusion_origin_list[rays].y = player_viewpoint.position.y;
+				occlusion_origin_list[rays].z = player_viewpoint.position.z;
+				occlusion_dir_list[rays].x = ray.dx;
+				occlusion_dir_list[rays].y = ray.dy;
+				occlusion_dir_list[rays].z = ray.dz;
+				occlusion_sound_list[rays] = sound_ptr;
+				rays++;
+			}
+		}
+		sound_ptr = sound_ptr->next_sound_ptr;
+	}
+
+	// Cast the rays as one batch, and mark the sounds whose ray hit
+	// something as occluded.
+
+	COL_castRays(&occlusion_query, rays, occlusion_origin_list,
+		occlusion_dir_list, occlusion_hit_list, occlusion_hit_flag_list);
+	for (ray_no = 0; ray_no < rays; ray_no++)
+		occlusion_sound_list[ray_no]->occluded =
+			occlusion_hit_flag_list[ray_no];
+}
+
 //------------------------------------------------------------------------------
 // Update all sounds.
 //------------------------------------------------------------------------------
@@ -584,8 +697,9 @@ update_all_sounds(void)
 
 	START_TIMING;
 
-	// Begin the sound update.
+	// Determine which sounds are occluded, then begin the sound update.
 
+	update_sound_occlusion();
 	begin_sound_update();
 
 	// Update all non-streaming sounds in global sound list.
@@ -665,10 +779,10 @@ free_spot_data(void)
 		movable_block_list = block_def_ptr->del_block(movable_block_list);
 	}
 
-	// Delete all entrances in the global entrance list.
+	// Clear the global entrance list; the entrances themselves are deleted
+	// along with the free entrance list.
 
-	while (global_entrance_list)
-		global_entrance_list = del_entrance(global_entrance_list);
+	global_entrance_list = NULL;
 
 	// Delete all imagemaps.
 
@@ -678,10 +792,10 @@ free_spot_data(void)
 		imagemap_list = next_imagemap_ptr;
 	}
 
-	// Delete all lights in the global light list.
+	// Clear the global light list; the lights themselves are deleted along
+	// with the free light list.
 
-	while (global_light_list)
-		global_light_list = del_light(global_light_list);
+	global_light_list = NULL;
 
 	// Delete the orb light.
 
@@ -692,10 +806,10 @@ free_spot_data(void)
 
 	stop_all_sounds();
 
-	// Delete all sounds in global sound list.
+	// Clear the global sound list; the sounds themselves are deleted along
+	// with the free sound list.
 
-	while (global_sound_list)
-		global_sound_list = del_sound(global_sound_list);
+	global_sound_list = NULL;
 
 	// Delete ambient sound.
 
@@ -707,10 +821,10 @@ free_spot_data(void)
 	if (streaming_sound_ptr)
 		delete streaming_sound_ptr;
 
-	// Delete all popups in global popup list.
+	// Clear the global popup list; the popups themselves are deleted along
+	// with the free popup list.
 
-	while (global_popup_list)
-		global_popup_list = del_popup(global_popup_list);
+	global_popup_list = NULL;
 
 	// Delete all popups in original popup list, as well as their foreground
 	// textures.
@@ -728,15 +842,24 @@ free_spot_data(void)
 	if (onload_exit_ptr)
 		DEL(onload_exit_ptr, hyperlink);
 
-	// Delete all global triggers.
+	// Delete the trigger index, and clear the global trigger list.
+
+	delete_trigger_index();
+	global_trigger_list = NULL;
+
+	// Delete the list of squares used to batch block replacements.
 
-	while (global_trigger_list)
-		global_trigger_list = del_trigger(global_trigger_list);
+	delete_dirty_square_list();
 
-	// Delete the free lists of triggers, hyperlinks, lights, sounds,
-	// locations, entrances and popups.
+	// Delete the free lists of triggers, trigger references, hyperlinks,
+	// lights, sounds, locations, entrances and popups.  This deletes every
+	// object of these types that was allocated for the spot, whether or not
+	// it is still in use, so it must be done after the map and the global
+	// lists have been deleted.  Entrances must be deleted before locations,
+	// since deleting an entrance releases its locations.
 
 	delete_free_trigger_list();
+	delete_free_trigger_ref_list();
 	delete_free_hyperlink_list();
 	delete_free_light_list();
 	delete_free_sound_list();
@@ -782,14 +905,19 @@ init_spot_data(void)
 	curr_area_square_ptr = NULL;
 	curr_popup_square_ptr = NULL;
 
+	// Make sure a frame cached from the previous spot is not displayed.
+
+	invalidate_frame_cache();
+
 	// Hide any label that may be visible.
 
 	hide_label();
 
-	// Initialise the list of free triggers, hyperlinks, lights, sounds,
-	// locations, entrances and popups.
+	// Initialise the list of free triggers, trigger references, hyperlinks,
+	// lights, sounds, locations, entrances and popups.
 
 	init_free_trigger_list();
+	init_free_trigger_ref_list();
 	init_free_hyperlink_list();
 	init_free_light_list();
 	init_free_sound_list();
@@ -847,10 +975,20 @@ init_spot_data(void)
 	global_popup_list = NULL;
 	last_global_popup_ptr = NULL;
 
-	// Initialise global trigger list.
+	// Initialise global trigger list and the trigger index.
 
 	global_trigger_list = NULL;
 	last_global_trigger_ptr = NULL;
+	next_trigger_ordinal = 0;
+	for (int bucket = 0; bucket < TRIGGER_BUCKETS; bucket++)
+		trigger_bucket_list[bucket] = NULL;
+	large_trigger_list = NULL;
+	inside_trigger_list = NULL;
+	timer_heap = NULL;
+	timer_heap_size = 0;
+	max_timer_heap_size = 0;
+	location_trigger_list = NULL;
+	curr_trigger_frame = 0;
 
 	// Initialise player block and the movable block list.
 
@@ -923,6 +1061,10 @@ teleport(const char *entrance_name, bool history_entry_selected)
 
 	if (!history_entry_selected)
 		player_was_teleported = true;
+
+	// The player viewpoint has moved, so the cached frame is out of date.
+
+	invalidate_frame_cache();
 }
 
 //------------------------------------------------------------------------------
@@ -1339,8 +1481,9 @@ check_for_mouse_selection(void)
 
 		label_shown = false;
 		if ((curr_selected_square_ptr && 
-			 ((curr_selected_square_ptr->block_trigger_flags & CLICK_ON) ||
-			  (curr_selected_square_ptr->square_trigger_flags & CLICK_ON))) ||
+			 ((BLOCK_TRIGGER_FLAGS(curr_selected_square_ptr) & CLICK_ON) ||
+			  (curr_selected_square_ptr->info_ptr->square_trigger_flags & 
+			   CLICK_ON))) ||
 			(curr_selected_area_ptr && 
 			 (curr_selected_area_ptr->trigger_flags & CLICK_ON)) ||
 			(curr_selected_exit_ptr &&
@@ -1365,10 +1508,10 @@ check_for_mouse_selection(void)
 			// triggers has a label, show it (a block trigger takes precedence).
 
 			else if (curr_selected_square_ptr && show_trigger_label(
-				curr_selected_square_ptr->block_trigger_list))
+				BLOCK_TRIGGER_LIST(curr_selected_square_ptr)))
 				label_shown = true;
 			else if (curr_selected_square_ptr && show_trigger_label(
-				curr_selected_square_ptr->square_trigger_list))
+				curr_selected_square_ptr->info_ptr->square_trigger_list))
 				label_shown = true;
 
 			// Otherwise if there is a currently selected area and one of it's
@@ -1394,12 +1537,32 @@ check_for_mouse_selection(void)
 	}
 }
 
+//------------------------------------------------------------------------------
+// Add a block's collision mesh to the list of meshes to check for collisions,
+// if there is room.
+//------------------------------------------------------------------------------
+
+static bool
+add_col_mesh(block *block_ptr)
+{
+	if (col_meshes == MAX_COL_MESHES)
+		return(false);
+	col_mesh_list[col_meshes] = block_ptr->col_mesh_ptr;
+	mesh_pos_list[col_meshes].x = block_ptr->translation.x;
+	mesh_pos_list[col_meshes].y = block_ptr->translation.y;
+	mesh_pos_list[col_meshes].z = block_ptr->translation.z;
+	col_meshes++;
+	return(true);
+}
+
 //------------------------------------------------------------------------------
 // Create a list of blocks that overlap the bounding box of a new player
-// position.
+// position.  Movable blocks are added first, so that if the list fills up it
+// is static blocks that are left out.  Returns FALSE if any blocks were left
+// out.
 //------------------------------------------------------------------------------
 
-static void
+static bool
 get_overlapping_blocks(float x, float y, float z, 
 					   float old_x, float old_y, float old_z)
 {
@@ -1434,27 +1597,10 @@ get_overlapping_blocks(float x, float y, float z,
 	if (min_level > 0)
 		min_level--;
 
-	// Step through the range of overlapping blocks and add them to a list of
-	// blocks to check for collisions.
-
-	col_meshes = 0;
-	for (level = min_level; level <= max_level; level++)
-		for (row = min_row; row <= max_row; row++)
-			for (column = min_column; column <= max_column; column++)
-				if ((block_ptr = world_ptr->get_block_ptr(column, row, level))
-					!= NULL) {
-					if (block_ptr->solid && block_ptr->col_mesh_ptr != NULL) {
-						col_mesh_list[col_meshes] = block_ptr->col_mesh_ptr;
-						mesh_pos_list[col_meshes].x = block_ptr->translation.x;
-						mesh_pos_list[col_meshes].y = block_ptr->translation.y;
-						mesh_pos_list[col_meshes].z = block_ptr->translation.z;
-						col_meshes++;
-					}
-				}
-
 	// Step through the list of movable blocks, and add them to the list of
 	// blocks to check for collisions.
 
+	col_meshes = 0;
 	block_ptr = movable_block_list;
 	while (block_ptr) {
 		if (block_ptr->solid && block_ptr->col_mesh_ptr != NULL) {
@@ -1467,95 +1613,105 @@ get_overlapping_blocks(float x, float y, float z,
 			max_bbox.z = col_mesh_ptr->maxBox.z + block_ptr->translation.z;
 			if (!(min_bbox.x > max_view.x || max_bbox.x < min_view.x ||
 				  min_bbox.y > max_view.y || max_bbox.y < min_view.y ||
-				  min_bbox.z > max_view.z || max_bbox.z < min_view.z)) {
-				col_mesh_list[col_meshes] = block_ptr->col_mesh_ptr;
-				mesh_pos_list[col_meshes].x = block_ptr->translation.x;
-				mesh_pos_list[col_meshes].y = block_ptr->translation.y;
-				mesh_pos_list[col_meshes].z = block_ptr->translation.z;
-				col_meshes++;
-			}
+				  min_bbox.z > max_view.z || max_bbox.z < min_view.z) &&
+				!add_col_mesh(block_ptr))
+				return(false);
 		}
 		block_ptr = block_ptr->next_block_ptr;
 	}
+
+	// Step through the range of overlapping blocks and add them to the list
+	// of blocks to check for collisions.
+
+	for (level = min_level; level <= max_level; level++)
+		for (row = min_row; row <= max_row; row++)
+			for (column = min_column; column <= max_column; column++)
+				if ((block_ptr = world_ptr->get_block_ptr(column, row, level))
+					!= NULL && block_ptr->solid &&
+					block_ptr->col_mesh_ptr != NULL &&
+					!add_col_mesh(block_ptr))
+					return(false);
+	return(true);
 }
 
 //------------------------------------------------------------------------------
 // Adjust the player's trajectory to take into consideration collisions with
-// polygons.
+// polygons.  The whole trajectory is resolved in one pass by sweeping the
+// player's collision box through the blocks it overlaps, sliding along any
+// walls it hits and stepping up onto anything low enough.
 //------------------------------------------------------------------------------
 
 vector
 adjust_trajectory(vector &trajectory, float elapsed_time, bool &player_falling)
 {
-	float max_dx, max_dz;
-	float abs_dx, abs_dz;
-	vector new_trajectory;
 	vertex old_position, new_position;
+	vector piece_trajectory;
+	float max_x, max_z;
 	float floor_y;
 	int column, row, level;
+	int pieces, piece;
 
-	// Set the maximum length permitted for the trajectory.
-
-	max_dx = player_step_height;
-	max_dz = player_step_height;
-
-	// Compute the absolute values of the X and Z trajectory components.
-
-	abs_dx = ABS(trajectory.dx);
-	abs_dz = ABS(trajectory.dz);
-
-	// If the X and Z components of the trajectory are less or equal to the
-	// X and Z components of the maximum trajectory vector, then use this 
-	// trajectory.
-
-	if (FLE(abs_dx, max_dx) && FLE(abs_dz, max_dz)) {
-		new_trajectory = trajectory;
-		trajectory.set(0.0f, 0.0f, 0.0f);
-	} 
-	
-	// Compute a new trajectory such that the player moves along the axis
-	// of the largest component no further than the matching component of the
-	// maximum trajectory vector.
-	
-	else {
-		if (FGT(abs_dx, abs_dz)) {
-			new_trajectory.dx = max_dx * (trajectory.dx / abs_dx);
-			new_trajectory.dy = 0.0f;
-			new_trajectory.dz = max_dx * (trajectory.dz / abs_dx);
-		} else {
-			new_trajectory.dx = max_dz * (trajectory.dx / abs_dz);
-			new_trajectory.dy = 0.0f;
-			new_trajectory.dz = max_dz * (trajectory.dz / abs_dz);
-		}
-		trajectory.dx -= new_trajectory.dx;
-		trajectory.dz -= new_trajectory.dz;
-	}
+	// Shorten the trajectory along each axis so that it doesn't take the
+	// player off the edge of the map.
 
-	// If the new player position is off the map, don't move the player at all
+	old_position = player_viewpoint.position;
+	new_position = old_position + trajectory;
+	max_x = world_ptr->columns * world_ptr->block_units - COL_SWEEP_SKIN;
+	max_z = world_ptr->rows * world_ptr->block_units - COL_SWEEP_SKIN;
+	if (new_position.x < 0.0f)
+		trajectory.dx = -old_position.x;
+	else if (new_position.x > max_x)
+		trajectory.dx = max_x - old_position.x;
+	if (new_position.z < 0.0f)
+		trajectory.dz = -old_position.z;
+	else if (new_position.z > max_z)
+		trajectory.dz = max_z - old_position.z;
+
+	// If the player position is off the map, don't move the player at all
 	// and make the floor height invalid.
 
-	old_position = player_viewpoint.position;
-	new_position = old_position + new_trajectory;
-	new_position.get_scaled_map_position(&column, &row, &level);
-	if (new_position.x < 0.0 || column >= world_ptr->columns || 
-		row < 0 || new_position.z < 0.0 ||
-		new_position.y < 0.0 || level >= world_ptr->levels) {
-		new_position = old_position;
+	new_position = old_position;
+	old_position.get_scaled_map_position(&column, &row, &level);
+	if (old_position.x < 0.0 || column >= world_ptr->columns || 
+		row < 0 || old_position.z < 0.0 ||
+		old_position.y < 0.0 || level >= world_ptr->levels)
 		floor_y = -1.0f;
-	}
 
-	// Otherwise get the list of blocks that overlap the trajectory path,
-	// and check for collisions along that path, adjusting the player's new
-	// position approapiately.
+	// Otherwise get the list of blocks that overlap the whole trajectory
+	// path, and sweep the player along that path, adjusting the player's new
+	// position appropriately.  If the path overlaps too many blocks to check
+	// at once, it is split into shorter pieces that are swept one at a time.
 
 	else {
-		get_overlapping_blocks(new_position.x, new_position.y, new_position.z, 
-			old_position.x, old_position.y, old_position.z);
-		COL_checkCollisions(col_mesh_list, mesh_pos_list, col_meshes,
-			&new_position.x, &new_position.y, &new_position.z,
-			old_position.x, old_position.y, old_position.z,
-			&floor_y, player_step_height, &player_collision_box);
+		pieces = 1;
+		while (!get_overlapping_blocks(old_position.x + trajectory.dx / pieces,
+			old_position.y + trajectory.dy / pieces,
+			old_position.z + trajectory.dz / pieces,
+			old_position.x, old_position.y, old_position.z)) {
+			if (pieces == MAX_SWEEP_PIECES) {
+				if (!col_mesh_list_overflowed) {
+					diagnose("Player collision checks were limited to %d "
+						"blocks", MAX_COL_MESHES);
+					col_mesh_list_overflowed = true;
+				}
+				break;
+			}
+			pieces *= 2;
+		}
+		piece_trajectory = trajectory * (1.0f / pieces);
+		for (piece = 0; piece < pieces; piece++) {
+			if (piece > 0)
+				get_overlapping_blocks(new_position.x + piece_trajectory.dx,
+					new_position.y + piece_trajectory.dy,
+					new_position.z + piece_trajectory.dz,
+					new_position.x, new_position.y, new_position.z);
+			COL_moveAABox(col_mesh_list, mesh_pos_list, col_meshes,
+				&new_position.x, &new_position.y, &new_position.z,
+				piece_trajectory.dx, piece_trajectory.dy, piece_trajectory.dz,
+				&floor_y, player_step_height, &player_collision_box);
+		}
 	}
+	trajectory.set(0.0f, 0.0f, 0.0f);
 
 	// If the floor height is valid, do a gravity check.
 
@@ -1606,7 +1762,7 @@ adjust_trajectory(vector &trajectory, float elapsed_time, bool &player_falling)
 		}
 	} 
 	
-	// If the floor height is not -1.0f, this means that COL_checkCollisions()
+	// If the floor height is not -1.0f, this means that COL_moveAABox()
 	// returned a bogus new position, so set it to the old position.
 	
 	else if (FNE(floor_y, -1.0f))
@@ -1690,8 +1846,9 @@ process_prev_selected_square(void)
 		// If the previously selected block's square has a "roll off" trigger,
 		// add this to the trigger flags.
 
-		if ((prev_selected_square_ptr->block_trigger_flags & ROLL_OFF) ||
-			(prev_selected_square_ptr->square_trigger_flags & ROLL_OFF))
+		if ((BLOCK_TRIGGER_FLAGS(prev_selected_square_ptr) & ROLL_OFF) ||
+			(prev_selected_square_ptr->info_ptr->square_trigger_flags & 
+			 ROLL_OFF))
 			trigger_flags |= ROLL_OFF;
 	}
 
@@ -1700,9 +1857,10 @@ process_prev_selected_square(void)
 
 	if (trigger_flags) {
 		add_triggers_to_active_list(prev_selected_square_ptr,
-			prev_selected_square_ptr->block_trigger_list, trigger_flags);
+			BLOCK_TRIGGER_LIST(prev_selected_square_ptr), trigger_flags);
 		add_triggers_to_active_list(prev_selected_square_ptr,
-			prev_selected_square_ptr->square_trigger_list, trigger_flags);
+			prev_selected_square_ptr->info_ptr->square_trigger_list, 
+			trigger_flags);
 	}
 }
 
@@ -1728,8 +1886,9 @@ process_curr_selected_square(void)
 		// If the currently selected square has a "roll on" trigger, add this
 		// to the trigger flags.
 
-		if ((curr_selected_square_ptr->block_trigger_flags & ROLL_ON) ||
-			(curr_selected_square_ptr->square_trigger_flags & ROLL_ON))
+		if ((BLOCK_TRIGGER_FLAGS(curr_selected_square_ptr) & ROLL_ON) ||
+			(curr_selected_square_ptr->info_ptr->square_trigger_flags & 
+			 ROLL_ON))
 			trigger_flags |= ROLL_ON;
 	}
 
@@ -1737,8 +1896,9 @@ process_curr_selected_square(void)
 	// a "click on" trigger, add this to the trigger flags.
 
 	if (mouse_was_clicked && curr_selected_square_ptr &&
-		((curr_selected_square_ptr->block_trigger_flags & CLICK_ON) ||
-		 (curr_selected_square_ptr->square_trigger_flags & CLICK_ON)))
+		((BLOCK_TRIGGER_FLAGS(curr_selected_square_ptr) & CLICK_ON) ||
+		 (curr_selected_square_ptr->info_ptr->square_trigger_flags & 
+		  CLICK_ON)))
 		 trigger_flags |= CLICK_ON;
 
 	// If there are any trigger flags set, add the active triggers from the
@@ -1746,9 +1906,10 @@ process_curr_selected_square(void)
 
 	if (trigger_flags) {
 		add_triggers_to_active_list(curr_selected_square_ptr,
-			curr_selected_square_ptr->block_trigger_list, trigger_flags);
+			BLOCK_TRIGGER_LIST(curr_selected_square_ptr), trigger_flags);
 		add_triggers_to_active_list(curr_selected_square_ptr,
-			curr_selected_square_ptr->square_trigger_list, trigger_flags);
+			curr_selected_square_ptr->info_ptr->square_trigger_list, 
+			trigger_flags);
 	}
 }
 
@@ -1828,109 +1989,241 @@ process_curr_selected_area(void)
 }
 
 //------------------------------------------------------------------------------
-// Process the list of global triggers, looking for active ones.
+// Add an activated global trigger to the given list.  If there is no memory
+// for the trigger reference, add the trigger straight to the active trigger
+// list instead.
 //------------------------------------------------------------------------------
 
 static void
-process_global_trigger_list(void)
+add_activated_trigger(trigger_ref **activated_trigger_list_ptr,
+					  trigger *trigger_ptr)
+{
+	if (!add_trigger_ref(activated_trigger_list_ptr, trigger_ptr))
+		add_trigger_to_active_list(trigger_ptr->square_ptr, trigger_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Sort a list of trigger references into global trigger list order, using a
+// merge sort, and return the sorted list.
+//------------------------------------------------------------------------------
+
+static trigger_ref *
+sort_trigger_refs(trigger_ref *trigger_ref_list)
+{
+	trigger_ref *left_list, *right_list, *trigger_ref_ptr;
+	trigger_ref **tail_ptr;
+
+	// A list of zero or one references is already sorted.
+
+	if (trigger_ref_list == NULL ||
+		trigger_ref_list->next_trigger_ref_ptr == NULL)
+		return(trigger_ref_list);
+
+	// Split the list into two halves, by dealing the references out
+	// alternately, and sort each half.
+
+	left_list = NULL;
+	right_list = NULL;
+	while (trigger_ref_list) {
+		trigger_ref_ptr = trigger_ref_list;
+		trigger_ref_list = trigger_ref_ptr->next_trigger_ref_ptr;
+		trigger_ref_ptr->next_trigger_ref_ptr = left_list;
+		left_list = right_list;
+		right_list = trigger_ref_ptr;
+	}
+	left_list = sort_trigger_refs(left_list);
+	right_list = sort_trigger_refs(right_list);
+
+	// Merge the two sorted halves.
+
+	tail_ptr = &trigger_ref_list;
+	while (left_list && right_list) {
+		if (left_list->trigger_ptr->ordinal <=
+			right_list->trigger_ptr->ordinal) {
+			*tail_ptr = left_list;
+			left_list = left_list->next_trigger_ref_ptr;
+		} else {
+			*tail_ptr = right_list;
+			right_list = right_list->next_trigger_ref_ptr;
+		}
+		tail_ptr = &(*tail_ptr)->next_trigger_ref_ptr;
+	}
+	*tail_ptr = left_list ? left_list : right_list;
+	return(trigger_ref_list);
+}
+
+//------------------------------------------------------------------------------
+// Test the "step in", "step out" and "proximity" triggers in the given trigger
+// reference list that haven't already been tested this frame, and add those
+// that were activated to the activated trigger list.  "Step in" and "step out"
+// triggers whose radius the player is now inside are added to the new inside
+// list.
+//------------------------------------------------------------------------------
+
+static void
+process_trigger_ref_list(trigger_ref *trigger_ref_ptr,
+						 trigger_ref **activated_trigger_list_ptr,
+						 trigger_ref **new_inside_trigger_list_ptr)
 {
 	trigger *trigger_ptr;
 	bool activated;
 	vector distance;
 	float distance_squared;
 	bool currently_inside;
-	square *square_ptr;
-	int column, row, level;
 
-	// Step through the global trigger list.
+	while (trigger_ref_ptr) {
+		trigger_ptr = trigger_ref_ptr->trigger_ptr;
 
-	trigger_ptr = global_trigger_list;
-	while (trigger_ptr) {
+		// A trigger whose radius overlaps several squares that hash to the
+		// same bucket may be referenced more than once, so skip it if it has
+		// already been tested this frame.
 
-		// If this is a "step in" or "step out" or "proximity" trigger, compute
-		// the distance squared from the trigger to the player, and from this 
-		// determine whether the player is inside the radius.
+		if (trigger_ptr->frame_tested != curr_trigger_frame) {
+			trigger_ptr->frame_tested = curr_trigger_frame;
+
+			// Compute the distance squared from the trigger to the player,
+			// and from this determine whether the player is inside the
+			// radius.
 
-		if (trigger_ptr->trigger_flag == STEP_IN ||
-			trigger_ptr->trigger_flag == STEP_OUT ||
-			trigger_ptr->trigger_flag == PROXIMITY) {
 			distance = trigger_ptr->position - player_viewpoint.position;
 			distance_squared = distance.dx * distance.dx + 
 				distance.dy * distance.dy + distance.dz * distance.dz;
 			currently_inside = distance_squared <= trigger_ptr->radius_squared;
-		}
 
-		// Check for an activated trigger.
+			// Check for an activated trigger.
 
-		activated = false;
-		switch (trigger_ptr->trigger_flag) {
-		case STEP_IN:
+			activated = false;
+			switch (trigger_ptr->trigger_flag) {
+			case STEP_IN:
 
-			// If the new state of the trigger is "inside", and the old state
-			// of the trigger was not "inside", activate this trigger.
+				// If the new state of the trigger is "inside", and the old
+				// state of the trigger was not "inside", activate this trigger.
 
-			if (currently_inside && !trigger_ptr->previously_inside)
-				activated = true;
-			break;
-
-		case STEP_OUT:
+				if (currently_inside && !trigger_ptr->previously_inside)
+					activated = true;
+				break;
 
-			// If the new state of the trigger is "outside", and the old state
-			// of the trigger was not "outside", activate this trigger.
+			case STEP_OUT:
 
-			if (!currently_inside && trigger_ptr->previously_inside)
-				 activated = true;
-			break;
+				// If the new state of the trigger is "outside", and the old
+				// state of the trigger was not "outside", activate this
+				// trigger.
 
-		case PROXIMITY:
+				if (!currently_inside && trigger_ptr->previously_inside)
+					 activated = true;
+				break;
 
-			// If the player in inside the radius, activate this trigger.
+			case PROXIMITY:
 
-			activated = currently_inside;
-			break;
+				// If the player in inside the radius, activate this trigger.
 
-		case TIMER:
+				activated = currently_inside;
+			}
 
-			// If the trigger delay has elapsed, activate this trigger and
-			// set the next trigger delay.
+			// If this is a "step in" or "step out" trigger, update the
+			// trigger's state, and if the player is inside the radius add it
+			// to the new inside list.
 
-			if (curr_time_ms - trigger_ptr->start_time_ms >= 
-				trigger_ptr->delay_ms) {
-				activated = true;
-				set_trigger_delay(trigger_ptr, curr_time_ms);
+			if (trigger_ptr->trigger_flag == STEP_IN ||
+				trigger_ptr->trigger_flag == STEP_OUT) {
+				trigger_ptr->previously_inside = currently_inside;
+				if (currently_inside)
+					add_trigger_ref(new_inside_trigger_list_ptr, trigger_ptr);
 			}
-			break;
 
-		case LOCATION:
+			// If trigger was activated, add it to the activated trigger list.
 
-			// Get the location of the trigger square.
+			if (activated)
+				add_activated_trigger(activated_trigger_list_ptr, trigger_ptr);
+		}
+
+		// Move onto the next trigger reference.
 
-			square_ptr = trigger_ptr->square_ptr;
-			world_ptr->get_square_location(square_ptr, &column, &row, &level);
+		trigger_ref_ptr = trigger_ref_ptr->next_trigger_ref_ptr;
+	}
+}
 
-			// If this matches the target location, activate the trigger.
+//------------------------------------------------------------------------------
+// Process the index of global triggers, looking for active ones.  Only the
+// triggers whose radius overlaps the player's square need to be tested.  The
+// activated triggers are added to the active trigger list in the same order as
+// they appear in the global trigger list.
+//------------------------------------------------------------------------------
 
-			if (column == trigger_ptr->target.column &&
-				row == trigger_ptr->target.row && 
-				level == trigger_ptr->target.level)
-				activated = true;
+static void
+process_global_trigger_list(void)
+{
+	trigger *trigger_ptr;
+	trigger_ref *trigger_ref_ptr, *new_inside_trigger_list;
+	trigger_ref *expired_trigger_list, *activated_trigger_list;
+
+	// Start a new trigger frame.
+
+	curr_trigger_frame++;
+
+	// Test the triggers in the bucket for the player's square, followed by
+	// the triggers that were too large to index.
+
+	activated_trigger_list = NULL;
+	new_inside_trigger_list = NULL;
+	process_trigger_ref_list(trigger_bucket_list[get_trigger_bucket(
+		player_column, player_row, player_level)], &activated_trigger_list,
+		&new_inside_trigger_list);
+	process_trigger_ref_list(large_trigger_list, &activated_trigger_list,
+		&new_inside_trigger_list);
+
+	// Step through the old inside list.  Any trigger that wasn't tested this
+	// frame doesn't overlap the player's square, so the player has left its
+	// radius; update its state and activate it if it's a "step out" trigger.
+
+	while (inside_trigger_list) {
+		trigger_ptr = inside_trigger_list->trigger_ptr;
+		if (trigger_ptr->frame_tested != curr_trigger_frame) {
+			trigger_ptr->frame_tested = curr_trigger_frame;
+			if (trigger_ptr->trigger_flag == STEP_OUT && 
+				trigger_ptr->previously_inside)
+				add_activated_trigger(&activated_trigger_list, trigger_ptr);
+			trigger_ptr->previously_inside = false;
 		}
+		inside_trigger_list = del_trigger_ref(inside_trigger_list);
+	}
+	inside_trigger_list = new_inside_trigger_list;
 
-		// If this is a "step in" or "step out" trigger, update the trigger's
-		// state.
+	// Remove the "timer" triggers whose delay has elapsed from the timer heap,
+	// and activate them.  They are only rescheduled once the heap holds no
+	// more expired triggers, so that a trigger with no delay fires just once
+	// per frame.
 
-		if (trigger_ptr->trigger_flag == STEP_IN ||
-			trigger_ptr->trigger_flag == STEP_OUT)
-			trigger_ptr->previously_inside = currently_inside;
+	expired_trigger_list = NULL;
+	while ((trigger_ptr = get_expired_timer_trigger(curr_time_ms)) != NULL) {
+		add_activated_trigger(&activated_trigger_list, trigger_ptr);
+		add_trigger_ref(&expired_trigger_list, trigger_ptr);
+	}
+	while (expired_trigger_list) {
+		trigger_ptr = expired_trigger_list->trigger_ptr;
+		set_trigger_delay(trigger_ptr, curr_time_ms);
+		schedule_timer_trigger(trigger_ptr);
+		expired_trigger_list = del_trigger_ref(expired_trigger_list);
+	}
 
-		// If trigger was activated, add it to the active trigger list.
+	// Every trigger in the location trigger list has a target that matches
+	// its own square, so activate them all.
 
-		if (activated)
-			add_trigger_to_active_list(trigger_ptr->square_ptr, trigger_ptr);
+	trigger_ref_ptr = location_trigger_list;
+	while (trigger_ref_ptr) {
+		add_activated_trigger(&activated_trigger_list,
+			trigger_ref_ptr->trigger_ptr);
+		trigger_ref_ptr = trigger_ref_ptr->next_trigger_ref_ptr;
+	}
 
-		// Move onto the next global trigger.
+	// Sort the activated triggers into global trigger list order, and add
+	// them to the active trigger list.
 
-		trigger_ptr = trigger_ptr->next_trigger_ptr;
+	activated_trigger_list = sort_trigger_refs(activated_trigger_list);
+	while (activated_trigger_list) {
+		trigger_ptr = activated_trigger_list->trigger_ptr;
+		add_trigger_to_active_list(trigger_ptr->square_ptr, trigger_ptr);
+		activated_trigger_list = del_trigger_ref(activated_trigger_list);
 	}
 }
 
@@ -2112,6 +2405,17 @@ execute_active_trigger_list(void)
 
 	global_sound_list_changed = false;
 
+	// If there are any active triggers, their actions may change the scene,
+	// so the cached frame cannot be reused.
+
+	if (active_trigger_list)
+		invalidate_frame_cache();
+
+	// Batch the block replacements made by the active triggers, so that the
+	// active polygons around the replaced blocks are only updated once.
+
+	begin_block_update_batch();
+
 	// Step through the active triggers.
 
 	trigger_ptr = active_trigger_list;
@@ -2146,6 +2450,10 @@ execute_active_trigger_list(void)
 	active_trigger_list = NULL;
 	last_active_trigger_ptr = NULL;
 
+	// Update the active polygons around all replaced blocks.
+
+	end_block_update_batch();
+
 #ifdef SUPPORT_A3D
 
 	// If the global sound list has changed, reset the audio, 
@@ -2191,6 +2499,7 @@ static bool
 render_next_frame(void)
 {
 	int prev_time_ms;
+	__int64 prev_frame_start_ticks;
 	float elapsed_time;
 	float move_delta, side_delta, turn_delta, look_delta;
 	vector trajectory, new_trajectory, unit_trajectory;
@@ -2202,7 +2511,7 @@ render_next_frame(void)
 	START_TIMING;
 
 	// Update the current time in milliseconds, and compute the elapsed time in
-	// seconds.
+	// seconds.  Also record the time between frames as a frame statistic.
 
 	if (frames_rendered > 0) {
 		prev_time_ms = curr_time_ms;
@@ -2212,9 +2521,14 @@ render_next_frame(void)
 			curr_time_ms - prev_time_ms);
 #endif
 		elapsed_time = (float)(curr_time_ms - prev_time_ms) / 1000.0f;
+		prev_frame_start_ticks = frame_start_ticks;
+		frame_start_ticks = get_time_ticks();
+		frame_time_stat.add_sample((float)(frame_start_ticks -
+			prev_frame_start_ticks) * 1000.0f / (float)get_ticks_per_second());
 	} else {
 		curr_time_ms = get_time_ms();
 		elapsed_time = 0.0f;
+		frame_start_ticks = get_time_ticks();
 	}
 
 	// Get the current mouse position, determine the motion deltas, and set
@@ -2276,12 +2590,9 @@ render_next_frame(void)
 	{
 		START_TIMING;
 
-		do {
-			new_trajectory = adjust_trajectory(trajectory, elapsed_time, 
-				player_falling);
-			player_viewpoint.position = player_viewpoint.position + 
-				new_trajectory;
-		} while (FNE(trajectory.dx, 0.0f) || FNE(trajectory.dz, 0.0f));
+		new_trajectory = adjust_trajectory(trajectory, elapsed_time, 
+			player_falling);
+		player_viewpoint.position = player_viewpoint.position + new_trajectory;
 
 		END_TIMING("collision detection");
 	}
@@ -2396,6 +2707,9 @@ render_next_frame(void)
 
 #ifdef RENDERSTATS
 	int start_render_time_ms = get_time_ms();
+#endif
+#if defined(_DEBUG) && !defined(TRACE)
+	int start_heap_allocations = heap_allocations;
 #endif
 	render_frame();
 #ifdef RENDERSTATS
@@ -2404,6 +2718,16 @@ render_next_frame(void)
 		end_render_time_ms - start_render_time_ms);
 #endif
 
+	// Once the span and screen polygon lists have grown to fit the spot,
+	// rendering a frame should not allocate any memory.
+
+#if defined(_DEBUG) && !defined(TRACE)
+	if (frames_rendered >= STEADY_STATE_FRAMES && 
+		heap_allocations != start_heap_allocations)
+		diagnose("Frame %d made %d heap allocations while rendering", 
+			frames_rendered, heap_allocations - start_heap_allocations);
+#endif
+
 	// Move the player viewpoint to floor height.
 
 	player_viewpoint.position.y -= player_size.y;
@@ -2412,6 +2736,12 @@ render_next_frame(void)
 
 	display_frame_buffer(false, false);
 
+	// If the last frame was reused, nothing in the scene is changing, so give
+	// up the rest of the time slice before the next frame.
+
+	if (frame_reused)
+		Sleep(REUSED_FRAME_DELAY_MS);
+
 	// Update the number of frames rendered.
 
 	frames_rendered++;
@@ -2461,6 +2791,29 @@ render_next_frame(void)
 	}
 #endif
 
+	// If the overdraw display has been toggled, switch it on or off.  It is
+	// only available in software rendering mode.
+
+	if (overdraw_mode_toggled.event_sent()) {
+		if (overdraw_mode || hardware_acceleration) {
+			overdraw_mode = false;
+			delete_overdraw_buffer();
+		} else
+			overdraw_mode = true;
+	}
+
+	// If the z-buffer has been toggled, switch between it and the span buffer.
+	// It is only available in software rendering mode.
+
+	if (z_buffer_toggled.event_sent()) {
+		if (z_buffer_enabled || hardware_acceleration) {
+			z_buffer_enabled = false;
+			delete_z_buffer();
+		} else
+			z_buffer_enabled = true;
+		invalidate_frame_cache();
+	}
+
 	// If the mouse was clicked, and an exit was selected, handle it.
 
 	if (mouse_was_clicked && curr_selected_exit_ptr)
@@ -2491,7 +2844,7 @@ render_next_frame(void)
 	square *square_ptr = world_ptr->get_square_ptr(player_column, 
 		player_row, player_level);
 	if (square_ptr != NULL) {
-		hyperlink *exit_ptr = square_ptr->exit_ptr;
+		hyperlink *exit_ptr = square_ptr->info_ptr->exit_ptr;
 		if (exit_ptr != NULL && exit_ptr->trigger_flags & STEP_ON) {
 			END_TIMING("render_next_frame");
 			return(handle_exit(exit_ptr->URL, exit_ptr->target, false, true));
@@ -3140,6 +3493,7 @@ init_player_window(void)
 
 	init_free_span_list();
 	span_buffer_ptr = NULL;
+	overdraw_mode = false;
 
 	// Compute half of the window dimensions, for convienance.
 
@@ -3185,11 +3539,15 @@ init_player_window(void)
 	horz_pixels_per_degree = window_width / horz_field_of_view;
 	vert_pixels_per_degree = window_height / vert_field_of_view;
 
-	// If hardware acceleration is not enabled, create the span buffer.
+	// If hardware acceleration is not enabled, create the span buffer.  If
+	// span gaps are enabled, each row can have at most one gap for every two
+	// pixels, since gaps and the spans between them are at least one pixel
+	// wide.
 
 	if (!hardware_acceleration) {
 		if ((span_buffer_ptr = new span_buffer) == NULL ||
-			!span_buffer_ptr->create_buffer(window_height)) {
+			!span_buffer_ptr->create_buffer(window_height,
+			span_gaps_enabled ? window_width / 2 + 1 : 0)) {
 			display_low_memory_error();
 			return(false);
 		}
@@ -3221,9 +3579,13 @@ shut_down_player_window(void)
 
 	delete_screen_polygon_list();
 
-	// Delete the image caches.
+	// Delete the image caches, the overdraw buffer, the z-buffer and the
+	// cached frame.
 
 	delete_image_caches();
+	delete_overdraw_buffer();
+	delete_z_buffer();
+	delete_frame_cache();
 
 	// Signal the plugin thread that the player window has been shut down.
 
@@ -3341,10 +3703,6 @@ player_thread(void *arg_list)
 			visible_block_radius = 10;
 	}
 
-#ifdef PROFILE
-	curr_tabs = 0;
-#endif
-
 	// Decrease the priority level on this thread, to ensure that the browser
 	// and the rest of the system remains responsive.
 
@@ -3496,12 +3854,15 @@ player_thread(void *arg_list)
 			if (!render_next_frame())
 				break;
 
-			// Handle the current download, if there is one.  If an error has
-			// occurred, break out of the event loop.
+			// Handle the current download, if there is one, and make sure the
+			// next frame is rendered in case a texture was loaded.  If an error
+			// has occurred, break out of the event loop.
 
-			if ((curr_custom_texture_ptr || curr_custom_wave_ptr) &&
-				!handle_current_download())
-				break;
+			if (curr_custom_texture_ptr || curr_custom_wave_ptr) {
+				invalidate_frame_cache();
+				if (!handle_current_download())
+					break;
+			}
 
 			// If a window mode change is requested, handle it.  If the mode
 			// change fails, break out of the event loop.
@@ -91,9 +91,10 @@ extern vertex frustum_vertex_list[FRUSTUM_VERTICES];
 extern byte *frame_buffer_ptr;
 extern int frame_buffer_width;
 
-// Span buffer.
+// Span buffer, and flag indicating whether the overdraw display is on.
 
 extern span_buffer *span_buffer_ptr;
+extern bool overdraw_mode;
 
 // Pointer to old and current blockset list, and custom blockset.
 
@@ -161,6 +162,18 @@ extern popup *last_global_popup_ptr;
 
 extern trigger *global_trigger_list;
 extern trigger *last_global_trigger_ptr;
+extern int next_trigger_ordinal;
+
+// Index of the global trigger list.
+
+extern trigger_ref *trigger_bucket_list[TRIGGER_BUCKETS];
+extern trigger_ref *large_trigger_list;
+extern trigger_ref *inside_trigger_list;
+extern trigger **timer_heap;
+extern int timer_heap_size;
+extern int max_timer_heap_size;
+extern trigger_ref *location_trigger_list;
+extern int curr_trigger_frame;
 
 // Placeholder texture.
 
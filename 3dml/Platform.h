@@ -403,11 +403,17 @@ capture_mouse(void);
 void
 release_mouse(void);
 
-// Time function.
+// Time functions.
 
 int
 get_time_ms(void);
 
+__int64
+get_time_ticks(void);
+
+__int64
+get_ticks_per_second(void);
+
 // Functions to load wave files.
 
 bool
@@ -34,6 +34,9 @@
 #include "Parser.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Profile.h"
+#include "Render.h"
+#include "Spans.h"
 #include "resource.h"
 
 // Acceleration modes.
@@ -161,6 +164,8 @@ event resume_player_thread;
 event history_entry_selected;
 event check_for_update_requested;
 event polygon_info_requested;
+event overdraw_mode_toggled;
+event z_buffer_toggled;
 
 // Global variables that require synchronised access.
 
@@ -835,6 +840,14 @@ key_event_callback(int key_code, bool key_down)
 			launch_builder_web_page();
 		break;
 
+	// If the 'D' key was released, send an event to toggle the overdraw
+	// display.
+
+	case 'D':
+		if (!key_down)
+			overdraw_mode_toggled.send_event(true);
+		break;
+
 	// If the 'H' key was released and we're not running full-screen, activate
 	// the history menu.
 
@@ -876,6 +889,14 @@ key_event_callback(int key_code, bool key_down)
 			polygon_info_requested.send_event(true);
 		break;
 
+	// If the 'R' key was released, send an event to switch between the span
+	// buffer and z-buffer rasterisers.
+
+	case 'R':
+		if (!key_down)
+			z_buffer_toggled.send_event(true);
+		break;
+
 	// If the 'U' key was released and we're not running full_screen, check for
 	// a new update.
 
@@ -1293,6 +1314,10 @@ NPP_Initialize(void)
 	int use_sounds;
 	int prev_process_ID;
 	int use_reflections;
+	int use_span_gaps;
+	int use_z_buffer;
+	int use_polygon_bins;
+	int use_profile_export;
 
 #if TRACE
 	start_trace();
@@ -1334,7 +1359,9 @@ NPP_Initialize(void)
 	// Attempt to open the config file and read the acceleration mode flag,
 	// sound download flag, visible block radius, previous process ID,
 	// use reflections flag, current move rate, current rotate rate,
-	// and the previous window width and height.
+	// the previous window width and height, the use span gaps flag, the use
+	// z-buffer flag, the use polygon bins flag, and the use profile export
+	// flag.
 	//
 	// If the config file does not exist, use default values and make sure the
 	// flatland directory exists so the config file can be rewritten later.
@@ -1354,19 +1381,31 @@ NPP_Initialize(void)
 	curr_rotate_rate = DEFAULT_ROTATE_RATE;
 	prev_window_width = 320;
 	prev_window_height = 240;
+	use_span_gaps = true;
+	use_z_buffer = false;
+	use_polygon_bins = false;
+	use_profile_export = false;
 	if ((fp = fopen(config_file_path, "r")) != NULL) {
-		fscanf(fp, "%d %d %d %d %d %f %f %d %d %d", &acceleration_mode, 
-			&use_sounds, &visible_block_radius, &prev_process_ID, 
-			&use_reflections, &curr_move_rate, &curr_rotate_rate,
-			&prev_window_width, &prev_window_height);
+		fscanf(fp, "%d %d %d %d %d %f %f %d %d %d %d %d %d",
+			&acceleration_mode, &use_sounds, &visible_block_radius,
+			&prev_process_ID, &use_reflections, &curr_move_rate,
+			&curr_rotate_rate, &prev_window_width, &prev_window_height,
+			&use_span_gaps, &use_z_buffer, &use_polygon_bins,
+			&use_profile_export);
 		fclose(fp);
 	} else
 		mkdir(flatland_dir);
 
-	// Set the download sounds flag and the hardware acceleration flag.
+	// Set the download sounds flag, the hardware acceleration flag, the span
+	// gaps flag, the z-buffer flag, the polygon binning flag and the profile
+	// export flag.
 
 	download_sounds = use_sounds ? true : false;
 	hardware_acceleration = acceleration_mode == TRY_HARDWARE;
+	span_gaps_enabled = use_span_gaps ? true : false;
+	z_buffer_enabled = use_z_buffer ? true : false;
+	polygon_binning_enabled = use_polygon_bins ? true : false;
+	profile_export_enabled = use_profile_export ? true : false;
 	
 	// If the sound system is not A3D or reflections are not available, turn
 	// off reflections regardless of the setting of the use reflections flag
@@ -1430,6 +1469,8 @@ NPP_Initialize(void)
 	history_entry_selected.create_event();
 	check_for_update_requested.create_event();
 	polygon_info_requested.create_event();
+	overdraw_mode_toggled.create_event();
+	z_buffer_toggled.create_event();
 
 	// Initialise all variables that require synchronised access.
 
@@ -1534,21 +1575,27 @@ NPP_Shutdown(void)
 	history_entry_selected.destroy_event();
 	check_for_update_requested.destroy_event();
 	polygon_info_requested.destroy_event();
+	overdraw_mode_toggled.destroy_event();
+	z_buffer_toggled.destroy_event();
 
 	// Attempt to open the config file and write the acceleration mode flag,
 	// sound download flag, visible block radius, current process ID,
 	// reflections enabled flag, current move rate, current rotate rate,
-	// and the previous window width and height.
+	// the previous window width and height, the span gaps enabled flag, the
+	// z-buffer enabled flag, the polygon binning enabled flag, and the profile
+	// export enabled flag.
 
 	if (hardware_acceleration)
 		acceleration_mode = TRY_HARDWARE;
 	else
 		acceleration_mode = TRY_SOFTWARE;
 	if ((fp = fopen(config_file_path, "w")) != NULL) {
-		fprintf(fp, "%d %d %d %d %d %g %g %d %d", acceleration_mode, 
-			download_sounds, visible_block_radius, curr_process_ID, 
-			reflections_enabled, curr_move_rate, curr_rotate_rate, 
-			prev_window_width, prev_window_height);
+		fprintf(fp, "%d %d %d %d %d %g %g %d %d %d %d %d %d",
+			acceleration_mode, download_sounds, visible_block_radius,
+			curr_process_ID, reflections_enabled, curr_move_rate,
+			curr_rotate_rate, prev_window_width, prev_window_height,
+			span_gaps_enabled, z_buffer_enabled, polygon_binning_enabled,
+			profile_export_enabled);
 		fclose(fp);
 	}
 
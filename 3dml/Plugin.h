@@ -111,6 +111,8 @@ extern event resume_player_thread;
 extern event history_entry_selected;
 extern event check_for_update_requested;
 extern event polygon_info_requested;
+extern event overdraw_mode_toggled;
+extern event z_buffer_toggled;
 
 // Event variables that require synchronised access.
 
@@ -0,0 +1,437 @@
+//******************************************************************************
+// $Header$
+//
+// The contents of this file are subject to the Flatland Public License 
+// Version 1.1 (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at 
+// http://www.3dml.org/FPL/ 
+//
+// Software distributed under the License is distributed on an "AS IS" basis,
+// WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+// the specific language governing rights and limitations under the License. 
+//
+// The Original Code is Rover. 
+//
+// The Initial Developer of the Original Code is Flatland Online, Inc. 
+// Portions created by Flatland are Copyright (C) 1998-2000 Flatland
+// Online Inc. All Rights Reserved. 
+//
+// Contributor(s): Philip Stephens.
+//******************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Classes.h"
+#include "Parser.h"
+#include "Platform.h"
+#include "Plugin.h"
+#include "Profile.h"
+
+// Size of the zone ring buffer, which must be a power of two.
+
+#define MAX_PROFILE_ZONES	16384
+
+// A completed zone.
+
+struct profile_zone {
+	const char *name;
+	__int64 start_ticks;
+	__int64 end_ticks;
+};
+
+// Ring buffer of the most recently completed zones, and the total number of
+// zones recorded since it was last reset.  Zones are only timed by the player
+// thread, which is also the thread that reads the ring buffer when the spot
+// is freed, so no locking is required; the count is only incremented after a
+// zone has been written, so a reader never sees a partly written zone.
+
+static profile_zone zone_ring[MAX_PROFILE_ZONES];
+static volatile unsigned int zones_recorded;
+
+// Flag indicating whether the frame statistics and zones are exported to files
+// in the Flatland directory when a spot is freed.  This is set from the config
+// file, so that release builds can be profiled as well.
+
+bool profile_export_enabled;
+
+// Lists of all frame statistics and profile sums.  These are static objects
+// that add themselves to the appropriate list when constructed.
+
+static frame_stat *frame_stat_list;
+static profile_sum *profile_sum_list;
+
+// Sorted copy of a frame statistic's samples, used to compute percentiles.
+
+static float sorted_sample_list[FRAME_STAT_WINDOW];
+
+//------------------------------------------------------------------------------
+// Frame statistic class.
+//------------------------------------------------------------------------------
+
+// Constructor resets the statistic, and adds it to the list of all
+// statistics.
+
+frame_stat::frame_stat(const char *set_name)
+{
+	name = set_name;
+	reset();
+	next_frame_stat_ptr = frame_stat_list;
+	frame_stat_list = this;
+}
+
+// Default destructor does nothing.
+
+frame_stat::~frame_stat()
+{
+}
+
+// Method to discard all samples.
+
+void
+frame_stat::reset(void)
+{
+	samples = 0;
+}
+
+// Method to add a sample, replacing the oldest sample if the window is full.
+
+void
+frame_stat::add_sample(float sample)
+{
+	sample_list[samples % FRAME_STAT_WINDOW] = sample;
+	samples++;
+}
+
+// Method to return the number of samples in the window.
+
+int
+frame_stat::window_samples(void)
+{
+	return(samples < FRAME_STAT_WINDOW ? samples : FRAME_STAT_WINDOW);
+}
+
+// Method to return the given sample in the window, where sample 0 is the
+// oldest.
+
+float
+frame_stat::get_sample(int sample_no)
+{
+	if (samples > FRAME_STAT_WINDOW)
+		sample_no += samples;
+	return(sample_list[sample_no % FRAME_STAT_WINDOW]);
+}
+
+// Method to return the mean of the samples in the window.
+
+float
+frame_stat::mean(void)
+{
+	int window_size, index;
+	float sum;
+
+	window_size = window_samples();
+	if (window_size == 0)
+		return(0.0f);
+	sum = 0.0f;
+	for (index = 0; index < window_size; index++)
+		sum += sample_list[index];
+	return(sum / (float)window_size);
+}
+
+// Function to compare two samples, for use by qsort().
+
+static int
+compare_samples(const void *sample1_ptr, const void *sample2_ptr)
+{
+	float sample1 = *(float *)sample1_ptr;
+	float sample2 = *(float *)sample2_ptr;
+
+	if (sample1 < sample2)
+		return(-1);
+	if (sample1 > sample2)
+		return(1);
+	return(0);
+}
+
+// Method to return the given percentile of the samples in the window, using
+// the nearest rank.
+
+float
+frame_stat::percentile(int percent)
+{
+	int window_size, rank;
+
+	window_size = window_samples();
+	if (window_size == 0)
+		return(0.0f);
+	memcpy(sorted_sample_list, sample_list, window_size * sizeof(float));
+	qsort(sorted_sample_list, window_size, sizeof(float), compare_samples);
+	rank = (percent * window_size + 99) / 100;
+	if (rank < 1)
+		rank = 1;
+	return(sorted_sample_list[rank - 1]);
+}
+
+//------------------------------------------------------------------------------
+// Profile sum class.
+//------------------------------------------------------------------------------
+
+// Default constructor resets the sum, and adds it to the list of all sums.
+
+profile_sum::profile_sum()
+{
+	name = NULL;
+	reset();
+	next_profile_sum_ptr = profile_sum_list;
+	profile_sum_list = this;
+}
+
+// Default destructor does nothing.
+
+profile_sum::~profile_sum()
+{
+}
+
+// Method to reset the sum and it's histogram.
+
+void
+profile_sum::reset(void)
+{
+	ticks = 0;
+	total_ticks = 0;
+	frames = 0;
+	memset(histogram, 0, sizeof(histogram));
+}
+
+// Method to add the time summed in the current frame to the histogram.
+
+void
+profile_sum::end_frame(const char *message)
+{
+	static double ticks_per_microsecond;
+	__int64 microseconds;
+	int bucket;
+
+	// Determine the number of ticks per microsecond, the first time a frame
+	// is ended.  This is kept as a double, since the tick rate may not be a
+	// whole number of megahertz.
+
+	if (ticks_per_microsecond == 0.0)
+		ticks_per_microsecond = (double)get_ticks_per_second() / 1000000.0;
+
+	// Find the histogram bucket for the number of microseconds summed.
+
+	microseconds = (__int64)((double)ticks / ticks_per_microsecond);
+	bucket = 0;
+	while (microseconds > 1 && bucket < PROFILE_HISTOGRAM_BUCKETS - 1) {
+		microseconds >>= 1;
+		bucket++;
+	}
+	histogram[bucket]++;
+
+	// Remember the name of this sum, update it's totals, and add the time
+	// spent in this frame to the frame statistic.
+
+	name = message;
+	total_ticks += ticks;
+	frames++;
+	frame_ms.name = message;
+	frame_ms.add_sample((float)ticks * 1000.0f / (float)get_ticks_per_second());
+}
+
+//------------------------------------------------------------------------------
+// Return a pointer to the frame statistic with the given name, or NULL if
+// there is no such statistic.
+//------------------------------------------------------------------------------
+
+frame_stat *
+find_frame_stat(const char *name)
+{
+	frame_stat *stat_ptr;
+
+	stat_ptr = frame_stat_list;
+	while (stat_ptr) {
+		if (stat_ptr->name && !strcmp(stat_ptr->name, name))
+			break;
+		stat_ptr = stat_ptr->next_frame_stat_ptr;
+	}
+	return(stat_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Write the samples in the window of every frame statistic to the given file
+// as comma-separated values, with one row per frame and one column per
+// statistic.
+//------------------------------------------------------------------------------
+
+bool
+write_frame_stats(const char *file_path)
+{
+	FILE *fp;
+	frame_stat *stat_ptr;
+	int frames, sample_no;
+
+	// Determine the number of frames in the window; all statistics should
+	// have the same number of samples, but be safe in case they don't.
+
+	frames = 0;
+	stat_ptr = frame_stat_list;
+	while (stat_ptr) {
+		if (stat_ptr->name && stat_ptr->window_samples() > frames)
+			frames = stat_ptr->window_samples();
+		stat_ptr = stat_ptr->next_frame_stat_ptr;
+	}
+	if (frames == 0)
+		return(false);
+
+	// Write the header row, followed by a row for each frame.
+
+	if ((fp = fopen(file_path, "w")) == NULL)
+		return(false);
+	fprintf(fp, "frame");
+	for (stat_ptr = frame_stat_list; stat_ptr;
+		 stat_ptr = stat_ptr->next_frame_stat_ptr)
+		if (stat_ptr->name)
+			fprintf(fp, ",%s", stat_ptr->name);
+	fprintf(fp, "\n");
+	for (sample_no = 0; sample_no < frames; sample_no++) {
+		fprintf(fp, "%d", sample_no);
+		for (stat_ptr = frame_stat_list; stat_ptr;
+			 stat_ptr = stat_ptr->next_frame_stat_ptr) {
+			if (stat_ptr->name == NULL)
+				continue;
+			if (sample_no < stat_ptr->window_samples())
+				fprintf(fp, ",%g", stat_ptr->get_sample(sample_no));
+			else
+				fprintf(fp, ",");
+		}
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Record a completed zone in the ring buffer.
+//------------------------------------------------------------------------------
+
+void
+record_profile_zone(const char *name, __int64 start_ticks, __int64 end_ticks)
+{
+	profile_zone *zone_ptr;
+
+	zone_ptr = &zone_ring[zones_recorded & (MAX_PROFILE_ZONES - 1)];
+	zone_ptr->name = name;
+	zone_ptr->start_ticks = start_ticks;
+	zone_ptr->end_ticks = end_ticks;
+	zones_recorded++;
+}
+
+//------------------------------------------------------------------------------
+// Write the zones in the ring buffer to the given file, in the Chrome trace
+// event format.
+//------------------------------------------------------------------------------
+
+static void
+write_profile_trace(const char *file_path)
+{
+	FILE *fp;
+	unsigned int first_zone, zone_no;
+	profile_zone *zone_ptr;
+	double microseconds_per_tick;
+	__int64 base_ticks;
+
+	// Do nothing if there are no zones.
+
+	if (zones_recorded == 0)
+		return;
+
+	// Determine the oldest zone still in the ring buffer.  Times are written
+	// in microseconds relative to the start of that zone.
+
+	if (zones_recorded > MAX_PROFILE_ZONES)
+		first_zone = zones_recorded - MAX_PROFILE_ZONES;
+	else
+		first_zone = 0;
+	base_ticks = zone_ring[first_zone & (MAX_PROFILE_ZONES - 1)].start_ticks;
+	microseconds_per_tick = 1000000.0 / (double)get_ticks_per_second();
+
+	// Write each zone as a complete event.
+
+	if ((fp = fopen(file_path, "w")) == NULL)
+		return;
+	fprintf(fp, "{\"traceEvents\":[\n");
+	for (zone_no = first_zone; zone_no < zones_recorded; zone_no++) {
+		zone_ptr = &zone_ring[zone_no & (MAX_PROFILE_ZONES - 1)];
+		fprintf(fp, "{\"name\":\"%s\",\"cat\":\"rover\",\"ph\":\"X\","
+			"\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s\n",
+			zone_ptr->name,
+			(double)(zone_ptr->start_ticks - base_ticks) * microseconds_per_tick,
+			(double)(zone_ptr->end_ticks - zone_ptr->start_ticks) *
+			microseconds_per_tick, zone_no < zones_recorded - 1 ? "," : "");
+	}
+	fprintf(fp, "]}\n");
+	fclose(fp);
+}
+
+//------------------------------------------------------------------------------
+// Write the percentiles of every frame statistic and the histogram of every
+// sum to the log file, export the frame statistics and zones to files in the
+// Flatland directory (if profile export is enabled), then reset everything for
+// the next spot.
+//------------------------------------------------------------------------------
+
+void
+report_profile(void)
+{
+	frame_stat *stat_ptr;
+	profile_sum *sum_ptr;
+	char line[BUFSIZ];
+	int bucket;
+	float milliseconds_per_tick;
+
+	// Log the average time per frame and the histogram of each sum.
+
+	milliseconds_per_tick = 1000.0f / (float)get_ticks_per_second();
+	sum_ptr = profile_sum_list;
+	while (sum_ptr) {
+		if (sum_ptr->frames > 0) {
+			diagnose("Time spent in %s averaged %g ms per frame",
+				sum_ptr->name, (float)sum_ptr->total_ticks *
+				milliseconds_per_tick / (float)sum_ptr->frames);
+			line[0] = '\0';
+			for (bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++)
+				sprintf(line + strlen(line), " %d", sum_ptr->histogram[bucket]);
+			diagnose("  Frames per 2^n microsecond bucket:%s", line);
+		}
+		sum_ptr->reset();
+		sum_ptr = sum_ptr->next_profile_sum_ptr;
+	}
+
+	// Log the percentiles of each frame statistic, export the frame statistics
+	// if requested, then reset them.
+
+	stat_ptr = frame_stat_list;
+	while (stat_ptr) {
+		if (stat_ptr->name && stat_ptr->window_samples() > 0)
+			diagnose("Over the last %d frames, %s had mean %g, p50 %g, p95 %g, "
+				"p99 %g", stat_ptr->window_samples(), stat_ptr->name,
+				stat_ptr->mean(), stat_ptr->percentile(50),
+				stat_ptr->percentile(95), stat_ptr->percentile(99));
+		stat_ptr = stat_ptr->next_frame_stat_ptr;
+	}
+	if (profile_export_enabled)
+		write_frame_stats(flatland_dir + "frame_stats.csv");
+	stat_ptr = frame_stat_list;
+	while (stat_ptr) {
+		stat_ptr->reset();
+		stat_ptr = stat_ptr->next_frame_stat_ptr;
+	}
+
+	// Export the zones as a trace if requested, then reset the ring buffer.
+
+	if (profile_export_enabled)
+		write_profile_trace(flatland_dir + "trace.json");
+	zones_recorded = 0;
+}
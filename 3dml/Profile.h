@@ -0,0 +1,38 @@
+//******************************************************************************
+// $Header$
+//
+// The contents of this file are subject to the Flatland Public License 
+// Version 1.1 (the "License"); you may not use this file except in 
+// compliance with the License. You may obtain a copy of the License at 
+// http://www.3dml.org/FPL/ 
+//
+// Software distributed under the License is distributed on an "AS IS" basis,
+// WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+// the specific language governing rights and limitations under the License. 
+//
+// The Original Code is Rover. 
+//
+// The Initial Developer of the Original Code is Flatland Online, Inc. 
+// Portions created by Flatland are Copyright (C) 1998-2000 Flatland
+// Online Inc. All Rights Reserved. 
+//
+// Contributor(s): Philip Stephens.
+//******************************************************************************
+
+// Externally visible variables.
+
+extern bool profile_export_enabled;
+
+// Externally visible functions.
+
+void
+record_profile_zone(const char *name, __int64 start_ticks, __int64 end_ticks);
+
+frame_stat *
+find_frame_stat(const char *name);
+
+bool
+write_frame_stats(const char *file_path);
+
+void
+report_profile(void);
@@ -25,7 +25,6 @@
 #include <stdarg.h>
 #include <math.h>
 #include <crtdbg.h>
-#include <amdlib.h>
 #include "Classes.h"
 #include "Fileio.h"
 #include "Light.h"
@@ -34,16 +33,14 @@
 #include "Parser.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Profile.h"
 #include "Spans.h"
 #include "Utils.h"
 
-// Current translation and rotation matrices.
+// Current view matrix, which combines the player position, orientation and
+// camera offset into a single 3x4 matrix.
 
-static float curr_translate_matrix[16];
-static float curr_rotatey_matrix[16];
-static float curr_rotatex_matrix[16];
-static float curr_camera_matrix[16];
-static float curr_transform_matrix[16];
+static float curr_view_matrix[12];
 
 // List of solid colour spans, transparent screen polygons and colour screen
 // polygons.
@@ -75,10 +72,27 @@ static vertex block_centre;
 
 static vertex block_translation;
 
-// The current block's transformed vertex list.
+// The current block's transformed vertex list, and the outcode of each
+// transformed vertex.  An outcode has a bit set for each plane of the view
+// volume that the vertex lies outside of.
+
+#define OUTCODE_NEAR		1
+#define OUTCODE_LEFT		2
+#define OUTCODE_RIGHT		4
+#define OUTCODE_TOP			8
+#define OUTCODE_BOTTOM		16
+#define OUTCODE_ALL			31
 
 static int max_block_vertices;
 static vertex *block_tvertex_list;
+static byte *block_outcode_list;
+
+// The current block's vertex list in world space.  For a structural block 
+// this points to a list of the block definition's vertices after scaling and
+// translation.
+
+static vertex *block_vertex_list;
+static vertex *block_wvertex_list;
 
 // The current polygon's vertex colour list and front face visible flag.
 
@@ -153,11 +167,71 @@ DEFINE_SUM(scale_texture_cycles);
 DEFINE_SUM(cull_block_cycles);
 DEFINE_SUM(transform_vertex_cycles);
 
+// Statistics recorded for each frame.
+
+static frame_stat polygons_rendered_stat("polygons_rendered");
+static frame_stat polygons_processed_stat("polygons_processed");
+static frame_stat blocks_rendered_stat("blocks_rendered");
+static frame_stat blocks_processed_stat("blocks_processed");
+static frame_stat spans_stat("spans");
+static frame_stat spans_per_row_stat("spans_per_row");
+static frame_stat max_spans_per_row_stat("max_spans_per_row");
+static frame_stat cache_entries_added_stat("cache_entries_added");
+static frame_stat cache_entries_reused_stat("cache_entries_reused");
+
+// Flag indicating whether the screen polygons of static blocks are binned
+// into horizontal bands of span rows and rasterised one band at a time,
+// rather than rasterised as soon as they are clipped.
+
+#define BAND_ROWS			32
+#define BIN_FLUSH_POLYGONS	64
+
+bool polygon_binning_enabled;
+
+// List of binned screen polygons (linked through their secondary list
+// pointer), the last polygon in the list, and the number of polygons in it.
+
+static spolygon *binned_spolygon_list;
+static spolygon *last_binned_spolygon_ptr;
+static int binned_spolygons;
+
 // Current screen coordinates and size of orb.
 
 static float curr_orb_x, curr_orb_y;
 static float curr_orb_width, curr_orb_height;
 
+// A copy of the last frame rendered in software while nothing in the scene was
+// changing, the size of each row and number of rows in it, and a flag
+// indicating whether it can still be displayed.
+
+static byte *cached_frame_buffer_ptr;
+static int cached_frame_row_size, cached_frame_rows;
+static bool cached_frame_valid;
+
+// The mouse position, master brightness, visible radius and visible popup list
+// checksum that the cached frame was rendered with, and the mouse selection
+// that was found while rendering it.
+
+static int cached_mouse_x, cached_mouse_y;
+static float cached_master_brightness;
+static float cached_visible_radius;
+static unsigned int cached_popup_checksum;
+static bool cached_found_selection;
+static square *cached_selected_square_ptr;
+static hyperlink *cached_selected_exit_ptr;
+static square *cached_popup_square_ptr;
+static int cached_selected_polygon_no;
+static block_def *cached_selected_block_def_ptr;
+
+// Flag indicating whether anything that changes over time was rendered in the
+// current frame.
+
+static bool frame_is_animated;
+
+// Flag indicating whether the last frame was reused rather than rendered.
+
+bool frame_reused;
+
 //------------------------------------------------------------------------------
 // Initialise the renderer.
 //------------------------------------------------------------------------------
@@ -166,8 +240,13 @@ void
 init_renderer(void)
 {
 	block_tvertex_list = NULL;
+	block_outcode_list = NULL;
+	block_wvertex_list = NULL;
 	vertex_colour_list = NULL;
 	temp_spoint_list = NULL;
+	cached_frame_buffer_ptr = NULL;
+	cached_frame_valid = false;
+	frame_reused = false;
 	hardware_init_vertex_list();
 }
 
@@ -224,11 +303,17 @@ set_up_renderer(void)
 
 	set_max_screen_points(max_polygon_vertices + 5);
 
-	// Create the transformed vertex list.
+	// Create the transformed and world space vertex lists.
 
 	NEWARRAY(block_tvertex_list, vertex, max_block_vertices);
 	if (block_tvertex_list == NULL)
 		memory_error("block transformed vertex list");
+	NEWARRAY(block_outcode_list, byte, max_block_vertices);
+	if (block_outcode_list == NULL)
+		memory_error("block outcode list");
+	NEWARRAY(block_wvertex_list, vertex, max_block_vertices);
+	if (block_wvertex_list == NULL)
+		memory_error("block world vertex list");
 
 	// Create the vertex colour list.
 
@@ -255,6 +340,10 @@ clean_up_renderer(void)
 {
 	if (block_tvertex_list)
 		DELARRAY(block_tvertex_list, vertex, max_block_vertices);
+	if (block_outcode_list)
+		DELARRAY(block_outcode_list, byte, max_block_vertices);
+	if (block_wvertex_list)
+		DELARRAY(block_wvertex_list, vertex, max_block_vertices);
 	if (vertex_colour_list)
 		DELARRAY(vertex_colour_list, RGBcolour, max_polygon_vertices);
 	if (temp_spoint_list)
@@ -305,123 +394,156 @@ rotate_vertex(vertex *old_vertex_ptr, vertex *new_vertex_ptr)
 }
 
 //------------------------------------------------------------------------------
-// Set a matrix to translate a vertex by the player position.
+// Set the view matrix, which translates a vertex by the player position,
+// rotates it by the player turn and look angles, and then translates it by the
+// camera offset.
 //------------------------------------------------------------------------------
 
 static void
-set_translate_matrix(float *m)
+set_view_matrix(float *m)
 {
-	m[0] = 1.0f;		m[1] = 0.0f;		m[2] = 0.0f;	m[3] = 0.0f;
-	m[4] = 0.0f;		m[5] = 1.0f;		m[6] = 0.0f;	m[7] = 0.0f;
-	m[8] = 0.0f;		m[9] = 0.0f;		m[10] = 1.0f;	m[11] = 0.0f;
-	m[12] = -player_viewpoint.position.x;
-	m[13] = -player_viewpoint.position.y;
-	m[14] = -player_viewpoint.position.z;
-	m[15] = 1.0f;
+	float sin_turn = sine.table[player_viewpoint.inv_turn_angle];
+	float cos_turn = cosine.table[player_viewpoint.inv_turn_angle];
+	float sin_look = sine.table[player_viewpoint.inv_look_angle];
+	float cos_look = cosine.table[player_viewpoint.inv_look_angle];
+	vertex *position_ptr = &player_viewpoint.position;
+
+	// Combine the two rotations.
+
+	m[0] = cos_turn;
+	m[1] = 0.0f;
+	m[2] = sin_turn;
+	m[4] = sin_turn * sin_look;
+	m[5] = cos_look;
+	m[6] = -cos_turn * sin_look;
+	m[8] = -sin_turn * cos_look;
+	m[9] = sin_look;
+	m[10] = cos_turn * cos_look;
+
+	// The translation is the rotated player position, negated, less the
+	// camera offset.
+
+	m[3] = -(m[0] * position_ptr->x + m[1] * position_ptr->y +
+		m[2] * position_ptr->z) - player_camera_offset.dx;
+	m[7] = -(m[4] * position_ptr->x + m[5] * position_ptr->y +
+		m[6] * position_ptr->z) - player_camera_offset.dy;
+	m[11] = -(m[8] * position_ptr->x + m[9] * position_ptr->y +
+		m[10] * position_ptr->z) - player_camera_offset.dz;
 }
 
 //------------------------------------------------------------------------------
-// Set a matrix to rotate a vertex by the player turn angle.
+// Set a matrix that rotates a vertex around the current block's centre by the
+// given sprite angle, then transforms it by the view matrix.
 //------------------------------------------------------------------------------
 
 static void
-set_rotatey_matrix(float *m)
+set_sprite_matrix(float *m, float sprite_angle)
 {
-	float sin_angle = sine.table[player_viewpoint.inv_turn_angle];
-	float cos_angle = cosine.table[player_viewpoint.inv_turn_angle];
-	m[0] = cos_angle;	m[1] = 0.0f;		m[2] = -sin_angle;	m[3] = 0.0f; 
-	m[4] = 0.0f;		m[5] = 1.0f;		m[6] = 0.0f;		m[7] = 0.0f;
-	m[8] = sin_angle;	m[9] = 0.0f;		m[10] = cos_angle;	m[11] = 0.0f;
-	m[12] = 0.0f;		m[13] = 0.0f;		m[14] = 0.0f;		m[15] = 1.0f;
-}
+	float sin_angle = sine[sprite_angle];
+	float cos_angle = cosine[sprite_angle];
+	float offset_x, offset_z;
+	float *v = curr_view_matrix;
+	int row;
 
-//------------------------------------------------------------------------------
-// Set a matrix to rotate a vertex by the player look angle.
-//------------------------------------------------------------------------------
+	// Rotating around the block centre is the same as rotating around the
+	// origin and then adding this offset.
 
-static void
-set_rotatex_matrix(float *m)
-{
-	float sin_angle = sine.table[player_viewpoint.inv_look_angle];
-	float cos_angle = cosine.table[player_viewpoint.inv_look_angle];
-	m[0] = 1.0f;		m[1] = 0.0f;		m[2] = 0.0f;		m[3] = 0.0f; 
-	m[4] = 0.0f;		m[5] = cos_angle;	m[6] = sin_angle;	m[7] = 0.0f;
-	m[8] = 0.0f;		m[9] = -sin_angle;	m[10] = cos_angle;	m[11] = 0.0f;
-	m[12] = 0.0f;		m[13] = 0.0f;		m[14] = 0.0f;		m[15] = 1.0f;
+	offset_x = block_centre.x -
+		(block_centre.x * cos_angle + block_centre.z * sin_angle);
+	offset_z = block_centre.z -
+		(block_centre.z * cos_angle - block_centre.x * sin_angle);
+
+	// Multiply the view matrix by the rotation and offset.
+
+	for (row = 0; row < 12; row += 4) {
+		m[row] = v[row] * cos_angle - v[row + 2] * sin_angle;
+		m[row + 1] = v[row + 1];
+		m[row + 2] = v[row] * sin_angle + v[row + 2] * cos_angle;
+		m[row + 3] = v[row] * offset_x + v[row + 2] * offset_z + v[row + 3];
+	}
 }
 
 //------------------------------------------------------------------------------
-// Set a matrix to translate a vertex by the camera offset.
+// Set a matrix that rotates the player block by 180 degrees, tilts it by the
+// look angle, and translates it by the camera offset.
 //------------------------------------------------------------------------------
 
 static void
-set_camera_matrix(float *m)
+set_player_matrix(float *m)
 {
-	m[0] = 1.0f;		m[1] = 0.0f;		m[2] = 0.0f;	m[3] = 0.0f;
-	m[4] = 0.0f;		m[5] = 1.0f;		m[6] = 0.0f;	m[7] = 0.0f;
-	m[8] = 0.0f;		m[9] = 0.0f;		m[10] = 1.0f;	m[11] = 0.0f;
-	m[12] = -player_camera_offset.dx;
-	m[13] = -player_camera_offset.dy;
-	m[14] = -player_camera_offset.dz;
-	m[15] = 1.0f;
+	float sin_turn = sine[180.0f];
+	float cos_turn = cosine[180.0f];
+	float sin_look = sine[-player_viewpoint.look_angle];
+	float cos_look = cosine[-player_viewpoint.look_angle];
+
+	m[0] = cos_turn;
+	m[1] = 0.0f;
+	m[2] = sin_turn;
+	m[4] = sin_look * sin_turn;
+	m[5] = cos_look;
+	m[6] = -sin_look * cos_turn;
+	m[8] = -cos_look * sin_turn;
+	m[9] = sin_look;
+	m[10] = cos_look * cos_turn;
+	m[3] = -player_camera_offset.dx;
+	m[7] = -player_camera_offset.dy;
+	m[11] = -player_camera_offset.dz;
 }
 
 //------------------------------------------------------------------------------
-// Transform a vertex by the player position and orientation, and then adjust
-// by the current camera offset.
+// Transform a list of vertices by a 3x4 matrix into the block's transformed
+// vertex list, computing the outcode of each transformed vertex as we go.  The
+// outcodes of all the vertices ANDed together are returned; if this is not
+// zero, every vertex lies outside the same plane and the block is not visible.
 //------------------------------------------------------------------------------
 
-void
-transform_vertex(vertex *old_vertex_ptr, vertex *new_vertex_ptr)
+static byte
+transform_vertex_list(vertex *vertex_list, int vertices, float *m)
 {
-	// If AMD 3DNow! instructions are supported, perform the transformation
-	// via a matrix.
-
-	if (AMD_3DNow_supported) {
-		float temp_vertex1[4], temp_vertex2[4], temp_vertex3[4];
-
-//		_trans_v1x4(&new_vertex_ptr->x, curr_transform_matrix,
-//			&old_vertex_ptr->x);
-		_trans_v1x4(temp_vertex1, curr_translate_matrix, &old_vertex_ptr->x);
-		_trans_v1x4(temp_vertex2, curr_rotatey_matrix, temp_vertex1);
-		_trans_v1x4(temp_vertex3, curr_rotatex_matrix, temp_vertex2);
-		_trans_v1x4(&new_vertex_ptr->x, curr_camera_matrix, temp_vertex3);
-	}
-
-	// Otherwise perform the transformation the more traditional way...
-
-	else {
-		float tx, ty, tz;
-		float rx, ry, rz1, rz2;
-
-		// Translate the old vertex by the inverse of the player viewpoint.
-
-		tx = old_vertex_ptr->x - player_viewpoint.position.x;
-		ty = old_vertex_ptr->y - player_viewpoint.position.y;
-		tz = old_vertex_ptr->z - player_viewpoint.position.z;
-
-		// Rotate the vertex around the Y axis by the inverse of the player 
-		// turn  angle.
-
-		rx = tx * cosine.table[player_viewpoint.inv_turn_angle] + 
-			tz * sine.table[player_viewpoint.inv_turn_angle];
-		rz1 = tz * cosine.table[player_viewpoint.inv_turn_angle] - 
-			tx * sine.table[player_viewpoint.inv_turn_angle];
-
-		// Rotate the vertex around the X axis by the inverse of the player 
-		// look angle.
-
-		ry = ty * cosine.table[player_viewpoint.inv_look_angle] - 
-			rz1 * sine.table[player_viewpoint.inv_look_angle];
-		rz2 = rz1 * cosine.table[player_viewpoint.inv_look_angle] + 
-			ty * sine.table[player_viewpoint.inv_look_angle];
-
-		// Translate the vertex by the camera offset.
-
-		new_vertex_ptr->x = rx - player_camera_offset.dx;
-		new_vertex_ptr->y = ry - player_camera_offset.dy;
-		new_vertex_ptr->z = rz2 - player_camera_offset.dz;
+	vertex *vertex_ptr, *tvertex_ptr;
+	float x, y, z, tx, ty, tz;
+	float x_extent, y_extent;
+	int vertex_no;
+	byte outcode, outcodes;
+
+	// A transformed vertex projects inside the screen if it's x and y
+	// coordinates are within these multiples of it's z coordinate.
+
+	x_extent = half_window_width / pixels_per_world_unit;
+	y_extent = half_window_height / pixels_per_world_unit;
+
+	// Transform each vertex and compute it's outcode.
+
+	outcodes = OUTCODE_ALL;
+	vertex_ptr = vertex_list;
+	tvertex_ptr = block_tvertex_list;
+	for (vertex_no = 0; vertex_no < vertices; vertex_no++) {
+		x = vertex_ptr->x;
+		y = vertex_ptr->y;
+		z = vertex_ptr->z;
+		tx = m[0] * x + m[1] * y + m[2] * z + m[3];
+		ty = m[4] * x + m[5] * y + m[6] * z + m[7];
+		tz = m[8] * x + m[9] * y + m[10] * z + m[11];
+		tvertex_ptr->x = tx;
+		tvertex_ptr->y = ty;
+		tvertex_ptr->z = tz;
+		outcode = 0;
+		if (tz < 1.0f)
+			outcode |= OUTCODE_NEAR;
+		if (tx < -x_extent * tz)
+			outcode |= OUTCODE_LEFT;
+		else if (tx > x_extent * tz)
+			outcode |= OUTCODE_RIGHT;
+		if (ty > y_extent * tz)
+			outcode |= OUTCODE_TOP;
+		else if (ty < -y_extent * tz)
+			outcode |= OUTCODE_BOTTOM;
+		block_outcode_list[vertex_no] = outcode;
+		outcodes &= outcode;
+		vertex_ptr++;
+		tvertex_ptr++;
 	}
+	return(outcodes);
 }
 
 //------------------------------------------------------------------------------
@@ -692,14 +814,16 @@ add_spoint_to_list(vertex *tvertex_ptr, vertex_def *vertex_def_ptr,
 
 //------------------------------------------------------------------------------
 // Clip a transformed polygon against the viewing plane at z = 1, and store the
-// projected screen points in the polygon definition's screen point list.
+// projected screen points in the polygon definition's screen point list.  If
+// no vertex lies behind the viewing plane, the vertices are simply projected.
 //------------------------------------------------------------------------------
 
 static void
-clip_3D_polygon(polygon *polygon_ptr, pixmap *pixmap_ptr)
+clip_3D_polygon(polygon *polygon_ptr, pixmap *pixmap_ptr,
+				bool clip_to_viewing_plane)
 {
 	int vertices;
-	int vertex1_no, vertex2_no;
+	int vertex_no, vertex1_no, vertex2_no;
 
 	START_SUMMING;
 
@@ -719,11 +843,23 @@ clip_3D_polygon(polygon *polygon_ptr, pixmap *pixmap_ptr)
 	PREPARE_VERTEX_DEF_LIST(polygon_ptr);
 	vertices = polygon_ptr->vertices;
 
+	// If the polygon doesn't need clipping, project each transformed vertex
+	// into the screen point list.
+
+	spoints = 0;
+	if (!clip_to_viewing_plane) {
+		for (vertex_no = 0; vertex_no < vertices; vertex_no++)
+			add_spoint_to_list(
+				&block_tvertex_list[vertex_def_list[vertex_no].vertex_no],
+				&vertex_def_list[vertex_no], &vertex_colour_list[vertex_no]);
+		END_SUMMING(clip_3D_polygon_cycles);
+		return;
+	}
+
 	// Step through the transformed vertices of the polygon, checking the status
 	// of each edge compared against the viewing plane, and output the new
 	// set of vertices.
 
-	spoints = 0;
 	vertex1_no = vertices - 1;
 	for (vertex2_no = 0; vertex2_no < vertices; vertex2_no++) {
 		vertex_def *vertex1_def_ptr, *vertex2_def_ptr, clipped_vertex_def;
@@ -929,15 +1065,19 @@ clip_2D_line_to_y(spoint *spoint1_ptr, spoint *spoint2_ptr, float sy,
 }
 
 //------------------------------------------------------------------------------
-// Clip a projected polygon against the display screen.
+// Clip a projected polygon against those edges of the display screen that are
+// set in the given outcode.  Each pass reads from one screen point list and
+// writes to the other, so if an odd number of passes was made the result must
+// be copied back into the main screen point list.
 //------------------------------------------------------------------------------
 
 static void
-clip_2D_polygon(void)
+clip_2D_polygon(byte outcodes)
 {
 	int old_spoints, new_spoints;
 	int spoint1_no, spoint2_no;
 	float left_sx, right_sx, top_sy, bottom_sy;
+	spoint *old_spoint_list, *new_spoint_list, *temp_list;
 
 	START_SUMMING;
 
@@ -948,153 +1088,212 @@ clip_2D_polygon(void)
 	top_sy = 0.0;
 	bottom_sy = (float)window_height;
 
+	// Start with the main screen point list as the source list.
+
+	old_spoint_list = main_spoint_list;
+	new_spoint_list = temp_spoint_list;
+	new_spoints = spoints;
+
 	// Clip the projected polygon against the left display edge.
 
-	old_spoints = spoints;
-	new_spoints = 0;
-	spoint1_no = old_spoints - 1;
-	for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
-		spoint *spoint1_ptr, *spoint2_ptr;
+	if (outcodes & OUTCODE_LEFT) {
+		old_spoints = new_spoints;
+		new_spoints = 0;
+		spoint1_no = old_spoints - 1;
+		for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
+			spoint *spoint1_ptr, *spoint2_ptr;
 
-		// Get pointers to the screen points for this edge.
+			// Get pointers to the screen points for this edge.
 
-		spoint1_ptr = &main_spoint_list[spoint1_no];
-		spoint2_ptr = &main_spoint_list[spoint2_no];
+			spoint1_ptr = &old_spoint_list[spoint1_no];
+			spoint2_ptr = &old_spoint_list[spoint2_no];
 
-		// Compare the polygon edge against the left display edge and add zero,
-		// one or two screen points to the temporary screen point list.
+			// Compare the polygon edge against the left display edge and add
+			// zero, one or two screen points to the new screen point list.
 
-		if (spoint1_ptr->sx >= left_sx) {
-			if (spoint2_ptr->sx >= left_sx)
-				temp_spoint_list[new_spoints++] = *spoint2_ptr;
-			else
-				clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, left_sx, 
-					&temp_spoint_list[new_spoints++]);			
-		} else {
-			if (spoint2_ptr->sx >= left_sx) {
-				clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, left_sx,
-					&temp_spoint_list[new_spoints++]);
-				temp_spoint_list[new_spoints++] = *spoint2_ptr;
+			if (spoint1_ptr->sx >= left_sx) {
+				if (spoint2_ptr->sx >= left_sx)
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				else
+					clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, left_sx,
+						&new_spoint_list[new_spoints++]);
+			} else {
+				if (spoint2_ptr->sx >= left_sx) {
+					clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, left_sx,
+						&new_spoint_list[new_spoints++]);
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				}
 			}
+
+			// Move onto the next edge.
+
+			spoint1_no = spoint2_no;
 		}
-		
-		// Move onto the next edge.
-	
-		spoint1_no = spoint2_no;
+		temp_list = old_spoint_list;
+		old_spoint_list = new_spoint_list;
+		new_spoint_list = temp_list;
 	}
 
 	// Clip the projected polygon against the right display edge.
 
-	old_spoints = new_spoints;
-	new_spoints = 0;
-	spoint1_no = old_spoints - 1;
-	for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
-		spoint *spoint1_ptr, *spoint2_ptr;
+	if (outcodes & OUTCODE_RIGHT) {
+		old_spoints = new_spoints;
+		new_spoints = 0;
+		spoint1_no = old_spoints - 1;
+		for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
+			spoint *spoint1_ptr, *spoint2_ptr;
 
-		// Get pointers to the screen points for this edge.
+			// Get pointers to the screen points for this edge.
 
-		spoint1_ptr = &temp_spoint_list[spoint1_no];
-		spoint2_ptr = &temp_spoint_list[spoint2_no];
+			spoint1_ptr = &old_spoint_list[spoint1_no];
+			spoint2_ptr = &old_spoint_list[spoint2_no];
 
-		// Compare the polygon edge against the right display edge and add zero,
-		// one or two screen points to the main screen point list.
+			// Compare the polygon edge against the right display edge and add
+			// zero, one or two screen points to the new screen point list.
 
-		if (spoint1_ptr->sx <= right_sx) {
-			if (spoint2_ptr->sx <= right_sx)
-				main_spoint_list[new_spoints++] = *spoint2_ptr;
-			else
-				clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, right_sx, 
-					&main_spoint_list[new_spoints++]);			
-		} else {
-			if (spoint2_ptr->sx <= right_sx) {
-				clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, right_sx,
-					&main_spoint_list[new_spoints++]);
-				main_spoint_list[new_spoints++] = *spoint2_ptr;
+			if (spoint1_ptr->sx <= right_sx) {
+				if (spoint2_ptr->sx <= right_sx)
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				else
+					clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, right_sx,
+						&new_spoint_list[new_spoints++]);
+			} else {
+				if (spoint2_ptr->sx <= right_sx) {
+					clip_2D_line_to_x(spoint1_ptr, spoint2_ptr, right_sx,
+						&new_spoint_list[new_spoints++]);
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				}
 			}
+
+			// Move onto the next edge.
+
+			spoint1_no = spoint2_no;
 		}
-		
-		// Move onto the next edge.
-	
-		spoint1_no = spoint2_no;
+		temp_list = old_spoint_list;
+		old_spoint_list = new_spoint_list;
+		new_spoint_list = temp_list;
 	}
 
-	// Clip the projected polygon against the top screen edge.
+	// Clip the projected polygon against the top display edge.
 
-	old_spoints = new_spoints;
-	new_spoints = 0;
-	spoint1_no = old_spoints - 1;
-	for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
-		spoint *spoint1_ptr, *spoint2_ptr;
+	if (outcodes & OUTCODE_TOP) {
+		old_spoints = new_spoints;
+		new_spoints = 0;
+		spoint1_no = old_spoints - 1;
+		for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
+			spoint *spoint1_ptr, *spoint2_ptr;
 
-		// Get pointers to the screen points for this edge.
+			// Get pointers to the screen points for this edge.
 
-		spoint1_ptr = &main_spoint_list[spoint1_no];
-		spoint2_ptr = &main_spoint_list[spoint2_no];
+			spoint1_ptr = &old_spoint_list[spoint1_no];
+			spoint2_ptr = &old_spoint_list[spoint2_no];
 
-		// Compare the polygon edge against the top display edge add zero, one or
-		// two screen points to the temporary screen point list.
+			// Compare the polygon edge against the top display edge and add
+			// zero, one or two screen points to the new screen point list.
 
-		if (spoint1_ptr->sy >= top_sy) {
-			if (spoint2_ptr->sy >= top_sy)
-				temp_spoint_list[new_spoints++] = *spoint2_ptr;
-			else
-				clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, top_sy,
-					&temp_spoint_list[new_spoints++]);
-		} else {
-			if (spoint2_ptr->sy >= top_sy) {
-				clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, top_sy,
-					&temp_spoint_list[new_spoints++]);
-				temp_spoint_list[new_spoints++] = *spoint2_ptr;
+			if (spoint1_ptr->sy >= top_sy) {
+				if (spoint2_ptr->sy >= top_sy)
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				else
+					clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, top_sy,
+						&new_spoint_list[new_spoints++]);
+			} else {
+				if (spoint2_ptr->sy >= top_sy) {
+					clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, top_sy,
+						&new_spoint_list[new_spoints++]);
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				}
 			}
+
+			// Move onto the next edge.
+
+			spoint1_no = spoint2_no;
 		}
-		
-		// Move onto the next edge.
-	
-		spoint1_no = spoint2_no;
+		temp_list = old_spoint_list;
+		old_spoint_list = new_spoint_list;
+		new_spoint_list = temp_list;
 	}
 
-	// Clip the projected polygon against the bottom screen edge.
+	// Clip the projected polygon against the bottom display edge.
 
-	old_spoints = new_spoints;
-	new_spoints = 0;
-	spoint1_no = old_spoints - 1;
-	for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
-		spoint *spoint1_ptr, *spoint2_ptr;
+	if (outcodes & OUTCODE_BOTTOM) {
+		old_spoints = new_spoints;
+		new_spoints = 0;
+		spoint1_no = old_spoints - 1;
+		for (spoint2_no = 0; spoint2_no < old_spoints; spoint2_no++) {
+			spoint *spoint1_ptr, *spoint2_ptr;
 
-		// Get pointers to the screen points for this edge.
+			// Get pointers to the screen points for this edge.
 
-		spoint1_ptr = &temp_spoint_list[spoint1_no];
-		spoint2_ptr = &temp_spoint_list[spoint2_no];
+			spoint1_ptr = &old_spoint_list[spoint1_no];
+			spoint2_ptr = &old_spoint_list[spoint2_no];
 
-		// Compare the polygon edge against the bottom display edge and add zero,
-		// one or two screen points to the main screen point list.
+			// Compare the polygon edge against the bottom display edge and
+			// add zero, one or two screen points to the new screen point list.
 
-		if (spoint1_ptr->sy <= bottom_sy) {
-			if (spoint2_ptr->sy <= bottom_sy)
-				main_spoint_list[new_spoints++] = *spoint2_ptr;
-			else
-				clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, bottom_sy,
-					&main_spoint_list[new_spoints++]);
-		} else {
-			if (spoint2_ptr->sy <= bottom_sy) {
-				clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, bottom_sy,
-					&main_spoint_list[new_spoints++]);
-				main_spoint_list[new_spoints++] = *spoint2_ptr;
+			if (spoint1_ptr->sy <= bottom_sy) {
+				if (spoint2_ptr->sy <= bottom_sy)
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				else
+					clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, bottom_sy,
+						&new_spoint_list[new_spoints++]);
+			} else {
+				if (spoint2_ptr->sy <= bottom_sy) {
+					clip_2D_line_to_y(spoint1_ptr, spoint2_ptr, bottom_sy,
+						&new_spoint_list[new_spoints++]);
+					new_spoint_list[new_spoints++] = *spoint2_ptr;
+				}
 			}
+
+			// Move onto the next edge.
+
+			spoint1_no = spoint2_no;
 		}
-		
-		// Move onto the next edge.
-	
-		spoint1_no = spoint2_no;
+		temp_list = old_spoint_list;
+		old_spoint_list = new_spoint_list;
+		new_spoint_list = temp_list;
 	}
 
-	// Set the final number of screen points.
+	// If the clipped polygon ended up in the temporary screen point list,
+	// copy it back to the main screen point list.  Then set the final number
+	// of screen points.
 
+	if (old_spoint_list != main_spoint_list) {
+		int spoint_no;
+
+		for (spoint_no = 0; spoint_no < new_spoints; spoint_no++)
+			main_spoint_list[spoint_no] = old_spoint_list[spoint_no];
+	}
 	spoints = new_spoints;
 
 	END_SUMMING(clip_2D_polygon_cycles);
 }
 
+//------------------------------------------------------------------------------
+// Determine whether every screen point of the projected polygon lies within
+// the guard band, which extends one display width and height beyond each
+// edge of the display.
+//------------------------------------------------------------------------------
+
+static bool
+polygon_in_guard_band(void)
+{
+	float min_sx, max_sx, min_sy, max_sy;
+	int spoint_no;
+
+	min_sx = -(float)window_width;
+	max_sx = (float)(window_width * 2);
+	min_sy = -(float)window_height;
+	max_sy = (float)(window_height * 2);
+	for (spoint_no = 0; spoint_no < spoints; spoint_no++) {
+		spoint *spoint_ptr = &main_spoint_list[spoint_no];
+		if (spoint_ptr->sx < min_sx || spoint_ptr->sx > max_sx ||
+			spoint_ptr->sy < min_sy || spoint_ptr->sy > max_sy)
+			return(false);
+	}
+	return(true);
+}
+
 //------------------------------------------------------------------------------
 // Determine if the mouse is currently pointing at the given polygon.
 //------------------------------------------------------------------------------
@@ -1258,6 +1457,205 @@ prepare_next_right_edge(float scan_sy)
 	return(true);
 }
 
+//------------------------------------------------------------------------------
+// Add the rows of a screen polygon that lie between the given start row and
+// end row - 1 to the span buffer.  Rows that are already full are skipped,
+// unless the polygon belongs to a movable block.
+//------------------------------------------------------------------------------
+
+static void
+rasterise_screen_polygon(spolygon *spolygon_ptr, int start_row, int end_row,
+						 bool movable)
+{
+	spoint *left_spoint_ptr, *right_spoint_ptr;
+	float sy, end_sy;
+
+	// Make the screen polygon's point list the main screen point list, and
+	// obtain pointers to the screen points representing the bounding box of
+	// the polygon, as well as the last screen point in the list.
+
+	main_spoint_list = spolygon_ptr->spoint_list;
+	spoints = spolygon_ptr->spoints;
+	get_polygon_bounding_box(first_spoint_ptr, last_spoint_ptr,
+		top_spoint_ptr, bottom_spoint_ptr, left_spoint_ptr,
+		right_spoint_ptr);
+
+	// The ceiling of the top display y coordinate becomes the initial
+	// display y coordinate, and the ceiling of the bottom screen y
+	// coordinate becomes the last screen y coordinate + 1, both clamped to
+	// the requested rows.  If these are one and the same, then there is
+	// nothing to render.
+
+	sy = CEIL(top_spoint_ptr->sy);
+	end_sy = CEIL(bottom_spoint_ptr->sy);
+	if (sy < (float)start_row)
+		sy = (float)start_row;
+	if (end_sy > (float)end_row)
+		end_sy = (float)end_row;
+	if (sy >= end_sy)
+		return;
+
+	// Prepare the first left and right edge for rendering.  Since these are
+	// computed directly at the initial display y coordinate, a polygon that
+	// is rasterised in several bands produces the same spans as one that is
+	// rasterised all at once.
+
+	left_spoint2_ptr = top_spoint_ptr;
+	prepare_next_left_edge(sy);
+	right_spoint2_ptr = top_spoint_ptr;
+	prepare_next_right_edge(sy);
+
+	// Add the polygon to the span buffer row by row, recomputing the
+	// slopes of the interpolants as as we pass the next left and right
+	// vertex, until we've reached the bottom vertex or the last row.
+
+	while (sy < end_sy) {
+
+		// Add this span to the span buffer.  Rows that are already full
+		// are skipped, since a static block's span would be hidden.
+
+		if (movable)
+			add_movable_span((int)sy, &left_edge, &right_edge,
+				spolygon_ptr->pixmap_ptr, spolygon_ptr->colour_pixel,
+				spolygon_ptr->brightness_index);
+		else if (!(*span_buffer_ptr)[(int)sy]->full)
+			add_span((int)sy, &left_edge, &right_edge,
+				spolygon_ptr->pixmap_ptr, spolygon_ptr->colour_pixel,
+				spolygon_ptr->brightness_index, false);
+
+		// Move to next row.
+
+		sy += 1.0;
+		if (sy < left_spoint2_ptr->sy) {
+			left_edge.sx += left_slope.sx;
+			left_edge.one_on_tz += left_slope.one_on_tz;
+			left_edge.u_on_tz += left_slope.u_on_tz;
+			left_edge.v_on_tz += left_slope.v_on_tz;
+		} else if (!prepare_next_left_edge(sy))
+			break;
+		if (sy < right_spoint2_ptr->sy) {
+			right_edge.sx += right_slope.sx;
+			right_edge.one_on_tz += right_slope.one_on_tz;
+			right_edge.u_on_tz += right_slope.u_on_tz;
+			right_edge.v_on_tz += right_slope.v_on_tz;
+		} else if (!prepare_next_right_edge(sy))
+			break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Add a screen polygon to the end of the binned screen polygon list, recording
+// the rows it covers so that each band only rasterises the polygons that
+// overlap it.
+//------------------------------------------------------------------------------
+
+static void
+bin_screen_polygon(spolygon *spolygon_ptr)
+{
+	spoint *left_spoint_ptr, *right_spoint_ptr;
+	int start_sy, end_sy;
+
+	// Determine the rows covered by the polygon, and ignore it if there are
+	// none.
+
+	get_polygon_bounding_box(first_spoint_ptr, last_spoint_ptr,
+		top_spoint_ptr, bottom_spoint_ptr, left_spoint_ptr,
+		right_spoint_ptr);
+	start_sy = (int)CEIL(top_spoint_ptr->sy);
+	end_sy = (int)CEIL(bottom_spoint_ptr->sy);
+	if (start_sy < 0)
+		start_sy = 0;
+	if (end_sy > window_height)
+		end_sy = window_height;
+	if (start_sy >= end_sy)
+		return;
+	spolygon_ptr->start_sy = start_sy;
+	spolygon_ptr->end_sy = end_sy;
+
+	// Add the polygon to the end of the list, so that the front to back order
+	// of the polygons is preserved.
+
+	spolygon_ptr->next_spolygon_ptr2 = NULL;
+	if (last_binned_spolygon_ptr)
+		last_binned_spolygon_ptr->next_spolygon_ptr2 = spolygon_ptr;
+	else
+		binned_spolygon_list = spolygon_ptr;
+	last_binned_spolygon_ptr = spolygon_ptr;
+	binned_spolygons++;
+}
+
+//------------------------------------------------------------------------------
+// Rasterise the binned screen polygons one band of span rows at a time, then
+// empty the list.  Within a band the polygons are rasterised in the order they
+// were binned.  Full rows at the top of a band are skipped, and a band that is
+// entirely full is skipped altogether.
+//------------------------------------------------------------------------------
+
+static void
+rasterise_binned_polygons(void)
+{
+	int band_start_row, band_end_row, row;
+	spolygon *spolygon_ptr;
+
+	if (binned_spolygon_list == NULL)
+		return;
+	START_TIMING;
+	for (band_start_row = 0; band_start_row < window_height;
+		band_start_row += BAND_ROWS) {
+		band_end_row = band_start_row + BAND_ROWS;
+		if (band_end_row > window_height)
+			band_end_row = window_height;
+
+		// Find the first row in this band that isn't full.
+
+		for (row = band_start_row; row < band_end_row; row++)
+			if (!(*span_buffer_ptr)[row]->full)
+				break;
+		if (row == band_end_row)
+			continue;
+
+		// Rasterise the part of each binned polygon that overlaps the band.
+
+		spolygon_ptr = binned_spolygon_list;
+		while (spolygon_ptr) {
+			if (spolygon_ptr->start_sy < band_end_row &&
+				spolygon_ptr->end_sy > row)
+				rasterise_screen_polygon(spolygon_ptr, row, band_end_row,
+					false);
+			spolygon_ptr = spolygon_ptr->next_spolygon_ptr2;
+		}
+	}
+	binned_spolygon_list = NULL;
+	last_binned_spolygon_ptr = NULL;
+	binned_spolygons = 0;
+	END_TIMING("rasterise_binned_polygons");
+}
+
+//------------------------------------------------------------------------------
+// Determine whether every span row is full.  If enough polygons have been
+// binned, they are rasterised first.
+//------------------------------------------------------------------------------
+
+static bool
+span_buffer_full(void)
+{
+	if (binned_spolygons >= BIN_FLUSH_POLYGONS)
+		rasterise_binned_polygons();
+	return(full_span_rows == window_height);
+}
+
+//------------------------------------------------------------------------------
+// Determine whether a texture will show a different pixmap at some time after
+// the given elapsed time.
+//------------------------------------------------------------------------------
+
+static bool
+texture_is_animating(texture *texture_ptr, int elapsed_time_ms)
+{
+	return(texture_ptr->pixmaps > 1 && (texture_ptr->loops ||
+		elapsed_time_ms < texture_ptr->total_time_ms));
+}
+
 //------------------------------------------------------------------------------
 // Render a polygon.
 //------------------------------------------------------------------------------
@@ -1276,7 +1674,9 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 	part *part_ptr;
 	texture *texture_ptr;
 	pixmap *pixmap_ptr;
-	float sy, end_sy;
+	int vertex_no;
+	byte outcode, outcodes_or, outcodes_and;
+	int elapsed_time_ms;
 
 	START_SUMMING;
 
@@ -1284,6 +1684,23 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 
 	polygons_processed_late_in_frame++;
 
+	// Combine the outcodes of the polygon's vertices.  If every vertex lies
+	// outside the same plane of the view volume, the polygon cannot be seen
+	// and is rejected before it is lit or clipped.
+
+	PREPARE_VERTEX_DEF_LIST(polygon_ptr);
+	outcodes_or = 0;
+	outcodes_and = OUTCODE_ALL;
+	for (vertex_no = 0; vertex_no < polygon_ptr->vertices; vertex_no++) {
+		outcode = block_outcode_list[vertex_def_list[vertex_no].vertex_no];
+		outcodes_or |= outcode;
+		outcodes_and &= outcode;
+	}
+	if (outcodes_and) {
+		END_SUMMING(render_polygon_cycles);
+		return;
+	}
+
 	// Get a pointer to the part and texture.
 	
 	part_ptr = polygon_ptr->part_ptr;
@@ -1310,11 +1727,12 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 			break;
 		default:
 			if (texture_ptr->loops)
-				pixmap_ptr = texture_ptr->get_curr_pixmap_ptr(curr_time_ms -
-					start_time_ms);
+				elapsed_time_ms = curr_time_ms - start_time_ms;
 			else
-				pixmap_ptr = texture_ptr->get_curr_pixmap_ptr(curr_time_ms -
-					curr_block_ptr->start_time_ms);
+				elapsed_time_ms = curr_time_ms - curr_block_ptr->start_time_ms;
+			pixmap_ptr = texture_ptr->get_curr_pixmap_ptr(elapsed_time_ms);
+			if (texture_is_animating(texture_ptr, elapsed_time_ms))
+				frame_is_animated = true;
 		}
 	} else
 		pixmap_ptr = NULL;
@@ -1340,7 +1758,7 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 		// rotating them by the turn angle.  If the turn angle is zero, we skip
 		// that step to save time.
 
-		PREPARE_VERTEX_LIST(curr_block_ptr);
+		vertex *vertex_list = block_vertex_list;
 		PREPARE_VERTEX_DEF_LIST(polygon_ptr);
 		if (FEQ(turn_angle, 0.0f)) {
 			for (vertex_no = 0; vertex_no < polygon_ptr->vertices; vertex_no++) {
@@ -1387,20 +1805,29 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 		colour_pixel = RGB_to_display_pixel(colour);
 	}
 			
-	// Clip the polygon against the viewing plane, creating a new polygon
-	// whose screen points are in the main screen point list.
+	// Clip the polygon against the viewing plane if any vertex lies behind
+	// it, creating a new polygon whose screen points are in the main screen
+	// point list.
 	
-	clip_3D_polygon(polygon_ptr, pixmap_ptr);
+	clip_3D_polygon(polygon_ptr, pixmap_ptr,
+		(outcodes_or & OUTCODE_NEAR) != 0);
 
 	// Scale the texture interpolants in the main screen point list.
 
 	scale_texture_interpolants(pixmap_ptr, part_ptr->texture_style);
 
-	// Clip the projected polygon to the display screen.  If there are no screen
-	// points left after this  process, the polygon was off-screen and does not
+	// Clip the projected polygon against the display edges that any vertex
+	// lies outside of.  When rendering in software, a polygon that lies
+	// within the guard band is left unclipped, since every span is clamped to
+	// the display as it is added to the span buffer.  If there are no screen
+	// points left after this process, the polygon was off-screen and does not
 	// need to be rendered.
 
-	clip_2D_polygon();
+	outcodes_or &= ~OUTCODE_NEAR;
+	if (outcodes_or && !hardware_acceleration && polygon_in_guard_band())
+		outcodes_or = 0;
+	if (outcodes_or)
+		clip_2D_polygon(outcodes_or);
 	if (spoints == 0) {
 		END_SUMMING(render_polygon_cycles);
 		return;
@@ -1420,16 +1847,16 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 	// XXX -- movable blocks cannot be selected.
 
 	if (curr_square_ptr && !found_selection && check_for_polygon_selection() &&
-		(curr_square_ptr->exit_ptr || 
-		 (curr_square_ptr->popup_trigger_flags & MOUSE_TRIGGERS) ||
-		 (curr_square_ptr->block_trigger_flags & MOUSE_TRIGGERS) ||
-		 (curr_square_ptr->square_trigger_flags & MOUSE_TRIGGERS) ||
+		(curr_square_ptr->info_ptr->exit_ptr || 
+		 (curr_square_ptr->info_ptr->popup_trigger_flags & MOUSE_TRIGGERS) ||
+		 (BLOCK_TRIGGER_FLAGS(curr_square_ptr) & MOUSE_TRIGGERS) ||
+		 (curr_square_ptr->info_ptr->square_trigger_flags & MOUSE_TRIGGERS) ||
 		 (!hardware_acceleration || part_ptr->alpha == 1.0f) &&
 		 (!texture_ptr || !texture_ptr->transparent))) {
 		found_selection = true;
 		curr_selected_square_ptr = curr_square_ptr;
 		curr_popup_square_ptr = curr_square_ptr;
-		curr_selected_exit_ptr = curr_square_ptr->exit_ptr;
+		curr_selected_exit_ptr = curr_square_ptr->info_ptr->exit_ptr;
 		curr_selected_polygon_no = 
 			(polygon_ptr - curr_block_ptr->polygon_list) + 1;
 		curr_selected_block_def_ptr = curr_block_ptr->block_def_ptr;
@@ -1456,71 +1883,18 @@ render_polygon(polygon *polygon_ptr, float turn_angle)
 	}
 
 	// If we're not using hardware acceleration, perform the polygon
-	// rasterisation in software...
+	// rasterisation in software, either now or when the band it's binned
+	// into is rasterised.  Movable blocks are never binned, since they are
+	// rendered after the map is complete.
 
 	else {
-		spoint *left_spoint_ptr, *right_spoint_ptr;
-
-		// Obtain pointers to the screen points representing the bounding box of
-		// the polygon, as well as the last screen point in the list.
-
-		get_polygon_bounding_box(first_spoint_ptr, last_spoint_ptr, 
-			top_spoint_ptr, bottom_spoint_ptr, left_spoint_ptr, 
-			right_spoint_ptr);
-
-		// The ceiling of the top display y coordinate becomes the initial
-		// display y coordinate, and the ceiling of the bottom screen y
-		// coordinate becomes the last screen y coordinate + 1.  If these
-		// are one and the same, then there is nothing to render.
-
-		sy = CEIL(top_spoint_ptr->sy);
-		end_sy = CEIL(bottom_spoint_ptr->sy);
-		if (sy == end_sy) {
-			END_SUMMING(render_polygon_cycles);
-			return;
-		}	
-
-		// Prepare the first left and right edge for rendering.
-
-		left_spoint2_ptr = top_spoint_ptr;
-		prepare_next_left_edge(sy);
-		right_spoint2_ptr = top_spoint_ptr;
-		prepare_next_right_edge(sy);
-		
-		// Add the polygon to the span buffer row by row, recomputing the
-		// slopes of the interpolants as as we pass the next left and right
-		// vertex, until we've reached the bottom vertex or the bottom of
-		// the display.
-
-		while ((int)sy < window_height) {
-
-			// Add this span to the span buffer.
-
-			if (curr_block_movable)
-				add_movable_span((int)sy, &left_edge, &right_edge, pixmap_ptr,
-					colour_pixel, brightness_index);
-			else 
-				add_span((int)sy, &left_edge, &right_edge, pixmap_ptr, 
-					colour_pixel, brightness_index, false);
-
-			// Move to next row.
-
-			sy += 1.0;
-			if (sy < left_spoint2_ptr->sy) {
-				left_edge.sx += left_slope.sx;
-				left_edge.one_on_tz += left_slope.one_on_tz;
-				left_edge.u_on_tz += left_slope.u_on_tz;
-				left_edge.v_on_tz += left_slope.v_on_tz;
-			} else if (!prepare_next_left_edge(sy))
-				break;
-			if (sy < right_spoint2_ptr->sy) {
-				right_edge.sx += right_slope.sx;
-				right_edge.one_on_tz += right_slope.one_on_tz;
-				right_edge.u_on_tz += right_slope.u_on_tz;
-				right_edge.v_on_tz += right_slope.v_on_tz;
-			} else if (!prepare_next_right_edge(sy))
-				break;
-		}
+		spolygon_ptr->colour_pixel = colour_pixel;
+		spolygon_ptr->brightness_index = brightness_index;
+		if (polygon_binning_enabled && !curr_block_movable)
+			bin_screen_polygon(spolygon_ptr);
+		else
+			rasterise_screen_polygon(spolygon_ptr, 0, window_height,
+				curr_block_movable);
 	}
 
 	// Increment the number of polygons rendered in this block.
@@ -1543,21 +1917,15 @@ render_player_block(void)
 	float delta_x, delta_z;
 	float distance;
 	static float delta_distance = 0.0;
+	float player_matrix[12];
 
 	// Rotate the player sprite by 180 degrees, tilt the it by the look angle,
 	// and translate it by the current camera offset; the transformed vertices
 	// are put into a global list.
 
-	for (int vertex_no = 0; vertex_no < player_block_ptr->vertices;
-		vertex_no++) {
-		vertex temp_vertex;
-
-		temp_vertex = player_block_ptr->vertex_list[vertex_no];
-		temp_vertex.rotatey(180.0);
-		temp_vertex.rotatex(-player_viewpoint.look_angle);
-		temp_vertex -= player_camera_offset;
-		block_tvertex_list[vertex_no] = temp_vertex;
-	}
+	set_player_matrix(player_matrix);
+	transform_vertex_list(player_block_ptr->vertex_list,
+		player_block_ptr->vertices, player_matrix);
 
 	// Locate the closest lights to the player position.
 
@@ -1566,6 +1934,7 @@ render_player_block(void)
 	// Render the player sprite.
 
 	block_translation = player_block_ptr->translation;
+	block_vertex_list = player_block_ptr->vertex_list;
 	polygon_ptr = player_block_ptr->polygon_list;
 	front_face_visible = true;
 	curr_block_movable = true;
@@ -1633,7 +2002,7 @@ render_polygons_in_block(BSP_node *BSP_node_ptr)
 
 	polygon_no = BSP_node_ptr->polygon_no;
 	polygon_ptr = &curr_block_ptr->polygon_list[polygon_no];
-	polygon_active = curr_block_ptr->polygon_active_list[polygon_no];
+	polygon_active = POLYGON_ACTIVE(curr_block_ptr, polygon_no);
 	if (camera_in_front(polygon_ptr)) {
 		if (BSP_node_ptr->front_node_ptr)
 			render_polygons_in_block(BSP_node_ptr->front_node_ptr);
@@ -1684,6 +2053,7 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 	vertex min_block, max_block;
 	bool result;
 	int count;
+	byte outcodes;
 
 	START_SUMMING;
 
@@ -1765,9 +2135,11 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 		vector line_of_sight;
 		float sprite_angle;
 		
-		// Get a pointer to the sprite polygon.
+		// Get a pointer to the sprite polygon.  A sprite has it's own vertex
+		// list in world space.
 
 		polygon_ptr = curr_block_ptr->polygon_list;
+		block_vertex_list = curr_block_ptr->vertex_list;
 
 		// Compute the angle that the sprite is facing based upon it's type.
 
@@ -1795,6 +2167,7 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 				curr_block_ptr->sprite_angle = 
 					pos_adjust_angle(curr_block_ptr->sprite_angle + delta_angle);
 				curr_block_ptr->last_time_ms = curr_time_ms;
+				frame_is_animated = true;
 			}
 			sprite_angle = (float)curr_block_ptr->sprite_angle;
 			break;
@@ -1808,18 +2181,16 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 
 		// Rotate each vertex around the block's centre by the sprite angle,
 		// then transform each vertex by the player position and orientation,
-		// storing them in a global list.
+		// storing them in a global list.  Both steps are done with a single
+		// matrix.
 
 		{
+			float sprite_matrix[12];
+
 			START_SUMMING;
-			for (int vertex_no = 0; vertex_no < curr_block_ptr->vertices; 
-				vertex_no++) {
-				vertex temp_vertex = curr_block_ptr->vertex_list[vertex_no];
-				temp_vertex -= block_centre;
-				temp_vertex.rotatey(sprite_angle);
-				temp_vertex += block_centre;
-				transform_vertex(&temp_vertex, &block_tvertex_list[vertex_no]);
-			}
+			set_sprite_matrix(sprite_matrix, sprite_angle);
+			outcodes = transform_vertex_list(curr_block_ptr->vertex_list,
+				curr_block_ptr->vertices, sprite_matrix);
 			END_SUMMING(transform_vertex_cycles);
 		}
 
@@ -1864,7 +2235,7 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 
 		// Render the sprite polygon if it is visible.
 
-		if (polygon_visible(polygon_ptr, sprite_angle))
+		if (outcodes == 0 && polygon_visible(polygon_ptr, sprite_angle))
 			render_polygon(polygon_ptr, sprite_angle);
 	}
 	
@@ -1872,18 +2243,31 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 	
 	else {
 		
-		// Transform the vertices by the player's position, turn angle and look
+		// Scale and translate the block definition's vertices into place,
+		// then transform them by the player's position, turn angle and look
 		// angle, storing them in a global list.
 
 		{
 			START_SUMMING;
+			vertex *vertex_list = block_def_ptr->vertex_list;
+			float block_scale = world_ptr->block_scale;
 			for (int vertex_no = 0; vertex_no < curr_block_ptr->vertices; 
-				vertex_no++) {
-				vertex *vertex_ptr = &curr_block_ptr->vertex_list[vertex_no];
-				transform_vertex(vertex_ptr, &block_tvertex_list[vertex_no]);
-			}
+				vertex_no++)
+				block_wvertex_list[vertex_no] = vertex_list[vertex_no] *
+					block_scale + block_translation;
+			outcodes = transform_vertex_list(block_wvertex_list,
+				curr_block_ptr->vertices, curr_view_matrix);
 			END_SUMMING(transform_vertex_cycles);
 		}
+		block_vertex_list = block_wvertex_list;
+
+		// If every vertex is outside the same plane of the view volume, none
+		// of the block's polygons can be seen.
+
+		if (outcodes != 0) {
+			END_SUMMING(render_block_cycles);
+			return;
+		}
 
 		// If the block has a BSP tree, traverse it to render the polygons in 
 		// front-to-back order.  Otherwise render the active polygons in order
@@ -1900,7 +2284,7 @@ render_block(square *square_ptr, block *block_ptr, bool movable)
 			for (polygon_no = 0; polygon_no < curr_block_ptr->polygons;
 				polygon_no++) {
 				polygon_ptr = &curr_block_ptr->polygon_list[polygon_no];
-				polygon_active = curr_block_ptr->polygon_active_list[polygon_no];
+				polygon_active = POLYGON_ACTIVE(curr_block_ptr, polygon_no);
 				if (polygon_active && polygon_visible(polygon_ptr))
 					render_polygon(polygon_ptr, 0.0f);
 			}
@@ -1959,16 +2343,21 @@ render_blocks_on_map(int min_column, int min_row, int min_level,
 	// Traverse the blocks in an implicit BSP order: first the columns to the
 	// right and left of the camera, then the rows to the south and north of
 	// the camera, then the levels above and below the camera.  The camera block
-	// is rendered first.
+	// is rendered first.  Since this order is front to back, the traversal
+	// stops as soon as every span row is full.
 
 	for (column = camera_column; column <= max_column; column++) {
 		for (row = camera_row; row <= max_row; row++) {
+			if (span_buffer_full())
+				return;
 			for (level = camera_level; level <= max_level; level++)
 				render_block_on_square(column, row, level);
 			for (level = camera_level - 1; level >= min_level; level--)
 				render_block_on_square(column, row, level);
 		}
 		for (row = camera_row - 1; row >= min_row; row--) {
+			if (span_buffer_full())
+				return;
 			for (level = camera_level; level <= max_level; level++)
 				render_block_on_square(column, row, level);
 			for (level = camera_level - 1; level >= min_level; level--)
@@ -1977,12 +2366,16 @@ render_blocks_on_map(int min_column, int min_row, int min_level,
 	}
 	for (column = camera_column - 1; column >= min_column; column--) {
 		for (row = camera_row; row <= max_row; row++) {
+			if (span_buffer_full())
+				return;
 			for (level = camera_level; level <= max_level; level++)
 				render_block_on_square(column, row, level);
 			for (level = camera_level - 1; level >= min_level; level--)
 				render_block_on_square(column, row, level);
 		}
 		for (row = camera_row - 1; row >= min_row; row--) {
+			if (span_buffer_full())
+				return;
 			for (level = camera_level; level <= max_level; level++)
 				render_block_on_square(column, row, level);
 			for (level = camera_level - 1; level >= min_level; level--)
@@ -2114,6 +2507,7 @@ render_map(void)
 	max_view.get_scaled_map_position(&max_column, &min_row, &max_level);
 	render_blocks_on_map(min_column, min_row, min_level, 
 		max_column, max_row, max_level);
+	rasterise_binned_polygons();
 
 	END_TIMING("render_map");
 }
@@ -2452,6 +2846,8 @@ render_orb(void)
 
 	pixmap_ptr = orb_texture_ptr->get_curr_pixmap_ptr(curr_time_ms - 
 		start_time_ms);
+	if (texture_is_animating(orb_texture_ptr, curr_time_ms - start_time_ms))
+		frame_is_animated = true;
 
 	// Determine the position and size of the orb on the screen.
 
@@ -2533,7 +2929,7 @@ render_orb(void)
 			left_edge.v_on_tz = (top_offset + row) * height_scale;
 			right_edge.v_on_tz = (top_offset + row) * height_scale;
 			add_span((int)(curr_orb_y + row), &left_edge, &right_edge, 
-				pixmap_ptr, 0, orb_brightness_index, false);
+				pixmap_ptr, 0, orb_brightness_index, false, true);
 		}
 	}
 
@@ -2915,125 +3311,251 @@ render_transparent_polygons_or_spans(void)
 }
 
 //------------------------------------------------------------------------------
-// Render the entire frame.
+// Invalidate the cached frame, forcing the next frame to be rendered.  This
+// must be called whenever the scene is changed by something other than the
+// player viewpoint, such as a block being replaced or a texture being loaded.
 //------------------------------------------------------------------------------
 
 void
-render_frame(void)
+invalidate_frame_cache(void)
 {
-	square *prev_popup_square_ptr;
-	pixmap *sky_pixmap_ptr;
-	float sky_start_u, sky_start_v, sky_end_u, sky_end_v;
-	texture *texture_ptr;
-	pixmap *pixmap_ptr;
-	int row;
-	texture *bg_texture_ptr, *fg_texture_ptr;
-	int popup_width, popup_height;
+	cached_frame_valid = false;
+}
+
+//------------------------------------------------------------------------------
+// Delete the cached frame.
+//------------------------------------------------------------------------------
+
+void
+delete_frame_cache(void)
+{
+	if (cached_frame_buffer_ptr) {
+		DELARRAY(cached_frame_buffer_ptr, byte,
+			cached_frame_row_size * cached_frame_rows);
+		cached_frame_buffer_ptr = NULL;
+	}
+	cached_frame_valid = false;
+}
+
+//------------------------------------------------------------------------------
+// Compute a checksum of the visible popup list, which changes if a popup is
+// shown, hidden, moved or animated.
+//------------------------------------------------------------------------------
+
+static unsigned int
+get_visible_popup_checksum(void)
+{
+	popup *popup_ptr;
+	unsigned int checksum;
+
+	checksum = 0;
+	popup_ptr = visible_popup_list;
+	while (popup_ptr) {
+		checksum = checksum * 31 + (unsigned int)(size_t)popup_ptr;
+		checksum = checksum * 31 +
+			(unsigned int)(size_t)popup_ptr->bg_pixmap_ptr;
+		checksum = checksum * 31 + (unsigned int)popup_ptr->sx;
+		checksum = checksum * 31 + (unsigned int)popup_ptr->sy;
+		popup_ptr = popup_ptr->next_visible_popup_ptr;
+	}
+	return(checksum);
+}
 
-	// If AMD 3DNow! instructions are supported, calculate the current
-	// transformation matrix.
+//------------------------------------------------------------------------------
+// Determine whether any light changes over time.
+//------------------------------------------------------------------------------
 
-	if (AMD_3DNow_supported) {
-//		float temp_matrix1[16], temp_matrix2[16];
+static bool
+lights_are_changing(void)
+{
+	light *light_ptr;
+
+	light_ptr = global_light_list;
+	while (light_ptr) {
+		switch (light_ptr->style) {
+		case PULSATING_POINT_LIGHT:
+		case REVOLVING_SPOT_LIGHT:
+		case SEARCHING_SPOT_LIGHT:
+			return(true);
+		}
+		light_ptr = light_ptr->next_light_ptr;
+	}
+	return(false);
+}
 
-		// Set the translation and rotation matrices for the current player
-		// viewpoint.
+//------------------------------------------------------------------------------
+// Determine whether the frame just rendered can be cached.  This is only
+// possible in software rendering mode, and only if the viewpoint is standing
+// still and nothing that was rendered changes over time.
+//------------------------------------------------------------------------------
 
-		set_translate_matrix(curr_translate_matrix);
-		set_rotatey_matrix(curr_rotatey_matrix);
-		set_rotatex_matrix(curr_rotatex_matrix);
-		set_camera_matrix(curr_camera_matrix);
+static bool
+frame_can_be_cached(void)
+{
+	return(!hardware_acceleration && !viewpoint_has_changed &&
+		!frame_is_animated && !overdraw_mode && !stream_set &&
+		!lights_are_changing());
+}
 
-		// Multiply these together to form the transformation matrix.
-		// XXX -- For some reason this doesn't generate the correct
-		// transformation matrix.
+//------------------------------------------------------------------------------
+// Copy the frame just rendered into the cached frame, and remember the state
+// it was rendered with.  If the cached frame cannot be created, it is simply
+// not used.
+//------------------------------------------------------------------------------
 
-//		_mul_m4x4(temp_matrix1, curr_translate_matrix, curr_rotatey_matrix);
-//		_mul_m4x4(temp_matrix2, temp_matrix1, curr_rotatex_matrix);
-//		_mul_m4x4(curr_transform_matrix, temp_matrix2, curr_camera_matrix);
+static void
+save_cached_frame(unsigned int popup_checksum)
+{
+	int row_size, row;
+	int bytes_per_pixel;
+	byte *fb_ptr, *cache_ptr;
+
+	// Determine the size of a row in the frame buffer.  At a display depth of
+	// 8, the frame buffer holds 16-bit pixels.
+
+	bytes_per_pixel = display_depth == 8 ? 2 : (display_depth + 7) / 8;
+	row_size = window_width * bytes_per_pixel;
+
+	// If the cached frame is the wrong size, delete it, then create it if
+	// necessary.
+
+	if (cached_frame_buffer_ptr && (cached_frame_row_size != row_size ||
+		cached_frame_rows != window_height))
+		delete_frame_cache();
+	if (cached_frame_buffer_ptr == NULL) {
+		NEWARRAY(cached_frame_buffer_ptr, byte, row_size * window_height);
+		if (cached_frame_buffer_ptr == NULL) {
+			cached_frame_valid = false;
+			return;
+		}
+		cached_frame_row_size = row_size;
+		cached_frame_rows = window_height;
 	}
 
-	// Reset counters.
+	// Copy each row of the frame buffer into the cached frame.
 
-	polygons_rendered_in_frame = 0;
-	polygons_processed_in_frame = 0;
-	polygons_processed_late_in_frame = 0;
-	blocks_rendered_in_frame = 0;
-	blocks_processed_in_frame = 0;
-	cache_entries_added_in_frame = 0;
-	cache_entries_reused_in_frame = 0;
-	cache_entries_free_in_frame = 0;
+	fb_ptr = frame_buffer_ptr;
+	cache_ptr = cached_frame_buffer_ptr;
+	for (row = 0; row < window_height; row++) {
+		memcpy(cache_ptr, fb_ptr, row_size);
+		fb_ptr += frame_buffer_width;
+		cache_ptr += row_size;
+	}
 
-	CLEAR_SUM(render_block_cycles);
-	CLEAR_SUM(cull_block_cycles);
-	CLEAR_SUM(find_light_cycles);
-	CLEAR_SUM(render_polygon_cycles);
-	CLEAR_SUM(clip_3D_polygon_cycles);
-	CLEAR_SUM(clip_2D_polygon_cycles);
-	CLEAR_SUM(lighting_cycles);
-	CLEAR_SUM(scale_texture_cycles);
-	CLEAR_SUM(transform_vertex_cycles);
-	START_TIMING;
+	// Remember the state the frame was rendered with.
 
-	// Lock the frame buffer.
+	cached_mouse_x = mouse_x;
+	cached_mouse_y = mouse_y;
+	cached_master_brightness = master_brightness;
+	cached_visible_radius = visible_radius;
+	cached_popup_checksum = popup_checksum;
+	cached_frame_valid = true;
+}
 
-	lock_frame_buffer(frame_buffer_ptr, frame_buffer_width);
+//------------------------------------------------------------------------------
+// Determine whether the cached frame can be displayed again.  This requires
+// that the viewpoint, mouse position, master brightness, visible radius and
+// visible popups are the same as when it was rendered.
+//------------------------------------------------------------------------------
 
-	// Reset the span and screen polygon lists.
+static bool
+cached_frame_can_be_reused(unsigned int popup_checksum)
+{
+	return(cached_frame_valid && !hardware_acceleration &&
+		!viewpoint_has_changed && !overdraw_mode && !stream_set &&
+		mouse_x == cached_mouse_x && mouse_y == cached_mouse_y &&
+		master_brightness == cached_master_brightness &&
+		visible_radius == cached_visible_radius &&
+		popup_checksum == cached_popup_checksum);
+}
 
-	colour_span_list = NULL;
-	transparent_spolygon_list = NULL;
-	colour_spolygon_list = NULL;
+//------------------------------------------------------------------------------
+// Copy the cached frame back into the frame buffer and unlock it, then restore
+// the mouse selection found while rendering the cached frame, unless a popup
+// has already been selected.
+//------------------------------------------------------------------------------
 
-	// Reset the screen polygon list.
+static void
+reuse_cached_frame(void)
+{
+	int row;
+	byte *fb_ptr, *cache_ptr;
 
-	reset_screen_polygon_list();
+	// Copy each row of the cached frame into the frame buffer, then unlock
+	// the frame buffer.
 
-	// Reset the number of the currently selected polygon.
+	fb_ptr = frame_buffer_ptr;
+	cache_ptr = cached_frame_buffer_ptr;
+	for (row = 0; row < cached_frame_rows; row++) {
+		memcpy(fb_ptr, cache_ptr, cached_frame_row_size);
+		fb_ptr += frame_buffer_width;
+		cache_ptr += cached_frame_row_size;
+	}
+	unlock_frame_buffer();
 
-	curr_selected_polygon_no = 0;
+	// Restore the mouse selection.
 
-	// Remember the previous square selected, then reset the current square
-	// selected.
+	if (!found_selection) {
+		found_selection = cached_found_selection;
+		curr_selected_square_ptr = cached_selected_square_ptr;
+		curr_selected_exit_ptr = cached_selected_exit_ptr;
+		curr_popup_square_ptr = cached_popup_square_ptr;
+		curr_selected_polygon_no = cached_selected_polygon_no;
+		curr_selected_block_def_ptr = cached_selected_block_def_ptr;
+	}
+}
 
-	prev_selected_square_ptr = curr_selected_square_ptr;
-	curr_selected_square_ptr = NULL;
+//------------------------------------------------------------------------------
+// Render the scene into the locked frame buffer, then unlock it.
+//------------------------------------------------------------------------------
 
-	// Remember the previous exit selected, and reset the current exit
-	// selected.
+static void
+render_scene(unsigned int popup_checksum)
+{
+	pixmap *sky_pixmap_ptr;
+	float sky_start_u, sky_start_v, sky_end_u, sky_end_v;
+	texture *texture_ptr;
+	pixmap *pixmap_ptr;
+	int row, row_spans, max_row_spans, opaque_spans;
 
-	prev_selected_exit_ptr = curr_selected_exit_ptr;
-	curr_selected_exit_ptr = NULL;
+	// Reset the flag indicating whether anything that changes over time has
+	// been rendered.
 
-	// Remember the previous area selected and it's square, and reset the
-	// current area selected and it's square.
+	frame_is_animated = false;
 
-	prev_selected_area_ptr = curr_selected_area_ptr;
-	prev_area_square_ptr = curr_area_square_ptr;
-	curr_selected_area_ptr = NULL;
-	curr_area_square_ptr = NULL;
+	// Reset the span and screen polygon lists.
 
-	// Remember the previous popup square, and reset the current popup square.
+	colour_span_list = NULL;
+	transparent_spolygon_list = NULL;
+	colour_spolygon_list = NULL;
 
-	prev_popup_square_ptr = curr_popup_square_ptr;
-	curr_popup_square_ptr = NULL;
+	// Reset the free span list and the screen polygon list, making everything
+	// allocated from them last frame available again.
 
-	// Reset the current popup square and popup.
+	reset_free_span_list();
+	reset_screen_polygon_list();
 
-	found_selection = false;
-	curr_popup_square_ptr = NULL;
-	curr_popup_ptr = NULL;
+	// If the overdraw display is on, clear the overdraw buffer.  If it can't
+	// be created, turn the overdraw display off.
 
-	// Create the visible popup list.
+	if (overdraw_mode && !hardware_acceleration && !start_overdraw_frame())
+		overdraw_mode = false;
 
-	create_visible_popup_list();
+	// If the z-buffer is enabled, clear it.  If it can't be created, fall back
+	// to the span buffer.
+
+	if (z_buffer_enabled && !hardware_acceleration && !start_z_buffer_frame())
+		z_buffer_enabled = false;
 
 	// Get the sky pixmap, if there is one.
 
-	if (sky_texture_ptr)
+	if (sky_texture_ptr) {
 		sky_pixmap_ptr = sky_texture_ptr->get_curr_pixmap_ptr(curr_time_ms - 
 			start_time_ms);
-	else
+		if (texture_is_animating(sky_texture_ptr, curr_time_ms -
+			start_time_ms))
+			frame_is_animated = true;
+	} else
 		sky_pixmap_ptr = NULL;
 
 	// Compute the top-left and bottom-right texture coordinates for the sky,
@@ -3061,6 +3583,11 @@ render_frame(void)
 	camera_position.rotatey(player_viewpoint.turn_angle);
 	camera_position += player_viewpoint.position;
 
+	// Reset the count of full span rows, so that a count left over from a
+	// software frame doesn't stop blocks being rendered in hardware.
+
+	full_span_rows = 0;
+
 	// If using hardware acceleration...
 	
 	if (hardware_acceleration) {
@@ -3082,11 +3609,8 @@ render_frame(void)
 
 		// Clear the span buffer.
 
-		for (row = 0; row < window_height; row++) {
-			span_row *span_row_ptr = (*span_buffer_ptr)[row];
-			span_row_ptr->opaque_span_list = NULL;
-			span_row_ptr->transparent_span_list = NULL;
-		}
+		for (row = 0; row < window_height; row++)
+			(*span_buffer_ptr)[row]->clear(window_width);
 
 		// Render the visible popups in front to back order.
 
@@ -3175,17 +3699,27 @@ render_frame(void)
 	if (player_block_ptr)
 		render_player_block();
 
+	// If the z-buffer is enabled, convert it into span buffer rows.
+
+	if (z_buffer_enabled && !hardware_acceleration)
+		resolve_z_buffer();
+
 	// If not using hardware acceleration, step through all opaque spans in the
 	// span buffer, and add each to the span list of the pixmap associated with
-	// that span.  Solid colour spans go in their own list.
+	// that span.  Solid colour spans go in their own list.  Count the spans
+	// in each row as we go.
 
+	opaque_spans = 0;
+	max_row_spans = 0;
 	if (!hardware_acceleration) {
 		for (row = 0; row < window_height; row++) {
 			span_row *span_row_ptr = (*span_buffer_ptr)[row];
 			span *span_ptr = span_row_ptr->opaque_span_list;
+			row_spans = 0;
 			while (span_ptr) {
 				int brightness_index;
 				span *next_span_ptr = span_ptr->next_span_ptr;
+				row_spans++;
 				pixmap_ptr = span_ptr->pixmap_ptr;
 				brightness_index = span_ptr->brightness_index;
 				if (pixmap_ptr) {
@@ -3199,6 +3733,9 @@ render_frame(void)
 				}
 				span_ptr = next_span_ptr;
 			}
+			opaque_spans += row_spans;
+			if (row_spans > max_row_spans)
+				max_row_spans = row_spans;
 		}
 	}
 
@@ -3217,12 +3754,25 @@ render_frame(void)
 	render_colour_polygons_or_spans();
 	render_transparent_polygons_or_spans();
 
+	// If the overdraw display is on, render it over the top of the frame.
+
+	if (overdraw_mode && !hardware_acceleration)
+		render_overdraw();
+
 #ifdef RENDERSTATS
 	end_render_time_ms = get_time_ms();
 	diagnose("Polygon rendering time = %d ms",
 		end_render_time_ms - start_render_time_ms);
 #endif
 
+	// If nothing in the scene is changing, keep a copy of the frame so that it
+	// can be displayed again instead of being rendered.
+
+	if (frame_can_be_cached())
+		save_cached_frame(popup_checksum);
+	else
+		cached_frame_valid = false;
+
 	// Unlock the frame buffer.
 
 	unlock_frame_buffer();
@@ -3243,6 +3793,125 @@ render_frame(void)
 		}
 	}
 
+	// Record the statistics for this frame.
+
+	polygons_rendered_stat.add_sample((float)polygons_rendered_in_frame);
+	polygons_processed_stat.add_sample((float)polygons_processed_in_frame);
+	blocks_rendered_stat.add_sample((float)blocks_rendered_in_frame);
+	blocks_processed_stat.add_sample((float)blocks_processed_in_frame);
+	spans_stat.add_sample((float)spans_in_frame());
+	spans_per_row_stat.add_sample((float)opaque_spans / (float)window_height);
+	max_spans_per_row_stat.add_sample((float)max_row_spans);
+	cache_entries_added_stat.add_sample((float)cache_entries_added_in_frame);
+	cache_entries_reused_stat.add_sample((float)cache_entries_reused_in_frame);
+
+#ifdef RENDERSTATS
+	diagnose("Polygons rendered in this frame = %d of %d processed (%g%%)",
+		polygons_rendered_in_frame, polygons_processed_in_frame,
+		(float)polygons_rendered_in_frame / (float)polygons_processed_in_frame *
+		100.0f);
+	diagnose("Polygons reaching render_polygon() function = %d of %d processed "
+		"(%g%%)", polygons_processed_late_in_frame, polygons_processed_in_frame,
+		(float)polygons_processed_late_in_frame / 
+		(float)polygons_processed_in_frame * 100.0f);
+	diagnose("Blocks rendered in this frame = %d of %d processed (%g%%)",
+		blocks_rendered_in_frame, blocks_processed_in_frame,
+		(float)blocks_rendered_in_frame / (float)blocks_processed_in_frame * 
+		100.0f);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Render the entire frame.
+//------------------------------------------------------------------------------
+
+void
+render_frame(void)
+{
+	square *prev_popup_square_ptr;
+	texture *bg_texture_ptr, *fg_texture_ptr;
+	int popup_width, popup_height;
+	unsigned int popup_checksum;
+
+	// Calculate the view matrix for this frame.
+
+	set_view_matrix(curr_view_matrix);
+
+	// Reset counters.
+
+	polygons_rendered_in_frame = 0;
+	polygons_processed_in_frame = 0;
+	polygons_processed_late_in_frame = 0;
+	blocks_rendered_in_frame = 0;
+	blocks_processed_in_frame = 0;
+	cache_entries_added_in_frame = 0;
+	cache_entries_reused_in_frame = 0;
+	cache_entries_free_in_frame = 0;
+
+	CLEAR_SUM(render_block_cycles);
+	CLEAR_SUM(cull_block_cycles);
+	CLEAR_SUM(find_light_cycles);
+	CLEAR_SUM(render_polygon_cycles);
+	CLEAR_SUM(clip_3D_polygon_cycles);
+	CLEAR_SUM(clip_2D_polygon_cycles);
+	CLEAR_SUM(lighting_cycles);
+	CLEAR_SUM(scale_texture_cycles);
+	CLEAR_SUM(transform_vertex_cycles);
+	START_TIMING;
+
+	// Lock the frame buffer.
+
+	lock_frame_buffer(frame_buffer_ptr, frame_buffer_width);
+
+	// Reset the number of the currently selected polygon.
+
+	curr_selected_polygon_no = 0;
+
+	// Remember the previous square selected, then reset the current square
+	// selected.
+
+	prev_selected_square_ptr = curr_selected_square_ptr;
+	curr_selected_square_ptr = NULL;
+
+	// Remember the previous exit selected, and reset the current exit
+	// selected.
+
+	prev_selected_exit_ptr = curr_selected_exit_ptr;
+	curr_selected_exit_ptr = NULL;
+
+	// Remember the previous area selected and it's square, and reset the
+	// current area selected and it's square.
+
+	prev_selected_area_ptr = curr_selected_area_ptr;
+	prev_area_square_ptr = curr_area_square_ptr;
+	curr_selected_area_ptr = NULL;
+	curr_area_square_ptr = NULL;
+
+	// Remember the previous popup square, and reset the current popup square.
+
+	prev_popup_square_ptr = curr_popup_square_ptr;
+	curr_popup_square_ptr = NULL;
+
+	// Reset the current popup square and popup.
+
+	found_selection = false;
+	curr_popup_square_ptr = NULL;
+	curr_popup_ptr = NULL;
+
+	// Create the visible popup list.
+
+	create_visible_popup_list();
+
+	// If nothing has changed since the cached frame was rendered, display it
+	// again, otherwise render the scene.
+
+	popup_checksum = get_visible_popup_checksum();
+	frame_reused = cached_frame_can_be_reused(popup_checksum);
+	if (frame_reused)
+		reuse_cached_frame();
+	else
+		render_scene(popup_checksum);
+
 	// If the viewpoint has changed since the last frame, reset the current
 	// popup square, and if there was a previous popup square make all popups on
 	// that square with a rollover trigger invisible.
@@ -3250,7 +3919,7 @@ render_frame(void)
 	if (viewpoint_has_changed) {
 		curr_popup_square_ptr = NULL;
 		if (prev_popup_square_ptr) {
-			popup *popup_ptr = prev_popup_square_ptr->popup_list;
+			popup *popup_ptr = prev_popup_square_ptr->info_ptr->popup_list;
 			while (popup_ptr) {
 				if ((popup_ptr->trigger_flags & ROLLOVER) != 0)
 					popup_ptr->visible_flags &= ~ROLLOVER;
@@ -3274,7 +3943,7 @@ render_frame(void)
 		// with a rollover trigger invisible.
 
 		if (prev_popup_square_ptr) {
-			popup *popup_ptr = prev_popup_square_ptr->popup_list;
+			popup *popup_ptr = prev_popup_square_ptr->info_ptr->popup_list;
 			while (popup_ptr) {
 				if ((popup_ptr->trigger_flags & ROLLOVER) != 0)
 					popup_ptr->visible_flags &= ~ROLLOVER;
@@ -3286,7 +3955,7 @@ render_frame(void)
 		// with a rollover trigger visible.
 
 		if (curr_popup_square_ptr) {
-			popup *popup_ptr = curr_popup_square_ptr->popup_list;
+			popup *popup_ptr = curr_popup_square_ptr->info_ptr->popup_list;
 			while (popup_ptr) {
 				if ((popup_ptr->trigger_flags & ROLLOVER) != 0) {
 
@@ -3327,6 +3996,18 @@ render_frame(void)
 		curr_selected_exit_ptr = orb_exit_ptr;
 	}
 
+	// If the scene was rendered, remember the mouse selection that was found
+	// so that it can be restored if the frame is reused.
+
+	if (!frame_reused) {
+		cached_found_selection = found_selection;
+		cached_selected_square_ptr = curr_selected_square_ptr;
+		cached_selected_exit_ptr = curr_selected_exit_ptr;
+		cached_popup_square_ptr = curr_popup_square_ptr;
+		cached_selected_polygon_no = curr_selected_polygon_no;
+		cached_selected_block_def_ptr = curr_selected_block_def_ptr;
+	}
+
 	// Update the total polygons rendered.
 
 	total_polygons_rendered += polygons_rendered_in_frame;
@@ -3341,19 +4022,4 @@ render_frame(void)
 	REPORT_SUM("clip_2D_polygon", clip_2D_polygon_cycles);
 	REPORT_SUM("lighting polygons", lighting_cycles);
 	REPORT_SUM("scaling textures", scale_texture_cycles);
-
-#ifdef RENDERSTATS
-	diagnose("Polygons rendered in this frame = %d of %d processed (%g%%)",
-		polygons_rendered_in_frame, polygons_processed_in_frame,
-		(float)polygons_rendered_in_frame / (float)polygons_processed_in_frame *
-		100.0f);
-	diagnose("Polygons reaching render_polygon() function = %d of %d processed "
-		"(%g%%)", polygons_processed_late_in_frame, polygons_processed_in_frame,
-		(float)polygons_processed_late_in_frame / 
-		(float)polygons_processed_in_frame * 100.0f);
-	diagnose("Blocks rendered in this frame = %d of %d processed (%g%%)",
-		blocks_rendered_in_frame, blocks_processed_in_frame,
-		(float)blocks_rendered_in_frame / (float)blocks_processed_in_frame * 
-		100.0f);
-#endif
 }
\ No newline at end of file
@@ -21,6 +21,14 @@
 
 extern float one_on_dimensions_list[IMAGE_SIZES];
 
+// Flag indicating whether screen polygons are binned into bands of rows.
+
+extern bool polygon_binning_enabled;
+
+// Flag indicating whether the last frame was reused rather than rendered.
+
+extern bool frame_reused;
+
 // Externally visible functions.
 
 void 
@@ -45,7 +53,10 @@ void
 rotate_vertex(vertex *old_vertex_ptr, vertex *new_vertex_ptr);
 
 void
-transform_vertex(vertex *old_vertex_ptr, vertex *new_vertex_ptr);
+invalidate_frame_cache(void);
+
+void
+delete_frame_cache(void);
 
 void 
 render_frame(void);
@@ -41,12 +41,448 @@ int image_dimensions_list[IMAGE_SIZES] = {
 	256, 128, 64, 32, 16, 8, 4, 2
 };
 
+// Flag indicating whether the gaps in each span row are tracked, allowing
+// add_span() to find where a span goes with a binary search rather than by
+// walking the row's opaque span list.
+
+bool span_gaps_enabled;
+
+// Number of span rows that are fully covered by opaque spans.  Once this
+// reaches the window height, nothing else rendered in front to back order can
+// be seen.
+
+int full_span_rows;
+
+// Flag indicating whether visibility is resolved with a z-buffer rather than
+// the span buffer.  With a z-buffer, spans may be added in any order.
+
+bool z_buffer_enabled;
+
 // Cache stats.
 
 int cache_entries_added_in_frame;
 int cache_entries_reused_in_frame;
 int cache_entries_free_in_frame;
 
+// Overdraw buffer, which counts the number of spans considered for each
+// pixel, and the number of times the span list in each row was split.  These
+// are only maintained while the overdraw display is on.
+
+#define OVERDRAW_LEVELS		8
+
+static byte *overdraw_list;
+static int *row_split_list;
+static int overdraw_width, overdraw_height;
+static pixel overdraw_pixel_list[OVERDRAW_LEVELS];
+static pixel split_pixel;
+
+// Z-buffer, which holds the depth (1/tz) of the nearest opaque span at each
+// pixel, and a pointer to that span.  Popups are in front of everything, and
+// the orb and sky are behind everything, so they are given fixed depths.
+
+#define CLEAR_DEPTH			-1.0f
+#define SKY_DEPTH			-0.5f
+#define BACKGROUND_DEPTH	0.0f
+#define POPUP_DEPTH			1.0e30f
+
+static float *z_buffer_list;
+static span **z_span_list;
+static int z_buffer_width, z_buffer_height;
+
+//------------------------------------------------------------------------------
+// Delete the overdraw buffer.
+//------------------------------------------------------------------------------
+
+void
+delete_overdraw_buffer(void)
+{
+	if (overdraw_list) {
+		DELARRAY(overdraw_list, byte, overdraw_width * overdraw_height);
+		overdraw_list = NULL;
+	}
+	if (row_split_list) {
+		DELARRAY(row_split_list, int, overdraw_height);
+		row_split_list = NULL;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Clear the overdraw buffer at the start of a frame, creating it first if it
+// doesn't exist or the window size has changed.  Returns FALSE if the buffer
+// could not be created.
+//------------------------------------------------------------------------------
+
+bool
+start_overdraw_frame(void)
+{
+	RGBcolour colour;
+	int level;
+
+	// Create the overdraw buffer and the colours used to display it, if
+	// necessary.
+
+	if (overdraw_list == NULL || overdraw_width != window_width ||
+		overdraw_height != window_height) {
+		delete_overdraw_buffer();
+		overdraw_width = window_width;
+		overdraw_height = window_height;
+		NEWARRAY(overdraw_list, byte, overdraw_width * overdraw_height);
+		NEWARRAY(row_split_list, int, overdraw_height);
+		if (overdraw_list == NULL || row_split_list == NULL) {
+			delete_overdraw_buffer();
+			return(false);
+		}
+
+		// Pixels considered once are dark blue, and the colour moves through
+		// green and yellow to red as the count rises.  Pixels that were never
+		// considered are black.
+
+		colour.set_RGB(0.0f, 0.0f, 0.0f);
+		overdraw_pixel_list[0] = RGB_to_display_pixel(colour);
+		for (level = 1; level < OVERDRAW_LEVELS; level++) {
+			float fraction = (float)(level - 1) / (float)(OVERDRAW_LEVELS - 2);
+			if (fraction < 0.5f)
+				colour.set_RGB(0.0f, fraction * 510.0f,
+					(0.5f - fraction) * 320.0f + 64.0f);
+			else
+				colour.set_RGB((fraction - 0.5f) * 510.0f,
+					(1.0f - fraction) * 510.0f, 0.0f);
+			overdraw_pixel_list[level] = RGB_to_display_pixel(colour);
+		}
+		colour.set_RGB(255.0f, 255.0f, 255.0f);
+		split_pixel = RGB_to_display_pixel(colour);
+	}
+
+	// Clear the overdraw buffer.
+
+	memset(overdraw_list, 0, overdraw_width * overdraw_height);
+	memset(row_split_list, 0, overdraw_height * sizeof(int));
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Count a span that was considered for the given row and range of pixels.
+//------------------------------------------------------------------------------
+
+static void
+count_overdraw(int sy, int start_sx, int end_sx)
+{
+	byte *count_ptr, *end_count_ptr;
+
+	count_ptr = overdraw_list + sy * overdraw_width + start_sx;
+	end_count_ptr = count_ptr + (end_sx - start_sx);
+	while (count_ptr < end_count_ptr) {
+		if (*count_ptr < OVERDRAW_LEVELS - 1)
+			(*count_ptr)++;
+		count_ptr++;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Render the overdraw buffer over the frame buffer, using solid colour spans.
+// A bar on the left of each row shows how many times it's span list was
+// split, at two pixels per split.
+//------------------------------------------------------------------------------
+
+void
+render_overdraw(void)
+{
+	span colour_span;
+	byte *count_ptr;
+	int row, sx, run_sx, bar_width;
+
+	if (overdraw_list == NULL)
+		return;
+	for (row = 0; row < overdraw_height; row++) {
+		colour_span.sy = row;
+
+		// Render each run of pixels with the same count as a single span.
+
+		count_ptr = overdraw_list + row * overdraw_width;
+		run_sx = 0;
+		for (sx = 1; sx <= overdraw_width; sx++) {
+			if (sx == overdraw_width || count_ptr[sx] != count_ptr[run_sx]) {
+				colour_span.start_sx = run_sx;
+				colour_span.end_sx = sx;
+				colour_span.colour_pixel = overdraw_pixel_list[count_ptr[run_sx]];
+				if (display_depth <= 16)
+					render_colour_span16(&colour_span);
+				else if (display_depth == 24)
+					render_colour_span24(&colour_span);
+				else
+					render_colour_span32(&colour_span);
+				run_sx = sx;
+			}
+		}
+
+		// Render the split histogram bar for this row.
+
+		bar_width = row_split_list[row] * 2;
+		if (bar_width > overdraw_width / 4)
+			bar_width = overdraw_width / 4;
+		if (bar_width > 0) {
+			colour_span.start_sx = 0;
+			colour_span.end_sx = bar_width;
+			colour_span.colour_pixel = split_pixel;
+			if (display_depth <= 16)
+				render_colour_span16(&colour_span);
+			else if (display_depth == 24)
+				render_colour_span24(&colour_span);
+			else
+				render_colour_span32(&colour_span);
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Delete the z-buffer.
+//------------------------------------------------------------------------------
+
+void
+delete_z_buffer(void)
+{
+	if (z_buffer_list) {
+		DELARRAY(z_buffer_list, float, z_buffer_width * z_buffer_height);
+		z_buffer_list = NULL;
+	}
+	if (z_span_list) {
+		DELARRAY(z_span_list, span *, z_buffer_width * z_buffer_height);
+		z_span_list = NULL;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Clear the z-buffer at the start of a frame, creating it first if it doesn't
+// exist or the window size has changed.  Returns FALSE if the z-buffer could
+// not be created.
+//------------------------------------------------------------------------------
+
+bool
+start_z_buffer_frame(void)
+{
+	float *depth_ptr, *end_depth_ptr;
+
+	// Create the z-buffer if necessary.
+
+	if (z_buffer_list == NULL || z_buffer_width != window_width ||
+		z_buffer_height != window_height) {
+		delete_z_buffer();
+		z_buffer_width = window_width;
+		z_buffer_height = window_height;
+		NEWARRAY(z_buffer_list, float, z_buffer_width * z_buffer_height);
+		NEWARRAY(z_span_list, span *, z_buffer_width * z_buffer_height);
+		if (z_buffer_list == NULL || z_span_list == NULL) {
+			delete_z_buffer();
+			return(false);
+		}
+	}
+
+	// Clear the z-buffer.
+
+	depth_ptr = z_buffer_list;
+	end_depth_ptr = depth_ptr + z_buffer_width * z_buffer_height;
+	while (depth_ptr < end_depth_ptr)
+		*depth_ptr++ = CLEAR_DEPTH;
+	memset(z_span_list, 0, z_buffer_width * z_buffer_height * sizeof(span *));
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Return the depth of a span at it's start, and the change in depth per pixel.
+//------------------------------------------------------------------------------
+
+static float
+get_span_depth(span *span_ptr, float *delta_depth_ptr)
+{
+	*delta_depth_ptr = 0.0f;
+	if (span_ptr->is_popup)
+		return(POPUP_DEPTH);
+	if (span_ptr->start_span.one_on_tz == 0.0f)
+		return(SKY_DEPTH);
+	if (span_ptr->is_background)
+		return(BACKGROUND_DEPTH);
+	*delta_depth_ptr = span_ptr->delta_span.one_on_tz;
+	return(span_ptr->start_span.one_on_tz);
+}
+
+//------------------------------------------------------------------------------
+// Add a polygon span to the z-buffer.  Each pixel of an opaque span that is
+// nearer than the current contents of the z-buffer becomes owned by that span.
+// A transparent span that has any visible pixels is inserted into the row's
+// transparent span list, which is kept sorted from back to front by the depth
+// at the middle of each span.  The return value indicates whether the span
+// had any visible pixels.
+//------------------------------------------------------------------------------
+
+static bool
+add_span_to_z_buffer(span_row *span_row_ptr, span *new_span_ptr,
+					 pixmap *pixmap_ptr)
+{
+	float *depth_ptr;
+	span **owner_ptr;
+	float depth, delta_depth, mid_depth;
+	span *stored_span_ptr, *prev_span_ptr, *curr_span_ptr;
+	int sx, index;
+
+	// Get pointers to the z-buffer entries for the first pixel of the span,
+	// and get the span's starting depth.
+
+	index = new_span_ptr->sy * z_buffer_width + new_span_ptr->start_sx;
+	depth_ptr = &z_buffer_list[index];
+	owner_ptr = &z_span_list[index];
+	depth = get_span_depth(new_span_ptr, &delta_depth);
+
+	// If the span is opaque, using the same test as insert_span(), store it
+	// in every pixel it is nearest at.  The span is only copied once the first
+	// such pixel is found.
+
+	if (pixmap_ptr == NULL || pixmap_ptr->transparent_index == -1 ||
+		new_span_ptr->start_span.one_on_tz == 0.0f) {
+		stored_span_ptr = NULL;
+		for (sx = new_span_ptr->start_sx; sx < new_span_ptr->end_sx; sx++) {
+			if (depth > *depth_ptr) {
+				if (stored_span_ptr == NULL)
+					stored_span_ptr = dup_span(new_span_ptr);
+				*depth_ptr = depth;
+				*owner_ptr = stored_span_ptr;
+			}
+			depth += delta_depth;
+			depth_ptr++;
+			owner_ptr++;
+		}
+		return(stored_span_ptr != NULL);
+	}
+
+	// If the span is transparent, look for a pixel that is visible.  If there
+	// is none, the span can be discarded.
+
+	for (sx = new_span_ptr->start_sx; sx < new_span_ptr->end_sx; sx++) {
+		if (depth > *depth_ptr)
+			break;
+		depth += delta_depth;
+		depth_ptr++;
+	}
+	if (sx == new_span_ptr->end_sx)
+		return(false);
+
+	// Insert the span in front of every transparent span whose middle is
+	// nearer.  When spans are added in front to back order, this is always
+	// the head of the list.
+
+	mid_depth = get_span_depth(new_span_ptr, &delta_depth) + delta_depth *
+		((new_span_ptr->end_sx - new_span_ptr->start_sx) >> 1);
+	prev_span_ptr = NULL;
+	curr_span_ptr = span_row_ptr->transparent_span_list;
+	while (curr_span_ptr) {
+		depth = get_span_depth(curr_span_ptr, &delta_depth) + delta_depth *
+			((curr_span_ptr->end_sx - curr_span_ptr->start_sx) >> 1);
+		if (depth > mid_depth)
+			break;
+		prev_span_ptr = curr_span_ptr;
+		curr_span_ptr = curr_span_ptr->next_span_ptr;
+	}
+	stored_span_ptr = dup_span(new_span_ptr);
+	stored_span_ptr->next_span_ptr = curr_span_ptr;
+	if (prev_span_ptr)
+		prev_span_ptr->next_span_ptr = stored_span_ptr;
+	else
+		span_row_ptr->transparent_span_list = stored_span_ptr;
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Convert the contents of the z-buffer into span buffer rows.  Each run of
+// pixels owned by the same opaque span becomes a fragment in the row's opaque
+// span list, and each transparent span is cut down to the runs of pixels that
+// are in front of the z-buffer.
+//------------------------------------------------------------------------------
+
+void
+resolve_z_buffer(void)
+{
+	int row, sx, run_sx, end_sx;
+	float *depth_list;
+	span **owner_list;
+	span_row *span_row_ptr;
+	span *span_ptr, *next_span_ptr, *fragment_ptr, *last_span_ptr;
+	float depth, delta_depth;
+
+	for (row = 0; row < z_buffer_height; row++) {
+		span_row_ptr = (*span_buffer_ptr)[row];
+		depth_list = &z_buffer_list[row * z_buffer_width];
+		owner_list = &z_span_list[row * z_buffer_width];
+
+		// Turn each run of pixels owned by the same opaque span into a
+		// fragment of that span, appending it to the opaque span list.
+
+		span_row_ptr->opaque_span_list = NULL;
+		last_span_ptr = NULL;
+		run_sx = 0;
+		for (sx = 1; sx <= z_buffer_width; sx++) {
+			if (sx < z_buffer_width && owner_list[sx] == owner_list[run_sx])
+				continue;
+			if (owner_list[run_sx]) {
+				fragment_ptr = dup_span(owner_list[run_sx]);
+				if (run_sx > fragment_ptr->start_sx)
+					fragment_ptr->adjust_start(run_sx);
+				fragment_ptr->end_sx = sx;
+				fragment_ptr->next_span_ptr = NULL;
+				if (last_span_ptr)
+					last_span_ptr->next_span_ptr = fragment_ptr;
+				else
+					span_row_ptr->opaque_span_list = fragment_ptr;
+				last_span_ptr = fragment_ptr;
+			}
+			run_sx = sx;
+		}
+
+		// Replace each transparent span by fragments covering the runs of
+		// pixels where it is in front of the z-buffer, keeping the list in
+		// back to front order.
+
+		span_ptr = span_row_ptr->transparent_span_list;
+		span_row_ptr->transparent_span_list = NULL;
+		last_span_ptr = NULL;
+		while (span_ptr) {
+			next_span_ptr = span_ptr->next_span_ptr;
+			depth = get_span_depth(span_ptr, &delta_depth);
+			end_sx = span_ptr->end_sx;
+			sx = span_ptr->start_sx;
+			while (sx < end_sx) {
+
+				// Skip over the hidden pixels.
+
+				while (sx < end_sx && depth <= depth_list[sx]) {
+					depth += delta_depth;
+					sx++;
+				}
+				if (sx == end_sx)
+					break;
+
+				// Find the end of the visible pixels, and add a fragment
+				// covering them.
+
+				run_sx = sx;
+				while (sx < end_sx && depth > depth_list[sx]) {
+					depth += delta_depth;
+					sx++;
+				}
+				fragment_ptr = dup_span(span_ptr);
+				if (run_sx > fragment_ptr->start_sx)
+					fragment_ptr->adjust_start(run_sx);
+				fragment_ptr->end_sx = sx;
+				fragment_ptr->next_span_ptr = NULL;
+				if (last_span_ptr)
+					last_span_ptr->next_span_ptr = fragment_ptr;
+				else
+					span_row_ptr->transparent_span_list = fragment_ptr;
+				last_span_ptr = fragment_ptr;
+			}
+			span_ptr = next_span_ptr;
+		}
+	}
+}
+
 //------------------------------------------------------------------------------
 // Create the image caches.
 //------------------------------------------------------------------------------
@@ -281,6 +717,18 @@ insert_span(span_row *span_row_ptr, span *prev_span_ptr, span *new_span_ptr,
 			new_span_ptr->next_span_ptr	= span_row_ptr->opaque_span_list;
 			span_row_ptr->opaque_span_list = new_span_ptr;
 		}
+
+		// Opaque spans added in front to back order never overlap, so the
+		// row is full once they have covered every pixel in it.
+
+		if (!span_row_ptr->full) {
+			span_row_ptr->uncovered_pixels -= new_span_ptr->end_sx -
+				new_span_ptr->start_sx;
+			if (span_row_ptr->uncovered_pixels == 0) {
+				span_row_ptr->full = true;
+				full_span_rows++;
+			}
+		}
 	}
 	
 	// If the texture has a transparent colour index, add the new span to the
@@ -293,6 +741,124 @@ insert_span(span_row *span_row_ptr, span *prev_span_ptr, span *new_span_ptr,
 	}
 }
 
+//------------------------------------------------------------------------------
+// Add a polygon span to a span buffer row that has a gap list, by inserting a
+// fragment of the span into each gap it overlaps.  Opaque fragments shrink,
+// split or fill the gaps they are inserted into.  The return value indicates
+// whether any fragment was inserted.
+//------------------------------------------------------------------------------
+
+static bool
+add_span_to_gaps(span_row *span_row_ptr, span *new_span_ptr,
+				 pixmap *pixmap_ptr)
+{
+	span_gap *gap_list, *gap_ptr;
+	int low_gap_no, high_gap_no, gap_no;
+	int start_sx, end_sx;
+	span *fragment_ptr;
+	bool opaque, span_inserted;
+
+	// If the row is full, reject the span immediately.
+
+	if (span_row_ptr->gaps == 0)
+		return(false);
+
+	// Find the first gap that ends after the new span starts, using a
+	// binary search.
+
+	gap_list = span_row_ptr->gap_list;
+	low_gap_no = 0;
+	high_gap_no = span_row_ptr->gaps;
+	while (low_gap_no < high_gap_no) {
+		gap_no = (low_gap_no + high_gap_no) >> 1;
+		if (gap_list[gap_no].end_sx <= new_span_ptr->start_sx)
+			low_gap_no = gap_no + 1;
+		else
+			high_gap_no = gap_no;
+	}
+
+	// Determine whether the new span will cover what is behind it, using the
+	// same test as insert_span().
+
+	opaque = pixmap_ptr == NULL || pixmap_ptr->transparent_index == -1 ||
+		new_span_ptr->start_span.one_on_tz == 0.0f;
+
+	// Step through the gaps that start before the new span ends...
+
+	span_inserted = false;
+	gap_no = low_gap_no;
+	while (gap_no < span_row_ptr->gaps &&
+		gap_list[gap_no].start_sx < new_span_ptr->end_sx) {
+		gap_ptr = &gap_list[gap_no];
+
+		// Insert the part of the new span that lies within this gap after the
+		// opaque span to the left of the gap.
+
+		start_sx = new_span_ptr->start_sx;
+		if (gap_ptr->start_sx > start_sx)
+			start_sx = gap_ptr->start_sx;
+		end_sx = new_span_ptr->end_sx;
+		if (gap_ptr->end_sx < end_sx)
+			end_sx = gap_ptr->end_sx;
+		fragment_ptr = dup_span(new_span_ptr);
+		if (start_sx > fragment_ptr->start_sx)
+			fragment_ptr->adjust_start(start_sx);
+		fragment_ptr->end_sx = end_sx;
+		insert_span(span_row_ptr, gap_ptr->prev_span_ptr, fragment_ptr,
+			pixmap_ptr);
+		if (overdraw_list && span_inserted)
+			row_split_list[new_span_ptr->sy]++;
+		span_inserted = true;
+
+		// A transparent fragment leaves the gap as it is.
+
+		if (!opaque) {
+			gap_no++;
+			continue;
+		}
+
+		// If the fragment fills the gap, remove the gap.
+
+		if (start_sx == gap_ptr->start_sx && end_sx == gap_ptr->end_sx) {
+			span_row_ptr->gaps--;
+			memmove(gap_ptr, gap_ptr + 1,
+				(span_row_ptr->gaps - gap_no) * sizeof(span_gap));
+			continue;
+		}
+
+		// If the fragment covers the start of the gap, the gap now starts
+		// after the fragment.
+
+		if (start_sx == gap_ptr->start_sx) {
+			gap_ptr->start_sx = end_sx;
+			gap_ptr->prev_span_ptr = fragment_ptr;
+			gap_no++;
+			continue;
+		}
+
+		// If the fragment covers the end of the gap, the gap now ends before
+		// the fragment.
+
+		if (end_sx == gap_ptr->end_sx) {
+			gap_ptr->end_sx = start_sx;
+			gap_no++;
+			continue;
+		}
+
+		// Otherwise the fragment splits the gap in two.
+
+		memmove(gap_ptr + 2, gap_ptr + 1,
+			(span_row_ptr->gaps - gap_no - 1) * sizeof(span_gap));
+		span_row_ptr->gaps++;
+		gap_ptr[1].start_sx = end_sx;
+		gap_ptr[1].end_sx = gap_ptr->end_sx;
+		gap_ptr[1].prev_span_ptr = fragment_ptr;
+		gap_ptr->end_sx = start_sx;
+		gap_no += 2;
+	}
+	return(span_inserted);
+}
+
 //------------------------------------------------------------------------------
 // Add a polygon span to the span buffer.  It is assumed that the span will be
 // behind all other spans currently in the buffer.  The return value indicates
@@ -301,7 +867,8 @@ insert_span(span_row *span_row_ptr, span *prev_span_ptr, span *new_span_ptr,
 
 bool
 add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
-		 pixel colour_pixel, int brightness_index, bool is_popup)
+		 pixel colour_pixel, int brightness_index, bool is_popup,
+		 bool is_background)
 {
 	float left_sx, right_sx;
 	float delta_sx, one_on_delta_sx;
@@ -310,6 +877,12 @@ add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
 	span *prev_span_ptr, *curr_span_ptr, *new_span_ptr;
 	bool span_inserted;
 
+	// If the row is already full, the span cannot be seen.
+
+	span_row_ptr = (*span_buffer_ptr)[sy];
+	if (span_row_ptr->full)
+		return(false);
+
 	// If the right screen x coordinate is less than or equal to the left
 	// screen x coordinate, switch the edges.
 
@@ -334,6 +907,12 @@ add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
 	if (right_sx > (float)window_width)
 		right_sx = (float)window_width;
 
+	// If the span lies entirely off the display, which can happen to a
+	// polygon that was not clipped to the display, it can be discarded.
+
+	if (left_sx >= right_sx)
+		return(false);
+
 	// Compute the delta values for the new span.  Note that these deltas are
 	// computed from the original left and right screen x coordinates, not the
 	// adjusted ones.
@@ -369,13 +948,28 @@ add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
 	new_span.start_sx = (int)left_sx;
 	new_span.end_sx = (int)right_sx;
 	new_span.is_popup = is_popup;
+	new_span.is_background = is_background;
 	new_span.pixmap_ptr = pixmap_ptr;
 	new_span.colour_pixel = colour_pixel;
 	new_span.brightness_index = brightness_index;
 
+	// If the overdraw display is on, count the pixels this span covers.
+
+	if (overdraw_list)
+		count_overdraw(sy, new_span.start_sx, new_span.end_sx);
+
+	// If the z-buffer is enabled, use it to insert the new span.
+
+	if (z_buffer_enabled)
+		return(add_span_to_z_buffer(span_row_ptr, &new_span, pixmap_ptr));
+
+	// If the row has a gap list, use it to insert the new span.
+
+	if (span_row_ptr->gap_list)
+		return(add_span_to_gaps(span_row_ptr, &new_span, pixmap_ptr));
+
 	// If the opaque span list is empty, just insert the new span and return.
 
-	span_row_ptr = (*span_buffer_ptr)[sy];
 	if (span_row_ptr->opaque_span_list == NULL) {
 		span *new_span_ptr = dup_span(&new_span);
 		insert_span(span_row_ptr, NULL, new_span_ptr, pixmap_ptr);
@@ -416,6 +1010,12 @@ add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
 			new_span_ptr->end_sx = curr_span_ptr->start_sx;
 			insert_span(span_row_ptr, prev_span_ptr, new_span_ptr, pixmap_ptr);
 			span_inserted = true;
+
+			// If the new span continues past the current span, it is being
+			// split into fragments.
+
+			if (overdraw_list && new_span.end_sx > curr_span_ptr->end_sx)
+				row_split_list[sy]++;
 		}
 
 		// If the new span ends before the current span ends, there is nothing
@@ -507,6 +1107,8 @@ insert_movable_span(span_row *span_row_ptr, span *prev_span_ptr,
 					new_span_ptr->end_sx < span_ptr->end_sx) {
 					add_span_ptr = dup_span(span_ptr);
 					add_span_ptr->adjust_start(new_span_ptr->end_sx);
+					if (overdraw_list)
+						row_split_list[new_span_ptr->sy]++;
 					add_span_ptr->next_span_ptr = span_ptr->next_span_ptr;
 					span_ptr->end_sx = new_span_ptr->start_sx;
 					span_ptr->next_span_ptr = add_span_ptr;
@@ -603,6 +1205,14 @@ add_movable_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr,
 	span *first_span_ptr, *last_span_ptr;
 	span new_span;
 
+	// If the z-buffer is enabled, movable spans need no special treatment.
+
+	if (z_buffer_enabled) {
+		add_span(sy, left_edge_ptr, right_edge_ptr, pixmap_ptr, colour_pixel,
+			brightness_index, false, false);
+		return;
+	}
+
 	// If the right screen x coordinate is less than or equal to the left
 	// screen x coordinate, switch the edges.
 
@@ -627,6 +1237,12 @@ add_movable_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr,
 	if (right_sx > (float)window_width)
 		right_sx = (float)window_width;
 
+	// If the span lies entirely off the display, which can happen to a
+	// polygon that was not clipped to the display, it can be discarded.
+
+	if (left_sx >= right_sx)
+		return;
+
 	// Compute the delta values for the new span.  Note that these deltas are
 	// computed from the original left and right screen x coordinates, not the
 	// adjusted ones.
@@ -666,6 +1282,11 @@ add_movable_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr,
 	new_span.colour_pixel = colour_pixel;
 	new_span.brightness_index = brightness_index;
 
+	// If the overdraw display is on, count the pixels this span covers.
+
+	if (overdraw_list)
+		count_overdraw(sy, new_span.start_sx, new_span.end_sx);
+
 	// Find the first span that overlaps the new span (i.e. does not end
 	// before the new span begins).  We also remember the previous span.
 
@@ -711,6 +1332,8 @@ add_movable_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr,
 					last_span_ptr = dup_span(first_span_ptr);
 					last_span_ptr->adjust_start(new_span_ptr->end_sx);
 					insert_span(span_row_ptr, new_span_ptr, last_span_ptr, NULL);
+					if (overdraw_list)
+						row_split_list[sy]++;
 				}
 
 				// Shorten the first span so that it no longer overlaps the new
@@ -23,6 +23,18 @@
 
 extern int image_dimensions_list[IMAGE_SIZES];
 
+// Flag indicating whether span rows track their gaps.
+
+extern bool span_gaps_enabled;
+
+// Number of span rows that are fully covered by opaque spans.
+
+extern int full_span_rows;
+
+// Flag indicating whether visibility is resolved with a z-buffer.
+
+extern bool z_buffer_enabled;
+
 // Cache stats.
 
 extern int cache_entries_added_in_frame;
@@ -31,6 +43,24 @@ extern int cache_entries_free_in_frame;
 
 // Externally visible functions.
 
+void
+delete_overdraw_buffer(void);
+
+bool
+start_overdraw_frame(void);
+
+void
+render_overdraw(void);
+
+void
+delete_z_buffer(void);
+
+bool
+start_z_buffer_frame(void);
+
+void
+resolve_z_buffer(void);
+
 cache_entry *
 get_cache_entry(pixmap *pixmap_ptr, int brightness_index);
 
@@ -51,7 +81,8 @@ set_size_indices(texture *texture_ptr);
 
 bool
 add_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, pixmap *pixmap_ptr,
-		 pixel colour_pixel, int brightness_index, bool is_popup);
+		 pixel colour_pixel, int brightness_index, bool is_popup,
+		 bool is_background = false);
 
 void
 add_movable_span(int sy, edge *left_edge_ptr, edge *right_edge_ptr, 
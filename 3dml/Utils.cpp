@@ -56,6 +56,13 @@ static bool URL_opened;
 
 static string pending_URL;
 
+// Flag indicating whether block replacements are being batched, and the list
+// of squares whose active polygons must be recomputed when the batch ends.
+
+static bool batching_block_updates;
+static mapcoords *dirty_square_list;
+static int dirty_squares, max_dirty_squares;
+
 //------------------------------------------------------------------------------
 // Update logo animation every 1/10th of a second, but only if the main
 // window is ready.
@@ -666,6 +673,7 @@ add_entrance(const char *name, int column, int row, int level,
 {
 	bool entrance_is_new;
 	entrance *entrance_ptr;
+	square *square_ptr;
 
 	// Search for an existing entrance of the same name; if not found, create a
 	// new entrance.
@@ -688,6 +696,11 @@ add_entrance(const char *name, int column, int row, int level,
 		return;
 	}
 
+	// Increment the number of entrance locations on the square.
+
+	if ((square_ptr = world_ptr->get_square_ptr(column, row, level)) != NULL)
+		square_ptr->get_info_ptr()->entrances++;
+
 	// If a new entrance was created, add it to the entrance list.
 
 	if (entrance_is_new) {
@@ -1026,18 +1039,26 @@ create_new_block(block_def *block_def_ptr, vertex translation)
 	block_ptr->translation = translation * world_ptr->block_scale;
 	block_ptr->polygon_list = block_def_ptr->polygon_list;
 
-	// The vertex list is new.  If the block is a structural block, copy the
-	// vertices from the block definition and translate and scale them.  If the
-	// block is a sprite, initialise the vertices using the texture dimensions,
-	// then scale them.
+	// If the block is a structural block, it uses the vertices of the block
+	// definition, which are scaled and translated as the block is rendered.
+	// If the block is solid, it shares the block definition's collision mesh,
+	// which is created or rebuilt if the block scale has changed since it was
+	// last built.  If the block is a sprite, initialise it's own vertices using
+	// the texture dimensions, then scale them.
 
 	if (block_def_ptr->type == STRUCTURAL_BLOCK) {
-		for (int vertex_no = 0; vertex_no < block_ptr->vertices; vertex_no++)
-			block_ptr->vertex_list[vertex_no] = 
-				(block_def_ptr->vertex_list[vertex_no] + translation) *
-				world_ptr->block_scale;
-		if (block_ptr->solid)
-			COL_convertBlockToColMesh(block_ptr->col_mesh_ptr, block_def_ptr);
+		if (block_ptr->solid) {
+			if (block_def_ptr->col_mesh_ptr == NULL &&
+				!COL_createBlockColMesh(block_def_ptr))
+				memory_error("collision mesh");
+			if (block_def_ptr->col_mesh_scale != world_ptr->block_scale) {
+				COL_convertBlockToColMesh(block_def_ptr->col_mesh_ptr, 
+					block_def_ptr);
+				block_def_ptr->col_mesh_scale = world_ptr->block_scale;
+			}
+			block_ptr->col_mesh_ptr = block_def_ptr->col_mesh_ptr;
+		} else
+			block_ptr->col_mesh_ptr = NULL;
 	} else {
 		polygon *polygon_ptr = block_def_ptr->polygon_list;
 		part *part_ptr = polygon_ptr->part_ptr;
@@ -1069,6 +1090,385 @@ set_trigger_delay(trigger *trigger_ptr, int curr_time_ms)
 }
 
 
+//------------------------------------------------------------------------------
+// Return TRUE if the first "timer" trigger expires before the second.  The
+// expiry times are compared by their difference so that the comparison
+// survives the millisecond clock wrapping around; the arithmetic is done
+// unsigned so that it wraps rather than overflows.
+//------------------------------------------------------------------------------
+
+static bool
+expires_before(trigger *trigger1_ptr, trigger *trigger2_ptr)
+{
+	unsigned int expiry1_ms, expiry2_ms;
+
+	expiry1_ms = (unsigned int)trigger1_ptr->start_time_ms +
+		(unsigned int)trigger1_ptr->delay_ms;
+	expiry2_ms = (unsigned int)trigger2_ptr->start_time_ms +
+		(unsigned int)trigger2_ptr->delay_ms;
+	return((int)(expiry1_ms - expiry2_ms) < 0);
+}
+
+//------------------------------------------------------------------------------
+// Store a trigger at the given position in the timer heap, and remember that
+// position in the trigger.
+//------------------------------------------------------------------------------
+
+static void
+set_timer_heap_entry(int index, trigger *trigger_ptr)
+{
+	timer_heap[index] = trigger_ptr;
+	trigger_ptr->timer_heap_index = index;
+}
+
+//------------------------------------------------------------------------------
+// Move the trigger at the given position in the timer heap up or down until
+// the heap is ordered again.
+//------------------------------------------------------------------------------
+
+static void
+sift_timer_heap(int index)
+{
+	trigger *trigger_ptr;
+	int parent, child;
+
+	trigger_ptr = timer_heap[index];
+
+	// Move the trigger towards the root while it expires before its parent.
+
+	while (index > 0) {
+		parent = (index - 1) / 2;
+		if (!expires_before(trigger_ptr, timer_heap[parent]))
+			break;
+		set_timer_heap_entry(index, timer_heap[parent]);
+		index = parent;
+	}
+
+	// Move the trigger towards the leaves while a child expires before it.
+
+	while ((child = index * 2 + 1) < timer_heap_size) {
+		if (child + 1 < timer_heap_size &&
+			expires_before(timer_heap[child + 1], timer_heap[child]))
+			child++;
+		if (!expires_before(timer_heap[child], trigger_ptr))
+			break;
+		set_timer_heap_entry(index, timer_heap[child]);
+		index = child;
+	}
+	set_timer_heap_entry(index, trigger_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Schedule a trigger to expire when its delay has elapsed, by adding it to the
+// timer heap.  The trigger's start time and delay must already be set.
+//------------------------------------------------------------------------------
+
+bool
+schedule_timer_trigger(trigger *trigger_ptr)
+{
+	trigger **new_timer_heap;
+	int index;
+
+	// If the timer heap is full, double its size.
+
+	if (timer_heap_size == max_timer_heap_size) {
+		NEWARRAY(new_timer_heap, trigger *, max_timer_heap_size * 2 + 16);
+		if (new_timer_heap == NULL) {
+			memory_warning("timer heap");
+			return(false);
+		}
+		for (index = 0; index < timer_heap_size; index++)
+			new_timer_heap[index] = timer_heap[index];
+		if (timer_heap)
+			DELARRAY(timer_heap, trigger *, max_timer_heap_size);
+		timer_heap = new_timer_heap;
+		max_timer_heap_size = max_timer_heap_size * 2 + 16;
+	}
+
+	// Add the trigger to the end of the heap and move it into place.
+
+	timer_heap[timer_heap_size] = trigger_ptr;
+	sift_timer_heap(timer_heap_size++);
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Remove a trigger from the timer heap, if it's there.
+//------------------------------------------------------------------------------
+
+static void
+unschedule_timer_trigger(trigger *trigger_ptr)
+{
+	int index;
+
+	if ((index = trigger_ptr->timer_heap_index) < 0)
+		return;
+	trigger_ptr->timer_heap_index = -1;
+	timer_heap[index] = timer_heap[--timer_heap_size];
+	if (index < timer_heap_size)
+		sift_timer_heap(index);
+}
+
+//------------------------------------------------------------------------------
+// If the trigger at the top of the timer heap has expired, remove it from the
+// heap and return a pointer to it.  Otherwise return NULL.
+//------------------------------------------------------------------------------
+
+trigger *
+get_expired_timer_trigger(int curr_time_ms)
+{
+	trigger *trigger_ptr;
+
+	if (timer_heap_size == 0)
+		return(NULL);
+	trigger_ptr = timer_heap[0];
+	if (curr_time_ms - trigger_ptr->start_time_ms < trigger_ptr->delay_ms)
+		return(NULL);
+	trigger_ptr->timer_heap_index = -1;
+	timer_heap[0] = timer_heap[--timer_heap_size];
+	if (timer_heap_size > 0)
+		sift_timer_heap(0);
+	return(trigger_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Return the trigger index bucket for the given map square, after clamping it
+// to the map.
+//------------------------------------------------------------------------------
+
+int
+get_trigger_bucket(int column, int row, int level)
+{
+	column = MAX(column, 0);
+	column = MIN(column, world_ptr->columns - 1);
+	row = MAX(row, 0);
+	row = MIN(row, world_ptr->rows - 1);
+	level = MAX(level, 0);
+	level = MIN(level, world_ptr->levels - 1);
+	return(((level * world_ptr->rows + row) * world_ptr->columns + column) &
+		(TRIGGER_BUCKETS - 1));
+}
+
+//------------------------------------------------------------------------------
+// Determine the range of map squares overlapped by the radius of a trigger,
+// clamped to the map.  Returns FALSE if the range covers more squares than
+// there are buckets in the trigger index.
+//------------------------------------------------------------------------------
+
+static bool
+get_trigger_square_range(trigger *trigger_ptr, int *min_column_ptr,
+						 int *min_row_ptr, int *min_level_ptr,
+						 int *max_column_ptr, int *max_row_ptr,
+						 int *max_level_ptr)
+{
+	float radius;
+	vertex min_pos, max_pos;
+
+	// Compute the bounding box of the trigger radius, widened by one unit to
+	// guard against rounding errors.
+
+	radius = (float)sqrt(trigger_ptr->radius_squared) + 1.0f;
+	min_pos.x = trigger_ptr->position.x - radius;
+	min_pos.y = trigger_ptr->position.y - radius;
+	min_pos.z = trigger_ptr->position.z + radius;
+	max_pos.x = trigger_ptr->position.x + radius;
+	max_pos.y = trigger_ptr->position.y + radius;
+	max_pos.z = trigger_ptr->position.z - radius;
+
+	// Convert the bounding box into map squares, and clamp them to the map.
+	// Note that rows decrease as the Z coordinate increases.
+
+	min_pos.get_scaled_map_position(min_column_ptr, min_row_ptr, 
+		min_level_ptr);
+	max_pos.get_scaled_map_position(max_column_ptr, max_row_ptr,
+		max_level_ptr);
+	*min_column_ptr = MAX(*min_column_ptr, 0);
+	*min_row_ptr = MAX(*min_row_ptr, 0);
+	*min_level_ptr = MAX(*min_level_ptr, 0);
+	*max_column_ptr = MIN(*max_column_ptr, world_ptr->columns - 1);
+	*max_row_ptr = MIN(*max_row_ptr, world_ptr->rows - 1);
+	*max_level_ptr = MIN(*max_level_ptr, world_ptr->levels - 1);
+
+	// Return FALSE if the range covers too many squares.
+
+	return((*max_column_ptr - *min_column_ptr + 1) * 
+		(*max_row_ptr - *min_row_ptr + 1) *
+		(*max_level_ptr - *min_level_ptr + 1) <= TRIGGER_BUCKETS);
+}
+
+//------------------------------------------------------------------------------
+// Add a reference to a trigger to the head of a trigger reference list.
+//------------------------------------------------------------------------------
+
+bool
+add_trigger_ref(trigger_ref **trigger_ref_list_ptr, trigger *trigger_ptr)
+{
+	trigger_ref *trigger_ref_ptr;
+
+	if ((trigger_ref_ptr = new_trigger_ref()) == NULL) {
+		memory_warning("trigger reference");
+		return(false);
+	}
+	trigger_ref_ptr->trigger_ptr = trigger_ptr;
+	trigger_ref_ptr->next_trigger_ref_ptr = *trigger_ref_list_ptr;
+	*trigger_ref_list_ptr = trigger_ref_ptr;
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Remove all references to a trigger from a trigger reference list.
+//------------------------------------------------------------------------------
+
+static void
+remove_trigger_refs(trigger_ref **trigger_ref_list_ptr, trigger *trigger_ptr)
+{
+	trigger_ref *trigger_ref_ptr;
+
+	while ((trigger_ref_ptr = *trigger_ref_list_ptr) != NULL) {
+		if (trigger_ref_ptr->trigger_ptr == trigger_ptr)
+			*trigger_ref_list_ptr = del_trigger_ref(trigger_ref_ptr);
+		else
+			trigger_ref_list_ptr = &trigger_ref_ptr->next_trigger_ref_ptr;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Remove a global trigger from the trigger index.
+//------------------------------------------------------------------------------
+
+static void
+unindex_global_trigger(trigger *trigger_ptr)
+{
+	int min_column, min_row, min_level, max_column, max_row, max_level;
+	int column, row, level;
+
+	switch (trigger_ptr->trigger_flag) {
+	case STEP_IN:
+	case STEP_OUT:
+	case PROXIMITY:
+		remove_trigger_refs(&inside_trigger_list, trigger_ptr);
+		if (!get_trigger_square_range(trigger_ptr, &min_column, &min_row,
+			&min_level, &max_column, &max_row, &max_level)) {
+			remove_trigger_refs(&large_trigger_list, trigger_ptr);
+			break;
+		}
+		for (level = min_level; level <= max_level; level++)
+			for (row = min_row; row <= max_row; row++)
+				for (column = min_column; column <= max_column; column++)
+					remove_trigger_refs(&trigger_bucket_list[
+						get_trigger_bucket(column, row, level)], trigger_ptr);
+		break;
+	case TIMER:
+		unschedule_timer_trigger(trigger_ptr);
+		break;
+	case LOCATION:
+		remove_trigger_refs(&location_trigger_list, trigger_ptr);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Add a global trigger to the trigger index.  If there isn't enough memory to
+// index it fully, any references already added are removed again, so that the
+// trigger is never left partially indexed.
+//------------------------------------------------------------------------------
+
+static void
+index_global_trigger(trigger *trigger_ptr)
+{
+	int min_column, min_row, min_level, max_column, max_row, max_level;
+	int column, row, level, bucket;
+	trigger_ref *bucket_ptr;
+
+	switch (trigger_ptr->trigger_flag) {
+	case STEP_IN:
+	case STEP_OUT:
+	case PROXIMITY:
+
+		// If the player is inside the radius of a "step in" or "step out"
+		// trigger, add it to the inside list so that it will be retested
+		// once the player leaves the squares it overlaps.
+
+		if (trigger_ptr->trigger_flag != PROXIMITY &&
+			trigger_ptr->previously_inside &&
+			!add_trigger_ref(&inside_trigger_list, trigger_ptr))
+			return;
+
+		// If the trigger radius covers too many squares, add the trigger to
+		// the large trigger list.
+
+		if (!get_trigger_square_range(trigger_ptr, &min_column, &min_row,
+			&min_level, &max_column, &max_row, &max_level)) {
+			if (!add_trigger_ref(&large_trigger_list, trigger_ptr))
+				unindex_global_trigger(trigger_ptr);
+			return;
+		}
+
+		// Otherwise add the trigger to the bucket of every square its radius
+		// overlaps.  Squares that hash to the same bucket are likely to be
+		// visited in succession, so don't add the trigger to a bucket if it
+		// was the last one added to it.
+
+		for (level = min_level; level <= max_level; level++)
+			for (row = min_row; row <= max_row; row++)
+				for (column = min_column; column <= max_column; column++) {
+					bucket = get_trigger_bucket(column, row, level);
+					bucket_ptr = trigger_bucket_list[bucket];
+					if ((bucket_ptr == NULL || 
+						 bucket_ptr->trigger_ptr != trigger_ptr) &&
+						!add_trigger_ref(&trigger_bucket_list[bucket],
+						 trigger_ptr)) {
+						unindex_global_trigger(trigger_ptr);
+						return;
+					}
+				}
+		break;
+
+	case TIMER:
+		schedule_timer_trigger(trigger_ptr);
+		break;
+
+	case LOCATION:
+
+		// The location of a trigger's square never changes, so only a
+		// "location" trigger whose target matches it can ever activate.
+
+		world_ptr->get_square_location(trigger_ptr->square_ptr, &column, &row,
+			&level);
+		if (column == trigger_ptr->target.column &&
+			row == trigger_ptr->target.row &&
+			level == trigger_ptr->target.level)
+			add_trigger_ref(&location_trigger_list, trigger_ptr);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Delete the trigger index.
+//------------------------------------------------------------------------------
+
+void
+delete_trigger_index(void)
+{
+	int bucket;
+
+	for (bucket = 0; bucket < TRIGGER_BUCKETS; bucket++)
+		while (trigger_bucket_list[bucket])
+			trigger_bucket_list[bucket] = 
+				del_trigger_ref(trigger_bucket_list[bucket]);
+	while (large_trigger_list)
+		large_trigger_list = del_trigger_ref(large_trigger_list);
+	while (inside_trigger_list)
+		inside_trigger_list = del_trigger_ref(inside_trigger_list);
+	if (timer_heap) {
+		DELARRAY(timer_heap, trigger *, max_timer_heap_size);
+		timer_heap = NULL;
+	}
+	timer_heap_size = 0;
+	max_timer_heap_size = 0;
+	while (location_trigger_list)
+		location_trigger_list = del_trigger_ref(location_trigger_list);
+	curr_trigger_frame = 0;
+}
+
 //------------------------------------------------------------------------------
 // Add a copy of the given trigger to the global trigger list.
 //------------------------------------------------------------------------------
@@ -1090,6 +1490,10 @@ add_trigger_to_global_list(trigger *trigger_ptr, square *square_ptr,
 		new_trigger_ptr->square_ptr = square_ptr;
 		new_trigger_ptr->position.set_scaled_map_position(column, row, level);
 		new_trigger_ptr->next_trigger_ptr = NULL;
+		new_trigger_ptr->prev_trigger_ptr = last_global_trigger_ptr;
+		new_trigger_ptr->next_owned_trigger_ptr = NULL;
+		new_trigger_ptr->ordinal = next_trigger_ordinal++;
+		new_trigger_ptr->timer_heap_index = -1;
 
 		// Add the trigger to the end of the global trigger list.
 
@@ -1103,7 +1507,139 @@ add_trigger_to_global_list(trigger *trigger_ptr, square *square_ptr,
 }
 
 //------------------------------------------------------------------------------
-// Initialise the state of a "step in", "step out" or "timer" trigger.
+// Remove a trigger from the global trigger list, and delete it.
+//------------------------------------------------------------------------------
+
+static void
+remove_trigger_from_global_list(trigger *trigger_ptr)
+{
+	trigger *prev_trigger_ptr, *next_trigger_ptr;
+
+	// Remove the trigger from the trigger index.
+
+	unindex_global_trigger(trigger_ptr);
+
+	// Unlink the trigger from its neighbours in the global trigger list.
+
+	prev_trigger_ptr = trigger_ptr->prev_trigger_ptr;
+	next_trigger_ptr = trigger_ptr->next_trigger_ptr;
+	if (prev_trigger_ptr)
+		prev_trigger_ptr->next_trigger_ptr = next_trigger_ptr;
+	else
+		global_trigger_list = next_trigger_ptr;
+	if (next_trigger_ptr)
+		next_trigger_ptr->prev_trigger_ptr = prev_trigger_ptr;
+	else
+		last_global_trigger_ptr = prev_trigger_ptr;
+
+	// Delete the trigger, but not its action list, which belongs to the
+	// block definition.
+
+	trigger_ptr->action_list = NULL;
+	del_trigger(trigger_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Add a light to the head of the global light list.
+//------------------------------------------------------------------------------
+
+void
+add_light_to_global_list(light *light_ptr)
+{
+	light_ptr->prev_light_ptr = NULL;
+	light_ptr->next_light_ptr = global_light_list;
+	if (global_light_list)
+		global_light_list->prev_light_ptr = light_ptr;
+	global_light_list = light_ptr;
+	global_lights++;
+}
+
+//------------------------------------------------------------------------------
+// Remove a light from the global light list, and delete it.
+//------------------------------------------------------------------------------
+
+static void
+remove_light_from_global_list(light *light_ptr)
+{
+	if (light_ptr->prev_light_ptr)
+		light_ptr->prev_light_ptr->next_light_ptr = light_ptr->next_light_ptr;
+	else
+		global_light_list = light_ptr->next_light_ptr;
+	if (light_ptr->next_light_ptr)
+		light_ptr->next_light_ptr->prev_light_ptr = light_ptr->prev_light_ptr;
+	del_light(light_ptr);
+	global_lights--;
+}
+
+//------------------------------------------------------------------------------
+// Add a sound to the head of the global sound list.
+//------------------------------------------------------------------------------
+
+void
+add_sound_to_global_list(sound *sound_ptr)
+{
+	sound_ptr->prev_sound_ptr = NULL;
+	sound_ptr->next_sound_ptr = global_sound_list;
+	if (global_sound_list)
+		global_sound_list->prev_sound_ptr = sound_ptr;
+	global_sound_list = sound_ptr;
+}
+
+//------------------------------------------------------------------------------
+// Remove a sound from the global sound list, and delete it along with its
+// sound buffer.
+//------------------------------------------------------------------------------
+
+static void
+remove_sound_from_global_list(sound *sound_ptr)
+{
+	if (sound_ptr->prev_sound_ptr)
+		sound_ptr->prev_sound_ptr->next_sound_ptr = sound_ptr->next_sound_ptr;
+	else
+		global_sound_list = sound_ptr->next_sound_ptr;
+	if (sound_ptr->next_sound_ptr)
+		sound_ptr->next_sound_ptr->prev_sound_ptr = sound_ptr->prev_sound_ptr;
+	destroy_sound_buffer(sound_ptr);
+	del_sound(sound_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Add a popup to the end of the global popup list.
+//------------------------------------------------------------------------------
+
+void
+add_popup_to_global_list(popup *popup_ptr)
+{
+	popup_ptr->prev_popup_ptr = last_global_popup_ptr;
+	popup_ptr->next_popup_ptr = NULL;
+	if (last_global_popup_ptr)
+		last_global_popup_ptr->next_popup_ptr = popup_ptr;
+	else
+		global_popup_list = popup_ptr;
+	last_global_popup_ptr = popup_ptr;
+}
+
+//------------------------------------------------------------------------------
+// Remove a popup from the global popup list, and delete it.
+//------------------------------------------------------------------------------
+
+static void
+remove_popup_from_global_list(popup *popup_ptr)
+{
+	if (popup_ptr->prev_popup_ptr)
+		popup_ptr->prev_popup_ptr->next_popup_ptr = popup_ptr->next_popup_ptr;
+	else
+		global_popup_list = popup_ptr->next_popup_ptr;
+	if (popup_ptr->next_popup_ptr)
+		popup_ptr->next_popup_ptr->prev_popup_ptr = popup_ptr->prev_popup_ptr;
+	else
+		last_global_popup_ptr = popup_ptr->prev_popup_ptr;
+	del_popup(popup_ptr);
+}
+
+//------------------------------------------------------------------------------
+// Initialise the state of a "step in", "step out" or "timer" trigger, and add
+// the trigger to the trigger index.
 //------------------------------------------------------------------------------
 
 void
@@ -1124,6 +1660,7 @@ init_global_trigger(trigger *trigger_ptr)
 	case TIMER:
 		set_trigger_delay(trigger_ptr, curr_time_ms);
 	}
+	index_global_trigger(trigger_ptr);
 }
 
 //------------------------------------------------------------------------------
@@ -1137,14 +1674,21 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 	hyperlink *exit_ptr;
 	trigger *trigger_ptr, *new_trigger_ptr;
 
-	// Store the block pointer, trigger flags and trigger list in the square.
+	// Store the block pointer in the square.  The square's block trigger flags
+	// and list are taken from the block definition.
 
 	square_ptr->block_ptr = block_ptr;
-	square_ptr->block_trigger_flags = block_def_ptr->trigger_flags;
-	square_ptr->block_trigger_list = block_def_ptr->trigger_list;
+
+	// Reset the block's references to the global objects it owns.
+
+	block_ptr->owned_trigger_list = NULL;
+	block_ptr->owned_light_ptr = NULL;
+	block_ptr->owned_sound_ptr = NULL;
+	block_ptr->owned_popup_ptr = NULL;
 
 	// If there is a light for this block definition, add a translated and
-	// scaled version to the global light list.
+	// scaled version to the global light list, and store a pointer to the
+	// light in the block.
 
 	if (block_def_ptr->light_ptr) {
 		light *light_ptr;
@@ -1156,9 +1700,8 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 			light_ptr->from_block = true;
 			light_ptr->pos = (light_ptr->pos + translation) *
 				world_ptr->block_scale;
-			light_ptr->next_light_ptr = global_light_list;
-			global_light_list = light_ptr;
-			global_lights++;
+			add_light_to_global_list(light_ptr);
+			block_ptr->owned_light_ptr = light_ptr;
 		}
 	}
 
@@ -1185,8 +1728,8 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 			// Add sound to global sound list, and set a flag to indicate that
 			// the global sound list has changed.
 
-			sound_ptr->next_sound_ptr = global_sound_list;
-			global_sound_list = sound_ptr;
+			add_sound_to_global_list(sound_ptr);
+			block_ptr->owned_sound_ptr = sound_ptr;
 			global_sound_list_changed = true;
 
 			// Create sound buffer, if sound is a non-streaming sound and the
@@ -1199,7 +1742,7 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 
 			// Increment the number of sounds on this square.
 
-			square_ptr->sounds++;
+			square_ptr->get_info_ptr()->sounds++;
 		}
 	}
 
@@ -1209,6 +1752,7 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 
 	if (block_def_ptr->popup_ptr) {
 		popup *popup_ptr;
+		square_info *square_info_ptr;
 
 		if ((popup_ptr = dup_popup(block_def_ptr->popup_ptr)) == NULL)
 			memory_warning("popup");
@@ -1220,28 +1764,25 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 			popup_ptr->from_block = true;
 			popup_ptr->position = (popup_ptr->position + translation) *
 				world_ptr->block_scale;
-			popup_ptr->next_popup_ptr = NULL;
 
 			// Add the popup to the end of the global popup list.
 
-			if (last_global_popup_ptr)
-				last_global_popup_ptr->next_popup_ptr = popup_ptr;
-			else
-				global_popup_list = popup_ptr;
-			last_global_popup_ptr = popup_ptr;
+			add_popup_to_global_list(popup_ptr);
+			block_ptr->owned_popup_ptr = popup_ptr;
 
 			// Add the popup to the end of the square's popup list.
 
-			if (square_ptr->last_popup_ptr)
-				square_ptr->last_popup_ptr->next_square_popup_ptr = 
+			square_info_ptr = square_ptr->get_info_ptr();
+			if (square_info_ptr->last_popup_ptr)
+				square_info_ptr->last_popup_ptr->next_square_popup_ptr = 
 					popup_ptr;
 			else
-				square_ptr->popup_list = popup_ptr;
-			square_ptr->last_popup_ptr = popup_ptr;
+				square_info_ptr->popup_list = popup_ptr;
+			square_info_ptr->last_popup_ptr = popup_ptr;
 
 			// Update the square's popup triggers.
 
-			square_ptr->popup_trigger_flags |= popup_ptr->trigger_flags;
+			square_info_ptr->popup_trigger_flags |= popup_ptr->trigger_flags;
 		}
 	}
 
@@ -1255,18 +1796,20 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 	// If there is an exit reference for this block definition, add it to the
 	// square if it doesn't already have one.
 
-	if (block_def_ptr->exit_ptr != NULL && square_ptr->exit_ptr == NULL) {
+	if (block_def_ptr->exit_ptr != NULL && 
+		square_ptr->info_ptr->exit_ptr == NULL) {
 		if ((exit_ptr = dup_hyperlink(block_def_ptr->exit_ptr)) == NULL)
 			memory_warning("exit");
 		else {
 			exit_ptr->from_block = true;
-			square_ptr->exit_ptr = exit_ptr;
+			square_ptr->get_info_ptr()->exit_ptr = exit_ptr;
 		}
 	}
 
 	// If there are "step in", "step out", "proximity", "timer" or "location"
 	// triggers for this block definition, add copies of them to the global
-	// trigger list and initialise their states.
+	// trigger list, initialise their states, and add them to the block's list
+	// of owned triggers.
 
 	trigger_ptr = block_def_ptr->trigger_list;
 	while (trigger_ptr) {
@@ -1276,8 +1819,12 @@ update_square(square *square_ptr, block_def *block_def_ptr, block *block_ptr,
 			trigger_ptr->trigger_flag == TIMER ||
 			trigger_ptr->trigger_flag == LOCATION) &&
 			(new_trigger_ptr = add_trigger_to_global_list(trigger_ptr,
-			 square_ptr, column, row, level, true)) != NULL)
+			 square_ptr, column, row, level, true)) != NULL) {
 			init_global_trigger(new_trigger_ptr);
+			new_trigger_ptr->next_owned_trigger_ptr = 
+				block_ptr->owned_trigger_list;
+			block_ptr->owned_trigger_list = new_trigger_ptr;
+		}
 		trigger_ptr = trigger_ptr->next_trigger_ptr;
 	}
 }
@@ -1394,6 +1941,21 @@ create_player_block(void)
 	return(true);
 }
 
+//------------------------------------------------------------------------------
+// Return the world position of a block's vertex.  A sprite has it's own vertex
+// list, but a structural block uses the vertices of it's block definition, 
+// scaled and translated into place.
+//------------------------------------------------------------------------------
+
+vertex
+get_block_vertex(block *block_ptr, int vertex_no)
+{
+	if (block_ptr->vertex_list)
+		return(block_ptr->vertex_list[vertex_no]);
+	return(block_ptr->block_def_ptr->vertex_list[vertex_no] * 
+		world_ptr->block_scale + block_ptr->translation);
+}
+
 //------------------------------------------------------------------------------
 // Determine if two polygons are identical (share the same vertices).
 //------------------------------------------------------------------------------
@@ -1411,18 +1973,17 @@ polygons_identical(block *block1_ptr, polygon *polygon1_ptr,
 	// Otherwise we must compare each vertex in polygon #1 with the vertices
 	// in polygon #2.  If all match, the polygons are identical.
 
-	vertex *vertex_list1 = block1_ptr->vertex_list;
-	vertex *vertex_list2 = block2_ptr->vertex_list;
 	vertex_def *vertex_def_list1 = polygon1_ptr->vertex_def_list;
 	vertex_def *vertex_def_list2 = polygon2_ptr->vertex_def_list;
 	bool total_match = true;
 	for (int index1 = 0; index1 < polygon1_ptr->vertices; index1++) {
-		vertex *vertex1_ptr = &vertex_list1[vertex_def_list1[index1].vertex_no];
+		vertex vertex1 = get_block_vertex(block1_ptr, 
+			vertex_def_list1[index1].vertex_no);
 		bool match = false;
 		for (int index2 = 0; index2 < polygon2_ptr->vertices; index2++) {
-			vertex *vertex2_ptr = 
-				&vertex_list2[vertex_def_list2[index2].vertex_no];
-			if (*vertex1_ptr == *vertex2_ptr) {
+			vertex vertex2 = get_block_vertex(block2_ptr, 
+				vertex_def_list2[index2].vertex_no);
+			if (vertex1 == vertex2) {
 				match = true;
 				break;
 			}
@@ -1450,8 +2011,8 @@ compute_active_polygons(block *block_ptr, int column, int row, int level,
 	int adj_direction;
 	int adj_column, adj_row, adj_level;
 	block *adj_block_ptr;
+	block_def *adj_block_def_ptr;
 	polygon *polygon_ptr, *adj_polygon_ptr;
-	bool *polygon_active_ptr, *adj_polygon_active_ptr;
 	part *part_ptr, *adj_part_ptr;
 	int polygon_no, adj_polygon_no;
 
@@ -1463,11 +2024,10 @@ compute_active_polygons(block *block_ptr, int column, int row, int level,
 	inactive_polygons = 0;
 	for (polygon_no = 0; polygon_no < block_ptr->polygons; polygon_no++) {
 		polygon_ptr = &block_ptr->polygon_list[polygon_no];
-		polygon_active_ptr = &block_ptr->polygon_active_list[polygon_no];
 		part_ptr = polygon_ptr->part_ptr;
 		switch (part_ptr->faces) {
 		case 0:
-			*polygon_active_ptr = false;
+			CLEAR_POLYGON_ACTIVE(block_ptr, polygon_no);
 			inactive_polygons++;
 			continue;
 		case 1:
@@ -1489,17 +2049,26 @@ compute_active_polygons(block *block_ptr, int column, int row, int level,
 		if (!adj_block_ptr)
 			continue;
 
-		// Step through the side polygons of the adjacent block that face
-		// towards the side polygon of the center block, and are one-sided.
+		// Make sure the side polygons of the adjacent block's definition have
+		// been hashed.
+
+		adj_block_def_ptr = adj_block_ptr->block_def_ptr;
+		if (!adj_block_def_ptr->side_polygons_indexed)
+			adj_block_def_ptr->index_side_polygons();
+
+		// Step through the side polygons of the adjacent block that have the
+		// same side key, face towards the side polygon of the center block,
+		// and are one-sided.
 
 		adj_direction = (polygon_ptr->direction + 3) % 6;
-		for (adj_polygon_no = 0; adj_polygon_no < adj_block_ptr->polygons;
-			adj_polygon_no++) {
+		adj_polygon_no = adj_block_def_ptr->side_polygon_bucket[
+			polygon_ptr->side_key & (SIDE_POLYGON_BUCKETS - 1)];
+		for (; adj_polygon_no >= 0; 
+			adj_polygon_no = adj_polygon_ptr->next_side_polygon_no) {
 			adj_polygon_ptr = &adj_block_ptr->polygon_list[adj_polygon_no];
-			adj_polygon_active_ptr = 
-				&adj_block_ptr->polygon_active_list[adj_polygon_no];
 			adj_part_ptr = adj_polygon_ptr->part_ptr;
-			if (adj_part_ptr->faces != 1 || !adj_polygon_ptr->side || 
+			if (adj_polygon_ptr->side_key != polygon_ptr->side_key ||
+				adj_part_ptr->faces != 1 || !adj_polygon_ptr->side || 
 				adj_polygon_ptr->direction != adj_direction)
 				continue;
 
@@ -1510,8 +2079,8 @@ compute_active_polygons(block *block_ptr, int column, int row, int level,
 
 			if (polygons_identical(block_ptr, polygon_ptr, adj_block_ptr,
 				adj_polygon_ptr)) {
-					*polygon_active_ptr = false;
-					*adj_polygon_active_ptr = false;
+					CLEAR_POLYGON_ACTIVE(block_ptr, polygon_no);
+					CLEAR_POLYGON_ACTIVE(adj_block_ptr, adj_polygon_no);
 					inactive_polygons += 2;
 				break;
 			}
@@ -1531,7 +2100,6 @@ reset_active_polygons(int column, int row, int level)
 	int adj_column, adj_row, adj_level;
 	block *adj_block_ptr;
 	polygon *adj_polygon_ptr;
-	bool *adj_polygon_active_ptr;
 	part *adj_part_ptr;
 	int adj_polygon_no;
 
@@ -1556,16 +2124,113 @@ reset_active_polygons(int column, int row, int level)
 		for (adj_polygon_no = 0; adj_polygon_no < adj_block_ptr->polygons;
 			adj_polygon_no++) {
 			adj_polygon_ptr = &adj_block_ptr->polygon_list[adj_polygon_no];
-			adj_polygon_active_ptr = 
-				&adj_block_ptr->polygon_active_list[adj_polygon_no];
 			adj_part_ptr = adj_polygon_ptr->part_ptr;
 			if (adj_polygon_ptr->side && adj_part_ptr->faces == 1 &&
 				adj_polygon_ptr->direction == adj_direction)
-				*adj_polygon_active_ptr = true;
+				SET_POLYGON_ACTIVE(adj_block_ptr, adj_polygon_no);
 		}
 	}
 }
 
+//------------------------------------------------------------------------------
+// Add a square to the dirty square list.  Returns FALSE if the list could not
+// be enlarged, in which case the caller must update the square immediately.
+//------------------------------------------------------------------------------
+
+static bool
+add_dirty_square(int column, int row, int level)
+{
+	mapcoords *new_dirty_square_list;
+	int index;
+
+	// If the dirty square list is full, double its size.
+
+	if (dirty_squares == max_dirty_squares) {
+		NEWARRAY(new_dirty_square_list, mapcoords, max_dirty_squares * 2 + 16);
+		if (new_dirty_square_list == NULL) {
+			memory_warning("dirty square list");
+			return(false);
+		}
+		for (index = 0; index < dirty_squares; index++)
+			new_dirty_square_list[index] = dirty_square_list[index];
+		if (dirty_square_list)
+			DELARRAY(dirty_square_list, mapcoords, max_dirty_squares);
+		dirty_square_list = new_dirty_square_list;
+		max_dirty_squares = max_dirty_squares * 2 + 16;
+	}
+
+	// Add the square to the end of the list.
+
+	dirty_square_list[dirty_squares++].set(column, row, level);
+	return(true);
+}
+
+//------------------------------------------------------------------------------
+// Begin a batch of block updates.  Until the batch ends, adding or removing a
+// fixed block only marks its square as dirty, rather than updating the active
+// polygons of the block and its neighbours.
+//------------------------------------------------------------------------------
+
+void
+begin_block_update_batch(void)
+{
+	batching_block_updates = true;
+	dirty_squares = 0;
+}
+
+//------------------------------------------------------------------------------
+// End a batch of block updates, and update the active polygons around every
+// dirty square once.
+//------------------------------------------------------------------------------
+
+void
+end_block_update_batch(void)
+{
+	mapcoords *coords_ptr;
+	block *block_ptr;
+	int index;
+
+	batching_block_updates = false;
+
+	// Reset the side polygons facing every dirty square first, so that a
+	// neighbour that was itself replaced during the batch is not reactivated
+	// after its hidden faces were computed.
+
+	for (index = 0; index < dirty_squares; index++) {
+		coords_ptr = &dirty_square_list[index];
+		reset_active_polygons(coords_ptr->column, coords_ptr->row,
+			coords_ptr->level);
+	}
+
+	// Now compute the active polygons of the block now occupying each dirty
+	// square, if there is one, and those of its neighbours.
+
+	for (index = 0; index < dirty_squares; index++) {
+		coords_ptr = &dirty_square_list[index];
+		block_ptr = world_ptr->get_block_ptr(coords_ptr->column, 
+			coords_ptr->row, coords_ptr->level);
+		if (block_ptr)
+			compute_active_polygons(block_ptr, coords_ptr->column, 
+				coords_ptr->row, coords_ptr->level, true);
+	}
+	dirty_squares = 0;
+}
+
+//------------------------------------------------------------------------------
+// Delete the dirty square list.
+//------------------------------------------------------------------------------
+
+void
+delete_dirty_square_list(void)
+{
+	if (dirty_square_list) {
+		DELARRAY(dirty_square_list, mapcoords, max_dirty_squares);
+		dirty_square_list = NULL;
+	}
+	dirty_squares = 0;
+	max_dirty_squares = 0;
+}
+
 //------------------------------------------------------------------------------
 // Add a new block to the map at the given location, using the given block
 // definition as the template.
@@ -1575,30 +2240,17 @@ void
 add_block(block_def *block_def_ptr, square *square_ptr, int column, int row,
 		  int level, bool update_active_polygons, bool check_for_entrance)
 {
-	entrance *entrance_ptr;
-	location *location_ptr;
 	vertex translation;
 	block *block_ptr;
 
-	// If the block definition does not permit an entrance, step through the
-	// global entrance list looking for an entrance on this square; if found,
-	// don't add this block.
-
-	if (check_for_entrance && !block_def_ptr->allow_entrance) {
-		entrance_ptr = global_entrance_list;
-		while (entrance_ptr) {
-			location_ptr = entrance_ptr->location_list;
-			while (location_ptr) {
-				if (column == location_ptr->column &&
-					row == location_ptr->row && level == location_ptr->level) {
-					warning("Block '%s' cannot be placed on an entrance "
-						"square", block_def_ptr->name);
-					return;
-				}
-				location_ptr = location_ptr->next_location_ptr;
-			}
-			entrance_ptr = entrance_ptr->next_entrance_ptr;
-		}
+	// If the block definition does not permit an entrance and there is an
+	// entrance on this square, don't add this block.
+
+	if (check_for_entrance && !block_def_ptr->allow_entrance &&
+		square_ptr->info_ptr->entrances > 0) {
+		warning("Block '%s' cannot be placed on an entrance square",
+			block_def_ptr->name);
+		return;
 	}
 	
 	// Compute the translation to place the new block at the given location on
@@ -1618,9 +2270,11 @@ add_block(block_def *block_def_ptr, square *square_ptr, int column, int row,
 			translation);
 
 	// If the active polygons of the new block and adjacent blocks must be
-	// updated, do so.
+	// updated, do so.  If a batch of block updates is in progress, a fixed
+	// block's square is just marked as dirty.
 
-	if (update_active_polygons)
+	if (update_active_polygons && (!batching_block_updates || 
+		block_def_ptr->movable || !add_dirty_square(column, row, level)))
 		compute_active_polygons(block_ptr, column, row, level, true);
 }
 
@@ -1633,11 +2287,10 @@ remove_block(square *square_ptr, int column, int row, int level)
 {
 	block_def *block_def_ptr;
 	block *block_ptr;
-	trigger *prev_trigger_ptr, *trigger_ptr;
-	light *prev_light_ptr, *light_ptr;
-	sound *prev_sound_ptr, *sound_ptr;
+	square_info *square_info_ptr;
+	trigger *trigger_ptr, *next_trigger_ptr;
 	popup *prev_popup_ptr, *popup_ptr;
-	entrance *prev_entrance_ptr, *entrance_ptr;
+	entrance *prev_entrance_ptr, *entrance_ptr, *next_entrance_ptr;
 
 	// Get a pointer to the block at this location.  If there is no block,
 	// there is nothing to do.
@@ -1645,170 +2298,118 @@ remove_block(square *square_ptr, int column, int row, int level)
 	block_ptr = square_ptr->block_ptr;
 	if (block_ptr == NULL)
 		return;
+	square_info_ptr = square_ptr->info_ptr;
 
-	// Reset the active polygons adjacent to this block.
+	// Reset the active polygons adjacent to this block, or mark the square as
+	// dirty if a batch of block updates is in progress.
 
-	reset_active_polygons(column, row, level);
+	if (!batching_block_updates || !add_dirty_square(column, row, level))
+		reset_active_polygons(column, row, level);
 
-	// Step through the global trigger list, and remove all triggers that came
-	// from this block.
+	// Remove all triggers, and the light and sound, that are owned by this
+	// block from the global lists.
 
-	prev_trigger_ptr = NULL;
-	trigger_ptr = global_trigger_list;
+	trigger_ptr = block_ptr->owned_trigger_list;
 	while (trigger_ptr) {
-		if (trigger_ptr->from_block && trigger_ptr->square_ptr == square_ptr) {
-			trigger_ptr->action_list = NULL;
-			trigger_ptr = del_trigger(trigger_ptr);
-			if (prev_trigger_ptr) {
-				prev_trigger_ptr->next_trigger_ptr = trigger_ptr;
-				if (trigger_ptr == NULL)
-					last_global_trigger_ptr = prev_trigger_ptr;
+		next_trigger_ptr = trigger_ptr->next_owned_trigger_ptr;
+		remove_trigger_from_global_list(trigger_ptr);
+		trigger_ptr = next_trigger_ptr;
+	}
+	block_ptr->owned_trigger_list = NULL;
+	if (block_ptr->owned_light_ptr) {
+		remove_light_from_global_list(block_ptr->owned_light_ptr);
+		block_ptr->owned_light_ptr = NULL;
+	}
+	if (block_ptr->owned_sound_ptr) {
+		remove_sound_from_global_list(block_ptr->owned_sound_ptr);
+		block_ptr->owned_sound_ptr = NULL;
+		square_info_ptr->sounds--;
+		global_sound_list_changed = true;
+	}
+
+	// If the square has a popup list, step through it and remove all popups
+	// that came from this block from the list (but don't delete them).  Then
+	// step through the popup list again and reinitialise the square's popup
+	// trigger flags.
+
+	if (square_info_ptr->popup_list) {
+		prev_popup_ptr = NULL;
+		popup_ptr = square_info_ptr->popup_list;
+		while (popup_ptr) {
+			if (popup_ptr->from_block && popup_ptr->square_ptr == square_ptr) {
+				popup_ptr = popup_ptr->next_square_popup_ptr;
+				if (prev_popup_ptr) {
+					prev_popup_ptr->next_square_popup_ptr = popup_ptr;
+					if (popup_ptr == NULL)
+						square_info_ptr->last_popup_ptr = prev_popup_ptr;
+				} else {
+					square_info_ptr->popup_list = popup_ptr;
+					if (popup_ptr == NULL)
+						square_info_ptr->last_popup_ptr = NULL;
+				}
 			} else {
-				global_trigger_list = trigger_ptr;
-				if (trigger_ptr == NULL)
-					last_global_trigger_ptr = NULL;
+				prev_popup_ptr = popup_ptr;
+				popup_ptr = popup_ptr->next_square_popup_ptr;
 			}
-		} else {
-			prev_trigger_ptr = trigger_ptr;
-			trigger_ptr = trigger_ptr->next_trigger_ptr;
 		}
-	}
-
-	// Step through the global light list, and remove all lights that came from
-	// this block.
-
-	prev_light_ptr = NULL;
-	light_ptr = global_light_list;
-	while (light_ptr) {
-		if (light_ptr->from_block && light_ptr->square_ptr == square_ptr) {
-			light_ptr = del_light(light_ptr);
-			global_lights--;
-			if (prev_light_ptr)
-				prev_light_ptr->next_light_ptr = light_ptr;
-			else
-				global_light_list = light_ptr;
-		} else {
-			prev_light_ptr = light_ptr;
-			light_ptr = light_ptr->next_light_ptr;
-		}
-	}
-
-	// Step through the global sound list, and remove all sounds that came from
-	// this block.
-
-	prev_sound_ptr = NULL;
-	sound_ptr = global_sound_list;
-	while (sound_ptr) {
-		if (sound_ptr->from_block && sound_ptr->square_ptr == square_ptr) {
-			destroy_sound_buffer(sound_ptr);
-			sound_ptr = del_sound(sound_ptr);
-			square_ptr->sounds--;
-			global_sound_list_changed = true;
-			if (prev_sound_ptr)
-				prev_sound_ptr->next_sound_ptr = sound_ptr;
-			else
-				global_sound_list = sound_ptr;
-		} else {
-			prev_sound_ptr = sound_ptr;
-			sound_ptr = sound_ptr->next_sound_ptr;
-		}
-	}
-
-	// Step through the square's popup list, and remove all popups that came
-	// from this block from the list (but don't delete them).
-
-	prev_popup_ptr = NULL;
-	popup_ptr = square_ptr->popup_list;
-	while (popup_ptr) {
-		if (popup_ptr->from_block && popup_ptr->square_ptr == square_ptr) {
-			popup_ptr = popup_ptr->next_square_popup_ptr;
-			if (prev_popup_ptr) {
-				prev_popup_ptr->next_square_popup_ptr = popup_ptr;
-				if (popup_ptr == NULL)
-					square_ptr->last_popup_ptr = prev_popup_ptr;
-			} else {
-				square_ptr->popup_list = popup_ptr;
-				if (popup_ptr == NULL)
-					square_ptr->last_popup_ptr = NULL;
-			}
-		} else {
-			prev_popup_ptr = popup_ptr;
+		square_info_ptr->popup_trigger_flags = 0;
+		popup_ptr = square_info_ptr->popup_list;
+		while (popup_ptr) {
+			square_info_ptr->popup_trigger_flags |= popup_ptr->trigger_flags;
 			popup_ptr = popup_ptr->next_square_popup_ptr;
 		}
 	}
 
-	// Step through the square's popup list again and reinitialise the square's
-	// popup trigger flags.
+	// Remove the popup owned by this block from the global popup list.
 
-	square_ptr->popup_trigger_flags = 0;
-	popup_ptr = square_ptr->popup_list;
-	while (popup_ptr) {
-		square_ptr->popup_trigger_flags |= popup_ptr->trigger_flags;
-		popup_ptr = popup_ptr->next_square_popup_ptr;
-	}
-
-	// Step through the global popup list, and remove all popups that came from
-	// this block.
-
-	prev_popup_ptr = NULL;
-	popup_ptr = global_popup_list;
-	while (popup_ptr) {
-		if (popup_ptr->from_block && popup_ptr->square_ptr == square_ptr) {
-			popup_ptr = del_popup(popup_ptr);
-			if (prev_popup_ptr) {
-				prev_popup_ptr->next_popup_ptr = popup_ptr;
-				if (popup_ptr == NULL)
-					last_global_popup_ptr = prev_popup_ptr;
-			} else {
-				global_popup_list = popup_ptr;
-				if (popup_ptr == NULL)
-					last_global_popup_ptr = NULL;
-			}
-		} else {
-			prev_popup_ptr = popup_ptr;
-			popup_ptr = popup_ptr->next_popup_ptr;
-		}
+	if (block_ptr->owned_popup_ptr) {
+		remove_popup_from_global_list(block_ptr->owned_popup_ptr);
+		block_ptr->owned_popup_ptr = NULL;
 	}
 
-	// Step through the global entrance list, and remove the entrance location
+	// If the block definition has an entrance, remove the entrance location
 	// that came from this block, if there is one.  Ignore the "default"
 	// entrance, however, as it's needed as a fallback.
 
-	prev_entrance_ptr = NULL;
-	entrance_ptr = global_entrance_list;
-	while (entrance_ptr) {
-		if (stricmp(entrance_ptr->name, "default") &&
-			entrance_ptr->del_location(column, row, level, true)) {
-			if (entrance_ptr->locations == 0) {
-				entrance_ptr = del_entrance(entrance_ptr);
-				if (prev_entrance_ptr)
-					prev_entrance_ptr->next_entrance_ptr = entrance_ptr;
-				else
-					global_entrance_list = entrance_ptr;
+	block_def_ptr = block_ptr->block_def_ptr;
+	if (strlen(block_def_ptr->entrance_name) != 0 &&
+		stricmp(block_def_ptr->entrance_name, "default") &&
+		(entrance_ptr = find_entrance(block_def_ptr->entrance_name)) != NULL &&
+		entrance_ptr->del_location(column, row, level, true)) {
+		square_info_ptr->entrances--;
+
+		// If the entrance has no locations left, remove it from the global
+		// entrance list.
+
+		if (entrance_ptr->locations == 0) {
+			prev_entrance_ptr = NULL;
+			next_entrance_ptr = global_entrance_list;
+			while (next_entrance_ptr != entrance_ptr) {
+				prev_entrance_ptr = next_entrance_ptr;
+				next_entrance_ptr = next_entrance_ptr->next_entrance_ptr;
 			}
-			break;
+			next_entrance_ptr = del_entrance(entrance_ptr);
+			if (prev_entrance_ptr)
+				prev_entrance_ptr->next_entrance_ptr = next_entrance_ptr;
+			else
+				global_entrance_list = next_entrance_ptr;
 		}
-		prev_entrance_ptr = entrance_ptr;
-		entrance_ptr = entrance_ptr->next_entrance_ptr;
 	}
 
 	// If there is an exit on the square that came from the block, remove it.
 
-	if (square_ptr->exit_ptr && square_ptr->exit_ptr->from_block) {
-		del_hyperlink(square_ptr->exit_ptr);
-		square_ptr->exit_ptr = NULL;
+	if (square_info_ptr->exit_ptr && square_info_ptr->exit_ptr->from_block) {
+		del_hyperlink(square_info_ptr->exit_ptr);
+		square_info_ptr->exit_ptr = NULL;
 	}
 
 	// Delete the block.
 
-	block_def_ptr = block_ptr->block_def_ptr;
 	block_def_ptr->del_block(block_ptr);
 
-	// Reset the block data in the square.
+	// Reset the block pointer in the square.
 
 	square_ptr->block_ptr = NULL;
-	square_ptr->block_trigger_flags = 0;
-	square_ptr->block_trigger_list = NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -65,6 +65,21 @@ add_imagemap(const char *name);
 bool
 check_for_popup_selection(popup *popup_ptr, int popup_width, int popup_height);
 
+bool
+schedule_timer_trigger(trigger *trigger_ptr);
+
+trigger *
+get_expired_timer_trigger(int curr_time_ms);
+
+int
+get_trigger_bucket(int column, int row, int level);
+
+bool
+add_trigger_ref(trigger_ref **trigger_ref_list_ptr, trigger *trigger_ptr);
+
+void
+delete_trigger_index(void);
+
 trigger *
 add_trigger_to_global_list(trigger *trigger_ptr, square *square_ptr, 
 						   int column, int row, int level, bool from_block);
@@ -72,9 +87,30 @@ add_trigger_to_global_list(trigger *trigger_ptr, square *square_ptr,
 void
 init_global_trigger(trigger *trigger_ptr);
 
+void
+add_light_to_global_list(light *light_ptr);
+
+void
+add_sound_to_global_list(sound *sound_ptr);
+
+void
+add_popup_to_global_list(popup *popup_ptr);
+
 void
 set_trigger_delay(trigger *trigger_ptr, int curr_time_ms);
 
+vertex
+get_block_vertex(block *block_ptr, int vertex_no);
+
+void
+begin_block_update_batch(void);
+
+void
+end_block_update_batch(void);
+
+void
+delete_dirty_square_list(void);
+
 void
 add_block(block_def *block_def_ptr, square *square_ptr, int column, int row,
 		  int level, bool update_active_polygons, bool check_for_entrance);
@@ -46,6 +46,7 @@
 #include "Parser.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Profile.h"
 #include "Real.h"
 #include "Render.h"
 #include "Spans.h"
@@ -412,6 +413,10 @@ static bool bind_sound_sources;
 static bool reflections_on;
 #else
 static LPDIRECTSOUND dsound_object_ptr;
+
+// Gain applied to a sound when a block lies between it and the player.
+
+#define OCCLUDED_SOUND_GAIN		0.5f
 #endif
 
 // Private streaming media data common to RealPlayer and WMP.
@@ -8366,6 +8371,30 @@ get_time_ms(void)
 	return(GetTickCount());
 }
 
+//------------------------------------------------------------------------------
+// Return the current value of the high resolution timer, and the number of
+// ticks it counts per second.
+//------------------------------------------------------------------------------
+
+__int64
+get_time_ticks(void)
+{
+	LARGE_INTEGER counter;
+
+	QueryPerformanceCounter(&counter);
+	return(counter.QuadPart);
+}
+
+__int64
+get_ticks_per_second(void)
+{
+	LARGE_INTEGER frequency;
+
+	if (!QueryPerformanceFrequency(&frequency))
+		return(1);
+	return(frequency.QuadPart);
+}
+
 //------------------------------------------------------------------------------
 // Load wave data into a wave object.
 //------------------------------------------------------------------------------
@@ -8864,8 +8893,9 @@ create_audio_block(int min_column, int min_row, int min_level,
 	square *square_ptr;
 	block *block_ptr;
 	int polygon_no, vertex_no;
-	bool *polygon_active_ptr;
 	polygon *polygon_ptr;
+	vertex_def *vertex_def_list;
+	vertex vertex0, vertex1, vertex2, vertex3;
 	vertex *vertex0_ptr, *vertex1_ptr, *vertex2_ptr, *vertex3_ptr;
 	float scale;
 
@@ -8888,7 +8918,7 @@ create_audio_block(int min_column, int min_row, int min_level,
 		for (row = min_row; row <= max_row; row++)
 			for (column = min_column; column <= max_column; column++) {
 				if ((square_ptr = world_ptr->get_square_ptr(column, row, level))
-					== NULL || square_ptr->sounds > 0 || (block_ptr = 
+					== NULL || square_ptr->info_ptr->sounds > 0 || (block_ptr = 
 					square_ptr->block_ptr) == NULL)
 					continue;
 
@@ -8897,23 +8927,29 @@ create_audio_block(int min_column, int min_row, int min_level,
 
 				for (polygon_no = 0; polygon_no < block_ptr->polygons;
 					polygon_no++) {
-					polygon_active_ptr = 
-						&block_ptr->polygon_active_list[polygon_no];
-					if (!*polygon_active_ptr)
+					if (!POLYGON_ACTIVE(block_ptr, polygon_no))
 						continue;
 					polygon_ptr = &block_ptr->polygon_list[polygon_no];
 
-					// If this polygon has four sides, add it as a quad.
+					// If this polygon has four sides, add it as a quad.  The
+					// block's vertices are fetched in world space.
 
-					PREPARE_VERTEX_LIST(block_ptr);
-					PREPARE_VERTEX_DEF_LIST(polygon_ptr);
-					vertex0_ptr = VERTEX_PTR(0);
+					vertex_def_list = polygon_ptr->vertex_def_list;
+					vertex0 = get_block_vertex(block_ptr, 
+						vertex_def_list[0].vertex_no);
+					vertex0_ptr = &vertex0;
+					vertex1_ptr = &vertex1;
+					vertex2_ptr = &vertex2;
+					vertex3_ptr = &vertex3;
 					if (polygon_ptr->vertices == 4) {
 						a3d_geometry_ptr->Begin(A3D_QUADS);
 						a3d_geometry_ptr->Tag(curr_audio_polygon_ID);
-						vertex1_ptr = VERTEX_PTR(1);
-						vertex2_ptr = VERTEX_PTR(2);
-						vertex3_ptr = VERTEX_PTR(3);
+						vertex1 = get_block_vertex(block_ptr, 
+							vertex_def_list[1].vertex_no);
+						vertex2 = get_block_vertex(block_ptr, 
+							vertex_def_list[2].vertex_no);
+						vertex3 = get_block_vertex(block_ptr, 
+							vertex_def_list[3].vertex_no);
 						a3d_geometry_ptr->Vertex3f(vertex0_ptr->x * scale, 
 							vertex0_ptr->y * scale, -vertex0_ptr->z * scale);
 						a3d_geometry_ptr->Vertex3f(vertex1_ptr->x * scale, 
@@ -8933,8 +8969,10 @@ create_audio_block(int min_column, int min_row, int min_level,
 						a3d_geometry_ptr->Tag(curr_audio_polygon_ID);
 						for (vertex_no = 2; vertex_no < polygon_ptr->vertices;
 							vertex_no++) {
-							vertex1_ptr = VERTEX_PTR(vertex_no - 1);
-							vertex2_ptr = VERTEX_PTR(vertex_no);
+							vertex1 = get_block_vertex(block_ptr, 
+								vertex_def_list[vertex_no - 1].vertex_no);
+							vertex2 = get_block_vertex(block_ptr, 
+								vertex_def_list[vertex_no].vertex_no);
 							a3d_geometry_ptr->Vertex3f(vertex0_ptr->x * scale, 
 								vertex0_ptr->y * scale, -vertex0_ptr->z * scale);
 							a3d_geometry_ptr->Vertex3f(vertex1_ptr->x * scale, 
@@ -9386,6 +9424,8 @@ update_sound(sound *sound_ptr)
 			else {
 				volume = 1.0f / (distance * sound_ptr->rolloff * 
 					world_ptr->audio_scale + 1.0f);
+				if (sound_ptr->occluded)
+					volume *= OCCLUDED_SOUND_GAIN;
 				set_sound_volume(sound_ptr, volume);
 			}
 
@@ -27,6 +27,7 @@
 #include "Parser.h"
 #include "Platform.h"
 #include "Plugin.h"
+#include "Render.h"
 
 #ifdef TRACE
 
@@ -56,10 +57,6 @@ static object object_list[MAX_OBJECTS];
 #endif // VERBOSE
 #endif // TRACE
 
-// Linked list of free spans.
-
-static span *free_span_list;
-
 // Screen polygon list, the last screen polygon in the list, and the
 // current screen polygon.
 
@@ -68,33 +65,66 @@ static spolygon *spolygon_list;
 static spolygon *last_spolygon_ptr;
 static spolygon *curr_spolygon_ptr;
 
-// Linked list of free triggers.
+// Objects managed by the free lists below are allocated in chunks, which
+// are only deleted when the spot is freed.
+
+#define OBJECTS_PER_CHUNK	64
+
+struct chunk {
+	void *object_list;
+	chunk *next_chunk_ptr;
+};
+
+// Spans are allocated in chunks that are reused every frame.  This is the list
+// of span chunks, the chunk that spans are currently being taken from, and the
+// index of the next span in that chunk.
+
+#define SPANS_PER_CHUNK		1024
+
+static chunk *span_chunk_list;
+static chunk *curr_span_chunk_ptr;
+static int next_span_index;
+
+// Linked list of free triggers, and the chunks they were allocated in.
 
 static trigger *free_trigger_list;
+static chunk *trigger_chunk_list;
+
+// Linked list of free trigger references, and the chunks they were allocated
+// in.
 
-// Linked list of free hyperlinks.
+static trigger_ref *free_trigger_ref_list;
+static chunk *trigger_ref_chunk_list;
+
+// Linked list of free hyperlinks, and the chunks they were allocated in.
 
 static hyperlink *free_hyperlink_list;
+static chunk *hyperlink_chunk_list;
 
-// Linked list of free lights.
+// Linked list of free lights, and the chunks they were allocated in.
 
 static light *free_light_list;
+static chunk *light_chunk_list;
 
-// Linked list of free sounds.
+// Linked list of free sounds, and the chunks they were allocated in.
 
 static sound *free_sound_list;
+static chunk *sound_chunk_list;
 
-// Linked list of free locations.
+// Linked list of free locations, and the chunks they were allocated in.
 
 static location *free_location_list;
+static chunk *location_chunk_list;
 
-// Linked list of free entrances.
+// Linked list of free entrances, and the chunks they were allocated in.
 
 static entrance *free_entrance_list;
+static chunk *entrance_chunk_list;
 
-// Linked list of free popups.
+// Linked list of free popups, and the chunks they were allocated in.
 
 static popup *free_popup_list;
+static chunk *popup_chunk_list;
 
 #ifdef TRACE
 
@@ -215,6 +245,14 @@ end_trace(void)
 
 #endif // TRACE
 
+#if defined(_DEBUG) && !defined(TRACE)
+
+// Count of allocations made via NEW and NEWARRAY.
+
+int heap_allocations;
+
+#endif
+
 //------------------------------------------------------------------------------
 // Free span list management.
 //------------------------------------------------------------------------------
@@ -224,21 +262,55 @@ end_trace(void)
 void
 init_free_span_list(void)
 {
-	free_span_list = NULL;
+	span_chunk_list = NULL;
+	curr_span_chunk_ptr = NULL;
+	next_span_index = 0;
 }
 
-// Delete the free span list.
+// Delete the free span list, by deleting every chunk of spans.
 
 void
 delete_free_span_list(void)
 {
-	span *next_span_ptr;
+	span *span_list;
+
+	while (span_chunk_list) {
+		span_list = (span *)span_chunk_list->object_list;
+		DELARRAY(span_list, span, SPANS_PER_CHUNK);
+		curr_span_chunk_ptr = span_chunk_list->next_chunk_ptr;
+		DEL(span_chunk_list, chunk);
+		span_chunk_list = curr_span_chunk_ptr;
+	}
+	next_span_index = 0;
+}
+
+// Reset the free span list at the start of a frame, so that every span
+// allocated during the previous frame is available again.
+
+void
+reset_free_span_list(void)
+{
+	curr_span_chunk_ptr = span_chunk_list;
+	next_span_index = 0;
+}
+
+// Return the number of spans allocated since the free span list was reset.
 
-	while (free_span_list) {
-		next_span_ptr = free_span_list->next_span_ptr;
-		DEL(free_span_list, span);
-		free_span_list = next_span_ptr;
+int
+spans_in_frame(void)
+{
+	chunk *chunk_ptr;
+	int spans;
+
+	if (curr_span_chunk_ptr == NULL)
+		return(0);
+	spans = next_span_index;
+	chunk_ptr = span_chunk_list;
+	while (chunk_ptr != curr_span_chunk_ptr) {
+		spans += SPANS_PER_CHUNK;
+		chunk_ptr = chunk_ptr->next_chunk_ptr;
 	}
+	return(spans);
 }
 
 // Return a pointer the next free span, or NULL if we are out of memory.
@@ -246,14 +318,41 @@ delete_free_span_list(void)
 span *
 new_span(void)
 {
-	span *span_ptr;
+	span *span_list;
+	chunk *chunk_ptr;
+
+	// If the current chunk has been used up, move on to the next chunk,
+	// allocating it if no previous frame has needed it.
+
+	if (curr_span_chunk_ptr == NULL || next_span_index == SPANS_PER_CHUNK) {
+		if (curr_span_chunk_ptr)
+			chunk_ptr = curr_span_chunk_ptr->next_chunk_ptr;
+		else
+			chunk_ptr = span_chunk_list;
+		if (chunk_ptr == NULL) {
+			NEWARRAY(span_list, span, SPANS_PER_CHUNK);
+			if (span_list == NULL)
+				return(NULL);
+			NEW(chunk_ptr, chunk);
+			if (chunk_ptr == NULL) {
+				DELARRAY(span_list, span, SPANS_PER_CHUNK);
+				return(NULL);
+			}
+			chunk_ptr->object_list = span_list;
+			chunk_ptr->next_chunk_ptr = NULL;
+			if (curr_span_chunk_ptr)
+				curr_span_chunk_ptr->next_chunk_ptr = chunk_ptr;
+			else
+				span_chunk_list = chunk_ptr;
+		}
+		curr_span_chunk_ptr = chunk_ptr;
+		next_span_index = 0;
+	}
 
-	span_ptr = free_span_list;
-	if (span_ptr)
-		free_span_list = span_ptr->next_span_ptr;
-	else
-		NEW(span_ptr, span);
-	return(span_ptr);
+	// Return the next span in the current chunk.
+
+	span_list = (span *)curr_span_chunk_ptr->object_list;
+	return(&span_list[next_span_index++]);
 }
 
 // Return a pointer the next free span, after initialising it with the old
@@ -270,16 +369,13 @@ dup_span(span *old_span_ptr)
 	return(span_ptr);
 }
 
-// Add the span to the head of the free span list, and return a pointer to the
-// next span.
+// Return a pointer to the next span.  The span itself is not freed until the
+// free span list is reset at the start of the next frame.
 
 span *
 del_span(span *span_ptr)
 {
-	span *next_span_ptr = span_ptr->next_span_ptr;
-	span_ptr->next_span_ptr = free_span_list;
-	free_span_list = span_ptr;
-	return(next_span_ptr);
+	return(span_ptr->next_span_ptr);
 }
 
 //------------------------------------------------------------------------------
@@ -328,9 +424,9 @@ reset_screen_polygon_list(void)
 spolygon *
 get_next_screen_polygon(void)
 {
-	// If hardware acceleration is enabled...
+	// If hardware acceleration or polygon binning is enabled...
 
-	if (hardware_acceleration) {
+	if (hardware_acceleration || polygon_binning_enabled) {
 		spolygon *spolygon_ptr;
 
 		// If we have not come to the end of the screen polygon list, get the
@@ -367,8 +463,8 @@ get_next_screen_polygon(void)
 		return(spolygon_ptr);
 	}
 
-	// If hardware acceleration is not enabled, simply return the same single
-	// screen polygon, creating it first if it doesn't yet exist.
+	// Otherwise simply return the same single screen polygon, creating it
+	// first if it doesn't yet exist.
 
 	else {
 		if (spolygon_list == NULL) {
@@ -383,6 +479,37 @@ get_next_screen_polygon(void)
 	}
 }
 
+//------------------------------------------------------------------------------
+// Chunk list management.
+//------------------------------------------------------------------------------
+
+// Add a chunk of objects to the front of the given chunk list.
+
+static bool
+add_chunk(chunk **chunk_list_ptr, void *object_list)
+{
+	chunk *chunk_ptr;
+
+	NEW(chunk_ptr, chunk);
+	if (chunk_ptr == NULL)
+		return(false);
+	chunk_ptr->object_list = object_list;
+	chunk_ptr->next_chunk_ptr = *chunk_list_ptr;
+	*chunk_list_ptr = chunk_ptr;
+	return(true);
+}
+
+// Delete a chunk record (but not the objects it refers to), and return a
+// pointer to the next chunk.
+
+static chunk *
+del_chunk(chunk *chunk_ptr)
+{
+	chunk *next_chunk_ptr = chunk_ptr->next_chunk_ptr;
+	DEL(chunk_ptr, chunk);
+	return(next_chunk_ptr);
+}
+
 //------------------------------------------------------------------------------
 // Free trigger list management.
 //------------------------------------------------------------------------------
@@ -393,21 +520,27 @@ void
 init_free_trigger_list(void)
 {
 	free_trigger_list = NULL;
+	trigger_chunk_list = NULL;
 }
 
-// Delete the free trigger list.
+// Delete the free trigger list, by deleting the chunks of triggers that were
+// allocated, whether or not the triggers in them are still in use.  The action
+// lists are shared with the original triggers, so they are not deleted.
 
 void
 delete_free_trigger_list(void)
 {
-	trigger *next_trigger_ptr;
-
-	while (free_trigger_list) {
-		next_trigger_ptr = free_trigger_list->next_trigger_ptr;
-		free_trigger_list->action_list = NULL;
-		DEL(free_trigger_list, trigger);
-		free_trigger_list = next_trigger_ptr;
+	trigger *trigger_list;
+	int index;
+
+	while (trigger_chunk_list) {
+		trigger_list = (trigger *)trigger_chunk_list->object_list;
+		for (index = 0; index < OBJECTS_PER_CHUNK; index++)
+			trigger_list[index].action_list = NULL;
+		DELARRAY(trigger_list, trigger, OBJECTS_PER_CHUNK);
+		trigger_chunk_list = del_chunk(trigger_chunk_list);
 	}
+	free_trigger_list = NULL;
 }
 
 // Return a pointer to the next free trigger, or NULL if we are out of memory.
@@ -415,13 +548,30 @@ delete_free_trigger_list(void)
 trigger *
 new_trigger(void)
 {
-	trigger *trigger_ptr;
+	trigger *trigger_list, *trigger_ptr;
+	int index;
+
+	// If there are no free triggers, allocate a chunk of them and add them
+	// to the free trigger list.
+
+	if (free_trigger_list == NULL) {
+		NEWARRAY(trigger_list, trigger, OBJECTS_PER_CHUNK);
+		if (trigger_list == NULL)
+			return(NULL);
+		if (!add_chunk(&trigger_chunk_list, trigger_list)) {
+			DELARRAY(trigger_list, trigger, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			trigger_list[index].next_trigger_ptr = free_trigger_list;
+			free_trigger_list = &trigger_list[index];
+		}
+	}
+
+	// Remove the first trigger from the free trigger list.
 
 	trigger_ptr = free_trigger_list;
-	if (trigger_ptr)
-		free_trigger_list = trigger_ptr->next_trigger_ptr;
-	else
-		NEW(trigger_ptr, trigger);
+	free_trigger_list = trigger_ptr->next_trigger_ptr;
 	return(trigger_ptr);
 }
 
@@ -451,6 +601,81 @@ del_trigger(trigger *trigger_ptr)
 	return(next_trigger_ptr);
 }
 
+//------------------------------------------------------------------------------
+// Free trigger reference list management.
+//------------------------------------------------------------------------------
+
+// Initialise the free trigger reference list.
+
+void
+init_free_trigger_ref_list(void)
+{
+	free_trigger_ref_list = NULL;
+	trigger_ref_chunk_list = NULL;
+}
+
+// Delete the free trigger reference list, by deleting the chunks of trigger
+// references that were allocated, whether or not the trigger references in them
+// are still in use.
+
+void
+delete_free_trigger_ref_list(void)
+{
+	trigger_ref *trigger_ref_list;
+
+	while (trigger_ref_chunk_list) {
+		trigger_ref_list = (trigger_ref *)trigger_ref_chunk_list->object_list;
+		DELARRAY(trigger_ref_list, trigger_ref, OBJECTS_PER_CHUNK);
+		trigger_ref_chunk_list = del_chunk(trigger_ref_chunk_list);
+	}
+	free_trigger_ref_list = NULL;
+}
+
+// Return a pointer to the next free trigger reference, or NULL if we are out
+// of memory.
+
+trigger_ref *
+new_trigger_ref(void)
+{
+	trigger_ref *trigger_ref_list, *trigger_ref_ptr;
+	int index;
+
+	// If there are no free trigger references, allocate a chunk of them and add
+	// them to the free trigger reference list.
+
+	if (free_trigger_ref_list == NULL) {
+		NEWARRAY(trigger_ref_list, trigger_ref, OBJECTS_PER_CHUNK);
+		if (trigger_ref_list == NULL)
+			return(NULL);
+		if (!add_chunk(&trigger_ref_chunk_list, trigger_ref_list)) {
+			DELARRAY(trigger_ref_list, trigger_ref, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			trigger_ref_list[index].next_trigger_ref_ptr = free_trigger_ref_list;
+			free_trigger_ref_list = &trigger_ref_list[index];
+		}
+	}
+
+	// Remove the first trigger reference from the free trigger reference list.
+
+	trigger_ref_ptr = free_trigger_ref_list;
+	free_trigger_ref_list = trigger_ref_ptr->next_trigger_ref_ptr;
+	return(trigger_ref_ptr);
+}
+
+// Add the trigger reference to the head of the free trigger reference list,
+// and return a pointer to the next trigger reference.
+
+trigger_ref *
+del_trigger_ref(trigger_ref *trigger_ref_ptr)
+{
+	trigger_ref *next_trigger_ref_ptr = trigger_ref_ptr->next_trigger_ref_ptr;
+	trigger_ref_ptr->next_trigger_ref_ptr = free_trigger_ref_list;
+	free_trigger_ref_list = trigger_ref_ptr;
+	return(next_trigger_ref_ptr);
+}
+
 //------------------------------------------------------------------------------
 // Free hyperlink list management.
 //------------------------------------------------------------------------------
@@ -461,20 +686,23 @@ void
 init_free_hyperlink_list(void)
 {
 	free_hyperlink_list = NULL;
+	hyperlink_chunk_list = NULL;
 }
 
-// Delete the free hyperlink list.
+// Delete the free hyperlink list, by deleting the chunks of hyperlinks that
+// were allocated, whether or not the hyperlinks in them are still in use.
 
 void
 delete_free_hyperlink_list(void)
 {
-	hyperlink *next_hyperlink_ptr;
+	hyperlink *hyperlink_list;
 
-	while (free_hyperlink_list) {
-		next_hyperlink_ptr = free_hyperlink_list->next_hyperlink_ptr;
-		DEL(free_hyperlink_list, hyperlink);
-		free_hyperlink_list = next_hyperlink_ptr;
+	while (hyperlink_chunk_list) {
+		hyperlink_list = (hyperlink *)hyperlink_chunk_list->object_list;
+		DELARRAY(hyperlink_list, hyperlink, OBJECTS_PER_CHUNK);
+		hyperlink_chunk_list = del_chunk(hyperlink_chunk_list);
 	}
+	free_hyperlink_list = NULL;
 }
 
 // Return a pointer to the next free hyperlink, or NULL if we are out of memory.
@@ -482,13 +710,30 @@ delete_free_hyperlink_list(void)
 hyperlink *
 new_hyperlink(void)
 {
-	hyperlink *hyperlink_ptr;
+	hyperlink *hyperlink_list, *hyperlink_ptr;
+	int index;
+
+	// If there are no free hyperlinks, allocate a chunk of them and add them
+	// to the free hyperlink list.
+
+	if (free_hyperlink_list == NULL) {
+		NEWARRAY(hyperlink_list, hyperlink, OBJECTS_PER_CHUNK);
+		if (hyperlink_list == NULL)
+			return(NULL);
+		if (!add_chunk(&hyperlink_chunk_list, hyperlink_list)) {
+			DELARRAY(hyperlink_list, hyperlink, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			hyperlink_list[index].next_hyperlink_ptr = free_hyperlink_list;
+			free_hyperlink_list = &hyperlink_list[index];
+		}
+	}
+
+	// Remove the first hyperlink from the free hyperlink list.
 
 	hyperlink_ptr = free_hyperlink_list;
-	if (hyperlink_ptr)
-		free_hyperlink_list = hyperlink_ptr->next_hyperlink_ptr;
-	else
-		NEW(hyperlink_ptr, hyperlink);
+	free_hyperlink_list = hyperlink_ptr->next_hyperlink_ptr;
 	return(hyperlink_ptr);
 }
 
@@ -528,20 +773,23 @@ void
 init_free_light_list(void)
 {
 	free_light_list = NULL;
+	light_chunk_list = NULL;
 }
 
-// Delete the free light list.
+// Delete the free light list, by deleting the chunks of lights that were
+// allocated, whether or not the lights in them are still in use.
 
 void
 delete_free_light_list(void)
 {
-	light *next_light_ptr;
+	light *light_list;
 
-	while (free_light_list) {
-		next_light_ptr = free_light_list->next_light_ptr;
-		DEL(free_light_list, light);
-		free_light_list = next_light_ptr;
+	while (light_chunk_list) {
+		light_list = (light *)light_chunk_list->object_list;
+		DELARRAY(light_list, light, OBJECTS_PER_CHUNK);
+		light_chunk_list = del_chunk(light_chunk_list);
 	}
+	free_light_list = NULL;
 }
 
 // Return a pointer to the next free light, or NULL if we are out of memory.
@@ -549,13 +797,30 @@ delete_free_light_list(void)
 light *
 new_light(void)
 {
-	light *light_ptr;
+	light *light_list, *light_ptr;
+	int index;
+
+	// If there are no free lights, allocate a chunk of them and add them
+	// to the free light list.
+
+	if (free_light_list == NULL) {
+		NEWARRAY(light_list, light, OBJECTS_PER_CHUNK);
+		if (light_list == NULL)
+			return(NULL);
+		if (!add_chunk(&light_chunk_list, light_list)) {
+			DELARRAY(light_list, light, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			light_list[index].next_light_ptr = free_light_list;
+			free_light_list = &light_list[index];
+		}
+	}
+
+	// Remove the first light from the free light list.
 
 	light_ptr = free_light_list;
-	if (light_ptr)
-		free_light_list = light_ptr->next_light_ptr;
-	else
-		NEW(light_ptr, light);
+	free_light_list = light_ptr->next_light_ptr;
 	return(light_ptr);
 }
 
@@ -595,20 +860,23 @@ void
 init_free_sound_list(void)
 {
 	free_sound_list = NULL;
+	sound_chunk_list = NULL;
 }
 
-// Delete the free sound list.
+// Delete the free sound list, by deleting the chunks of sounds that were
+// allocated, whether or not the sounds in them are still in use.
 
 void
 delete_free_sound_list(void)
 {
-	sound *next_sound_ptr;
+	sound *sound_list;
 
-	while (free_sound_list) {
-		next_sound_ptr = free_sound_list->next_sound_ptr;
-		DEL(free_sound_list, sound);
-		free_sound_list = next_sound_ptr;
+	while (sound_chunk_list) {
+		sound_list = (sound *)sound_chunk_list->object_list;
+		DELARRAY(sound_list, sound, OBJECTS_PER_CHUNK);
+		sound_chunk_list = del_chunk(sound_chunk_list);
 	}
+	free_sound_list = NULL;
 }
 
 // Return a pointer to the next free sound, or NULL if we are out of memory.
@@ -616,13 +884,30 @@ delete_free_sound_list(void)
 sound *
 new_sound(void)
 {
-	sound *sound_ptr;
+	sound *sound_list, *sound_ptr;
+	int index;
+
+	// If there are no free sounds, allocate a chunk of them and add them
+	// to the free sound list.
+
+	if (free_sound_list == NULL) {
+		NEWARRAY(sound_list, sound, OBJECTS_PER_CHUNK);
+		if (sound_list == NULL)
+			return(NULL);
+		if (!add_chunk(&sound_chunk_list, sound_list)) {
+			DELARRAY(sound_list, sound, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			sound_list[index].next_sound_ptr = free_sound_list;
+			free_sound_list = &sound_list[index];
+		}
+	}
+
+	// Remove the first sound from the free sound list.
 
 	sound_ptr = free_sound_list;
-	if (sound_ptr)
-		free_sound_list = sound_ptr->next_sound_ptr;
-	else
-		NEW(sound_ptr, sound);
+	free_sound_list = sound_ptr->next_sound_ptr;
 	return(sound_ptr);
 }
 
@@ -662,20 +947,23 @@ void
 init_free_location_list(void)
 {
 	free_location_list = NULL;
+	location_chunk_list = NULL;
 }
 
-// Delete the free location list.
+// Delete the free location list, by deleting the chunks of locations that were
+// allocated, whether or not the locations in them are still in use.
 
 void
 delete_free_location_list(void)
 {
-	location *next_location_ptr;
+	location *location_list;
 
-	while (free_location_list) {
-		next_location_ptr = free_location_list->next_location_ptr;
-		DEL(free_location_list, location);
-		free_location_list = next_location_ptr;
+	while (location_chunk_list) {
+		location_list = (location *)location_chunk_list->object_list;
+		DELARRAY(location_list, location, OBJECTS_PER_CHUNK);
+		location_chunk_list = del_chunk(location_chunk_list);
 	}
+	free_location_list = NULL;
 }
 
 // Return a pointer to the next free location, or NULL if we are out of memory.
@@ -683,13 +971,30 @@ delete_free_location_list(void)
 location *
 new_location(void)
 {
-	location *location_ptr;
+	location *location_list, *location_ptr;
+	int index;
+
+	// If there are no free locations, allocate a chunk of them and add them
+	// to the free location list.
+
+	if (free_location_list == NULL) {
+		NEWARRAY(location_list, location, OBJECTS_PER_CHUNK);
+		if (location_list == NULL)
+			return(NULL);
+		if (!add_chunk(&location_chunk_list, location_list)) {
+			DELARRAY(location_list, location, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			location_list[index].next_location_ptr = free_location_list;
+			free_location_list = &location_list[index];
+		}
+	}
+
+	// Remove the first location from the free location list.
 
 	location_ptr = free_location_list;
-	if (location_ptr)
-		free_location_list = location_ptr->next_location_ptr;
-	else
-		NEW(location_ptr, location);
+	free_location_list = location_ptr->next_location_ptr;
 	return(location_ptr);
 }
 
@@ -715,20 +1020,23 @@ void
 init_free_entrance_list(void)
 {
 	free_entrance_list = NULL;
+	entrance_chunk_list = NULL;
 }
 
-// Delete the free entrance list.
+// Delete the free entrance list, by deleting the chunks of entrances that were
+// allocated, whether or not the entrances in them are still in use.
 
 void
 delete_free_entrance_list(void)
 {
-	entrance *next_entrance_ptr;
+	entrance *entrance_list;
 
-	while (free_entrance_list) {
-		next_entrance_ptr = free_entrance_list->next_entrance_ptr;
-		DEL(free_entrance_list, entrance);
-		free_entrance_list = next_entrance_ptr;
+	while (entrance_chunk_list) {
+		entrance_list = (entrance *)entrance_chunk_list->object_list;
+		DELARRAY(entrance_list, entrance, OBJECTS_PER_CHUNK);
+		entrance_chunk_list = del_chunk(entrance_chunk_list);
 	}
+	free_entrance_list = NULL;
 }
 
 // Return a pointer to the next free entrance, or NULL if we are out of memory.
@@ -736,13 +1044,30 @@ delete_free_entrance_list(void)
 entrance *
 new_entrance(void)
 {
-	entrance *entrance_ptr;
+	entrance *entrance_list, *entrance_ptr;
+	int index;
+
+	// If there are no free entrances, allocate a chunk of them and add them
+	// to the free entrance list.
+
+	if (free_entrance_list == NULL) {
+		NEWARRAY(entrance_list, entrance, OBJECTS_PER_CHUNK);
+		if (entrance_list == NULL)
+			return(NULL);
+		if (!add_chunk(&entrance_chunk_list, entrance_list)) {
+			DELARRAY(entrance_list, entrance, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			entrance_list[index].next_entrance_ptr = free_entrance_list;
+			free_entrance_list = &entrance_list[index];
+		}
+	}
+
+	// Remove the first entrance from the free entrance list.
 
 	entrance_ptr = free_entrance_list;
-	if (entrance_ptr)
-		free_entrance_list = entrance_ptr->next_entrance_ptr;
-	else
-		NEW(entrance_ptr, entrance);
+	free_entrance_list = entrance_ptr->next_entrance_ptr;
 	return(entrance_ptr);
 }
 
@@ -768,20 +1093,23 @@ void
 init_free_popup_list(void)
 {
 	free_popup_list = NULL;
+	popup_chunk_list = NULL;
 }
 
-// Delete the free popup list.
+// Delete the free popup list, by deleting the chunks of popups that were
+// allocated, whether or not the popups in them are still in use.
 
 void
 delete_free_popup_list(void)
 {
-	popup *next_popup_ptr;
+	popup *popup_list;
 
-	while (free_popup_list) {
-		next_popup_ptr = free_popup_list->next_popup_ptr;
-		DEL(free_popup_list, popup);
-		free_popup_list = next_popup_ptr;
+	while (popup_chunk_list) {
+		popup_list = (popup *)popup_chunk_list->object_list;
+		DELARRAY(popup_list, popup, OBJECTS_PER_CHUNK);
+		popup_chunk_list = del_chunk(popup_chunk_list);
 	}
+	free_popup_list = NULL;
 }
 
 // Return a pointer to the next free popup, or NULL if we are out of memory.
@@ -789,13 +1117,30 @@ delete_free_popup_list(void)
 popup *
 new_popup(void)
 {
-	popup *popup_ptr;
+	popup *popup_list, *popup_ptr;
+	int index;
+
+	// If there are no free popups, allocate a chunk of them and add them
+	// to the free popup list.
+
+	if (free_popup_list == NULL) {
+		NEWARRAY(popup_list, popup, OBJECTS_PER_CHUNK);
+		if (popup_list == NULL)
+			return(NULL);
+		if (!add_chunk(&popup_chunk_list, popup_list)) {
+			DELARRAY(popup_list, popup, OBJECTS_PER_CHUNK);
+			return(NULL);
+		}
+		for (index = OBJECTS_PER_CHUNK - 1; index >= 0; index--) {
+			popup_list[index].next_popup_ptr = free_popup_list;
+			free_popup_list = &popup_list[index];
+		}
+	}
+
+	// Remove the first popup from the free popup list.
 
 	popup_ptr = free_popup_list;
-	if (popup_ptr)
-		free_popup_list = popup_ptr->next_popup_ptr;
-	else
-		NEW(popup_ptr, popup);
+	free_popup_list = popup_ptr->next_popup_ptr;
 	return(popup_ptr);
 }
 
@@ -44,6 +44,17 @@
 	delete []ptr; \
 }
 
+#elif defined(_DEBUG)
+
+// In debug builds, count every allocation made via NEW and NEWARRAY, so that
+// the frame loop can check that it isn't touching the heap.
+
+#define NEW(ptr, type)					ptr = new type, heap_allocations++
+#define NEWARRAY(ptr, type, elements)	ptr = new type[elements], \
+										heap_allocations++
+#define DEL(ptr, type)					delete ptr
+#define DELARRAY(ptr, type, elements)	delete []ptr
+
 #else
 
 #define NEW(ptr, type)					ptr = new type
@@ -53,6 +64,14 @@
 
 #endif
 
+#if defined(_DEBUG) && !defined(TRACE)
+
+// Count of allocations made via NEW and NEWARRAY.
+
+extern int heap_allocations;
+
+#endif
+
 #ifdef TRACE
 
 // Functions for tracing memory allocations and frees.
@@ -77,7 +96,7 @@ end_trace();
 
 #endif
 
-// Functions for managing free spans.
+// Functions for managing spans, which only live for a single frame.
 
 void
 init_free_span_list(void);
@@ -85,6 +104,12 @@ init_free_span_list(void);
 void
 delete_free_span_list(void);
 
+void
+reset_free_span_list(void);
+
+int
+spans_in_frame(void);
+
 span *
 new_span(void);
 
@@ -128,6 +153,20 @@ dup_trigger(trigger *old_trigger_ptr);
 trigger *
 del_trigger(trigger *trigger_ptr);
 
+// Functions for managing free trigger references.
+
+void
+init_free_trigger_ref_list(void);
+
+void
+delete_free_trigger_ref_list(void);
+
+trigger_ref *
+new_trigger_ref(void);
+
+trigger_ref *
+del_trigger_ref(trigger_ref *trigger_ref_ptr);
+
 // Functions for managing free hyperlinks.
 
 void